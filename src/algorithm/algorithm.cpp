@@ -113,6 +113,7 @@ namespace GTServer {
             tile.SetParent(0);
             tile.RemoveFlag(TILEFLAG_LOCKED);
             tile.ClearAccess();
+            world->MarkDirty(tile.GetPosition());
         }
 
         while (nodes.size() < lock_size) {	
@@ -205,6 +206,7 @@ done:;
             for (auto& user_id : start_tile->GetAccessList()) {
                 tile->AddAccess(user_id);
             }
+            world->MarkDirty(pos);
 
             buffer.write<uint16_t>(pos.m_x + pos.m_y * world->GetSize().m_x);
         }
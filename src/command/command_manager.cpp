@@ -295,6 +295,12 @@ namespace GTServer {
             PLAYER_ROLE_MODERATOR,
             std::function<void(const CommandContext&)> { [this](auto&& PH1) { this->command_invis(std::forward<decltype(PH1)>(PH1)); } }
 } });
+        m_commands.insert({ "memory", new Command {
+            "memory", { "mem" },
+            "`oInfo >> memory usage of worlds, players, items and render caches.``",
+            PLAYER_ROLE_DEVELOPER,
+            std::function<void(const CommandContext&)> { [this](auto&& PH1) { this->command_memory(std::forward<decltype(PH1)>(PH1)); } }
+        } });
 
         fmt::print(" - {} commands registered.\n", m_commands.size());
     }
@@ -63,6 +63,7 @@ namespace GTServer {
         void command_clearworld(const CommandContext& ctx);
 
         void command_invis(const CommandContext& ctx);
+        void command_memory(const CommandContext& ctx);
 
     private:
         std::unordered_map<std::string, Command*> m_commands{};
@@ -5,7 +5,10 @@
 #include <command/command.h>
 #include <world/world_pool.h>
 #include <database/database.h>
+#include <database/kv_store.h>
 #include <render/world_render.h>
+#include <server/cluster_client.h>
+#include <server/memory_report.h>
 #include <proton/utils/dialog_builder.h>
 #include <utils/timing_clock.h>
 #include <iostream>
@@ -25,7 +28,7 @@ namespace GTServer {
                 item->m_max_amount - ((receiver->m_inventory.GetItemCount(item_id) + count) - count));
             return;
         }
-        if (receiver->m_inventory.GetItems().size() >= receiver->m_inventory.GetSize() ||
+        if (receiver->m_inventory.GetUsedSlots() >= receiver->m_inventory.GetSize() ||
             !receiver->m_inventory.Add(item_id, count, true)) {
             invoker->SendLog("`4Oops, `w{}`` doesn't have enough free space in his/her inventory.``", receiver->GetDisplayName(world));
             return;
@@ -221,6 +224,11 @@ namespace GTServer {
             ctx.m_player->SendLog("`4Oops! `oyou've to enter at least first `w3 `ocharacters of item's name, this is not clear enough to find.");
             return;
         }
+        steady_clock::duration wait{};
+        if (ctx.m_player->m_rate_limiter.Check(RATE_CLASS_SEARCH, wait) != RATE_ACTION_ALLOW) {
+            ctx.m_player->SendLog("`4Oops! `oyou're searching too fast, try again in `w{}`` seconds.", std::chrono::ceil<std::chrono::seconds>(wait).count());
+            return;
+        }
         ctx.m_servers->AddQueue(QUEUE_TYPE_FINDING_ITEMS, ServerQueue {
             .m_keyword = keyword,
             .m_player = ctx.m_player
@@ -230,11 +238,11 @@ namespace GTServer {
         auto world{ ctx.m_server->GetWorldPool()->GetWorld(ctx.m_player->GetWorld()) };
         if (!world)
             return;
-        std::size_t items_count = ctx.m_player->m_inventory.GetItems().size() - 2;
+        std::size_t items_count = ctx.m_player->m_inventory.GetUsedSlots() - 2;
         if (items_count < 1)
             return;
-        for (auto& [id, count] : ctx.m_player->m_inventory.GetItems()) {
-            if (id == ITEM_FIST || id == ITEM_WRENCH)
+        for (const auto [id, count] : ctx.m_player->m_inventory.GetItems()) {
+            if (count == 0 || id == ITEM_FIST || id == ITEM_WRENCH)
                 continue;
             ItemInfo* item = ItemDatabase::GetItem(id);
             if (!item)
@@ -260,6 +268,11 @@ namespace GTServer {
             ctx.m_player->SendLog("`4Oops! `oyou've to enter at least first `w3 `ocharacters of player's name, this is not clear enough to find.");
             return;
         }
+        steady_clock::duration wait{};
+        if (ctx.m_player->m_rate_limiter.Check(RATE_CLASS_SEARCH, wait) != RATE_ACTION_ALLOW) {
+            ctx.m_player->SendLog("`4Oops! `oyou're searching too fast, try again in `w{}`` seconds.", std::chrono::ceil<std::chrono::seconds>(wait).count());
+            return;
+        }
         ctx.m_servers->AddQueue(QUEUE_TYPE_FINDING_PLAYERS, ServerQueue {
             .m_keyword = keyword,
             .m_player = ctx.m_player
@@ -350,6 +363,7 @@ namespace GTServer {
             else {
                 t.ApplyLockOwner(person->GetUserId());
             }
+            world->MarkDirty(t.GetPosition());
         }
         world->Broadcast([&](const std::shared_ptr<Player>& ply) {
             if (!person->HasPlaymod(PLAYMOD_TYPE_INVISIBLE)) {
@@ -452,40 +466,12 @@ namespace GTServer {
         }
 
 
-        std::string file_path = "GlobalGameVariables.txt";
-
-        if (!fs::exists(file_path)) {
-            return; // File does not exist, do nothing
-        }
-
-        std::ifstream infile(file_path);
-        std::string line;
-        std::vector<std::string> lines;
-        bool found_recent_sb_location = false;
-        while (std::getline(infile, line)) {
-            if (line.find("RecentSBLocation:") == 0) {
-                lines.push_back(std::format("RecentSBLocation: {}", world->GetName()));
-                found_recent_sb_location = true;
-            }
-            else {
-                lines.push_back(line);
-            }
-        }
-        infile.close();
-
-        if (!found_recent_sb_location) {
-            lines.push_back(std::format("RecentSBLocation: {}", world->GetName()));
-        }
-
-        std::ofstream outfile(file_path);
-        for (const auto& line : lines) {
-            outfile << line << std::endl;
-        }
-        outfile.close();
+        KeyValueStore::Get().Put(StoreKey::global("RecentSBLocation"), world->GetName());
 
-        for (auto& player2 : ctx.m_servers->GetPlayers()) {
-            player2->SendLog(std::format("`w** `5Super-Broadcast `wfrom {} `w(in {}) `w** : {}", player->GetDisplayName(), world->GetName(), message));
-        }
+        const std::string broadcast{ std::format("`w** `5Super-Broadcast `wfrom {} `w(in {}) `w** : {}", player->GetDisplayName(), world->GetName(), message) };
+        for (auto& player2 : ctx.m_servers->GetPlayers())
+            player2->SendLog("{}", broadcast);
+        ClusterClient::Get().Broadcast(broadcast);
     }
     void CommandManager::command_go(const CommandContext& ctx) {
         auto world{ ctx.m_servers->GetWorld(ctx.m_player->GetWorld()) };
@@ -494,19 +480,7 @@ namespace GTServer {
 
         std::shared_ptr<Player> player = ctx.m_player;
 
-        // Get the RecentSBLocation from the GlobalGameVariables.txt file
-        std::string recent_sb_location = "";
-        std::ifstream file("GlobalGameVariables.txt");
-        if (file.is_open()) {
-            std::string line;
-            while (getline(file, line)) {
-                if (line.find("RecentSBLocation:") != std::string::npos) {
-                    recent_sb_location = line.substr(line.find(":") + 2);
-                    break;
-                }
-            }
-            file.close();
-        }
+        const std::string recent_sb_location{ KeyValueStore::Get().Find(StoreKey::global("RecentSBLocation")).value_or("") };
         auto world2{ ctx.m_server->GetWorldPool()->GetWorld(recent_sb_location) };
         if (world2->IsFlagOn(WORLDFLAG_NUKED) && player->GetRole() < PLAYER_ROLE_MODERATOR) {
             player->SendLog("You can't warp there, sorry!");
@@ -612,6 +586,7 @@ namespace GTServer {
         for (auto& t : world->GetTiles()) {
             if (t.GetBaseItem()->m_item_type != ITEMTYPE_LOCK && t.HasAccess(player->GetUserId())) {
                 t.RemoveAccess(player->GetUserId());
+                world->MarkDirty(t.GetPosition());
             }
         }
         world->SyncPlayerData(player);
@@ -681,66 +656,7 @@ namespace GTServer {
         }
         player->v_sender.OnTextOverlay("`wYou change your nickname.``");
         player->SetDisplayName(new_display_name);
-        std::string folder_path = fmt::format("PlayerData/{}", ctx.m_player->GetRawName());
-        std::string file_name = "PlayerData.txt";
-        std::string file_path = folder_path + "/" + file_name;
-
-        if (!fs::is_directory(folder_path)) {
-            fs::create_directory(folder_path);
-        }
-        if (!fs::exists(file_path)) {
-            std::ofstream outfile(file_path);
-            outfile.close();
-        }
-
-        std::ifstream infile(file_path);
-        std::string line;
-        std::string custom_nickname;
-        bool custom_nickname_found = false;
-        while (std::getline(infile, line)) {
-            if (line.find("CustomNickname:") == 0) {
-                custom_nickname = line.substr(15);
-                custom_nickname_found = true;
-                break;
-            }
-        }
-        infile.close();
-
-        if (!custom_nickname_found) {
-            std::ofstream outfile(file_path, std::ios::app);
-            outfile << "CustomNickname: " << new_display_name << std::endl;
-            outfile.close();
-            custom_nickname = new_display_name;
-        }
-        else {
-            std::ifstream infile(file_path);
-            std::stringstream buffer;
-            std::string line;
-            while (std::getline(infile, line)) {
-                if (line.find("CustomNickname:") == 0) {
-                    buffer << "CustomNickname: " << new_display_name << std::endl;
-                }
-                else {
-                    buffer << line << std::endl;
-                }
-            }
-            infile.close();
-
-            std::ofstream outfile(file_path);
-            outfile << buffer.str();
-            outfile.close();
-
-            custom_nickname = new_display_name;
-        }
-
-        infile.open(file_path);
-        while (std::getline(infile, line)) {
-            if (line.find("CustomNickname:") == 0) {
-                custom_nickname = line.substr(15);
-                break;
-            }
-        }
-        infile.close();
+        KeyValueStore::Get().Put(StoreKey::nickname(ctx.m_player->GetRawName()), new_display_name);
         if (!player->HasPlaymod(PLAYMOD_TYPE_NICK)) {
             player->AddPlaymod(PLAYMOD_TYPE_NICK, ITEM_TROLL_MASK, steady_clock::now(), std::chrono::seconds(-1));
         }
@@ -907,13 +823,10 @@ namespace GTServer {
             return;
         }
         else {
-            world->RemovePlayer(player);
-            ctx.m_server->GetWorldPool()->OnPlayerLeave(world, player, false);
-            // player->SetNetId(world2->AddPlayer(player));
-            player->SendLog("You warped to `w{}`o.", new_display_name);
-            ctx.m_server->GetWorldPool()->OnPlayerJoin(ctx.m_servers, world2, player, world2->GetTilePos(ITEMTYPE_MAIN_DOOR));
-            ctx.m_server->GetWorldPool()->OnPlayerSyncing(world2, player);
-            ctx.m_player->PlaySfx("object_spawn", 0);
+            ctx.m_server->GetWorldPool()->MovePlayer(ctx.m_servers, player, world, world2, [player, new_display_name](const std::shared_ptr<World>&) {
+                player->SendLog("You warped to `w{}`o.", new_display_name);
+                player->PlaySfx("object_spawn", 0);
+            });
         }
     }
     void CommandManager::command_summon(const CommandContext& ctx) {
@@ -931,18 +844,13 @@ namespace GTServer {
             if (targetname == new_display_name) {
                 std::shared_ptr<WorldPool> world_pool{ ctx.m_server->GetWorldPool() };
                 std::shared_ptr<World> world2{ world_pool->GetWorld(playerthing->GetWorld()) };
-                if (world2) {
-                    world2->RemovePlayer(playerthing);
-                    ctx.m_server->GetWorldPool()->OnPlayerLeave(world2, playerthing, false);
+                if (world2)
                     ctx.m_player->PlaySfx("object_spawn", 0);
-                }
-                // player->SetNetId(world2->AddPlayer(player));
-                // world2->AddPlayer(player);
-                ctx.m_server->GetWorldPool()->OnPlayerJoin(ctx.m_servers, world, playerthing, world->GetTilePos(ITEMTYPE_MAIN_DOOR));
-                ctx.m_server->GetWorldPool()->OnPlayerSyncing(world, playerthing);
-                if (player->GetRole() > PLAYER_ROLE_MODERATOR) {
-                    world->SendPull(playerthing, player);
-                }
+                // the target's world may be owned elsewhere, it lets them go before this world takes them in
+                world_pool->MovePlayer(ctx.m_servers, playerthing, world2, world, [player, playerthing](const std::shared_ptr<World>& world) {
+                    if (player->GetRole() > PLAYER_ROLE_MODERATOR)
+                        world->SendPull(playerthing, player);
+                });
                 return;
             }
         }
@@ -967,16 +875,11 @@ namespace GTServer {
                     player->SendLog("They are in exit right now!");
                     return;
                 }
-                world->RemovePlayer(player);
-                ctx.m_server->GetWorldPool()->OnPlayerLeave(world, player, false);
-                // player->SetNetId(world2->AddPlayer(player));
-                // world2->AddPlayer(player);
-                ctx.m_server->GetWorldPool()->OnPlayerJoin(ctx.m_servers, world2, player, world2->GetTilePos(ITEMTYPE_MAIN_DOOR));
-                ctx.m_server->GetWorldPool()->OnPlayerSyncing(world2, player);
-                ctx.m_player->PlaySfx("object_spawn", 0);
-                if (player->GetRole() > PLAYER_ROLE_MODERATOR) {
-                    world2->SendPull(player, playerthing);
-                }
+                world_pool->MovePlayer(ctx.m_servers, player, world, world2, [player, playerthing](const std::shared_ptr<World>& world) {
+                    player->PlaySfx("object_spawn", 0);
+                    if (player->GetRole() > PLAYER_ROLE_MODERATOR)
+                        world->SendPull(player, playerthing);
+                });
                 return;
             }
         }
@@ -1029,11 +932,13 @@ namespace GTServer {
     void CommandManager::command_clearplaymods(const CommandContext& ctx) {
         auto world{ ctx.m_server->GetWorldPool()->GetWorld(ctx.m_player->GetWorld()) };
         std::shared_ptr<Player> player = ctx.m_player;
+        std::vector<ePlaymodType> playmods{};
         for (const auto& mod : ctx.m_player->GetPlaymods()) {
-            if (mod.m_type != PLAYMOD_TYPE_GHOST_IN_THE_SHELL && mod.m_type != PLAYMOD_TYPE_NICK && mod.m_type != PLAYMOD_TYPE_INVISIBLE) {
-                ctx.m_player->RemovePlaymod(mod.m_type);
-            }
+            if (mod.m_type != PLAYMOD_TYPE_GHOST_IN_THE_SHELL && mod.m_type != PLAYMOD_TYPE_NICK && mod.m_type != PLAYMOD_TYPE_INVISIBLE)
+                playmods.push_back(mod.m_type);
         }
+        for (const auto& type : playmods)
+            ctx.m_player->RemovePlaymod(type);
     }
     void CommandManager::command_gban(const CommandContext& ctx) {
         auto world{ ctx.m_server->GetWorldPool()->GetWorld(ctx.m_player->GetWorld()) };
@@ -1062,10 +967,7 @@ namespace GTServer {
                 playerthing2->SendLog("`5** `$The Ancient Ones `ohave `4banned`o {} `5** `w(`4/rules`o to see the rules!)", person->GetDisplayName(world));
             }
             auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-            std::ofstream ban_log_file_check;
-            ban_log_file_check.open(fmt::format("bans/{}.txt", person->GetRawName()), std::ios::trunc | std::ios::out);
-            std::ofstream ban_log_file(fmt::format("bans/{}.txt", person->GetRawName()), std::ios_base::app);
-            ban_log_file << ban_reason << std::endl;
+            KeyValueStore::Get().Put(StoreKey::ban_reason(person->GetRawName()), ban_reason);
             std::ofstream ban_log_file_main("banlogs.txt", std::ios_base::app);
             ban_log_file_main << person->GetRawName() << " was banned by " << player->GetRawName() << " at " << std::put_time(std::localtime(&now), "%c %Z") << std::endl;
             fmt::print("{} was banned by {}\n", person->GetDisplayName(world), player->GetRawName());
@@ -1289,6 +1191,45 @@ namespace GTServer {
             world->SyncPlayerData(player);
         }
     }
+    void CommandManager::command_memory(const CommandContext& ctx) {
+        auto format_bytes = [](const std::size_t& bytes) -> std::string {
+            if (bytes >= 1024 * 1024)
+                return fmt::format("{:.2f} MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+            if (bytes >= 1024)
+                return fmt::format("{:.2f} KiB", static_cast<double>(bytes) / 1024.0);
+            return fmt::format("{} B", bytes);
+        };
+        std::shared_ptr<const MemoryReport> report{ MemoryAccounting::Get().Collect(ctx.m_servers) };
+        const World::MemoryBreakdown worlds{ report->GetWorldsTotal() };
+        const Player::MemoryBreakdown players{ report->GetPlayersTotal() };
 
-
+        DialogBuilder dialog{};
+        dialog.set_default_color('o')
+            ->add_label_with_icon("`wMemory Usage``", ITEM_GROWSCAN_9000, DialogBuilder::LEFT, DialogBuilder::BIG)
+            ->add_spacer()
+            ->add_textbox(fmt::format("Process RSS: `w{}``, accounted: `w{}``", format_bytes(report->m_process_rss), format_bytes(report->GetAccountedTotal())))
+            ->add_textbox(fmt::format("Item Database: `w{}``", format_bytes(report->m_item_database)))
+            ->add_textbox(fmt::format("Render Cache: `w{}``, Atlases: `w{}``", format_bytes(report->m_render_cache), format_bytes(report->m_render_atlas)))
+            ->add_spacer()
+            ->add_textbox(fmt::format("Worlds (`w{}``): `w{}``", report->m_worlds.size(), format_bytes(worlds.GetTotal())))
+            ->add_smalltext(fmt::format("tiles `w{}``, extras `w{}``, objects `w{}``, players `w{}``, cached packets `w{}``",
+                format_bytes(worlds.m_tiles), format_bytes(worlds.m_extras), format_bytes(worlds.m_objects), format_bytes(worlds.m_players), format_bytes(worlds.m_cached_packets)));
+        for (std::size_t i = 0; i < std::min<std::size_t>(report->m_worlds.size(), 10); ++i) {
+            const auto& [name, memory] = report->m_worlds[i];
+            dialog.add_smalltext(fmt::format(" - `w{}``: {} (tiles {}, extras {}, objects {})", name, format_bytes(memory.GetTotal()),
+                format_bytes(memory.m_tiles), format_bytes(memory.m_extras), format_bytes(memory.m_objects)));
+        }
+        dialog.add_spacer()
+            ->add_textbox(fmt::format("Players (`w{}``): `w{}``", report->m_players.size(), format_bytes(players.GetTotal())))
+            ->add_smalltext(fmt::format("base `w{}``, inventory `w{}``, playmods `w{}``, packet queue `w{}``",
+                format_bytes(players.m_base), format_bytes(players.m_inventory), format_bytes(players.m_playmods), format_bytes(players.m_packet_queue)));
+        for (std::size_t i = 0; i < std::min<std::size_t>(report->m_players.size(), 10); ++i) {
+            const auto& [name, memory] = report->m_players[i];
+            dialog.add_smalltext(fmt::format(" - `w{}``: {} (inventory {}, packet queue {})", name, format_bytes(memory.GetTotal()),
+                format_bytes(memory.m_inventory), format_bytes(memory.m_packet_queue)));
+        }
+        dialog.add_quick_exit()
+            ->end_dialog("memory_report", "Okay", "");
+        ctx.m_player->v_sender.OnDialogRequest(dialog.get());
+    }
 }
@@ -1,4 +1,6 @@
 ﻿#pragma once
+#include <chrono>
+#include <ctime>
 #include <string>
 #include <string_view>
 
@@ -11,6 +13,13 @@ namespace GTServer {
         namespace http {
             constexpr std::string_view address = "0.0.0.0";
             constexpr uint16_t port = 443;
+            constexpr std::size_t worker_threads = 8;
+            constexpr std::size_t max_queued_requests = 512;
+            constexpr std::size_t max_connections_per_ip = 8;
+            constexpr std::size_t keep_alive_max_count = 16;
+            constexpr time_t keep_alive_timeout = 5;
+            constexpr long tls_session_timeout = 300;
+            constexpr bool metrics_local_only = true;
             namespace gt {
                 constexpr std::string_view address = "94.76.230.35";
             }
@@ -36,6 +45,97 @@ namespace GTServer {
 
             inline const std::string& cache_server      { "ubistatic-a.akamaihd.net" };
             inline const std::string& cache_path        { "0098/95135/cache/" };
+
+            constexpr std::chrono::seconds memory_report_interval{ 30 };
+            constexpr std::chrono::seconds stats_interval{ 1 }; // how often the service loop publishes the gauges
+            constexpr std::size_t tile_update_packet_size{ 16 * 1024 };
+            constexpr std::size_t inbox_batch           { 256 }; // world commands per world per tick
+        }
+        namespace login {
+            constexpr std::size_t worker_threads        { 4 };
+            constexpr std::size_t max_pending           { 2048 };
+            constexpr std::chrono::seconds queue_timeout{ 60 };
+            constexpr std::chrono::milliseconds stage_timeout{ 5000 };
+            constexpr std::chrono::seconds position_update_interval{ 5 };
+        }
+        namespace store {
+            inline const std::string& path              { "data/store.log" };
+            constexpr std::chrono::milliseconds flush_interval{ 250 };
+            constexpr std::size_t flush_threshold       { 64 * 1024 };
+            constexpr std::size_t compact_min_size      { 4 * 1024 * 1024 };
+        }
+        namespace journal {
+            constexpr std::chrono::milliseconds commit_interval{ 100 };
+            constexpr std::size_t checkpoint_size       { 1024 * 1024 };
+        }
+        namespace shutdown {
+            constexpr std::chrono::seconds drain_timeout{ 10 };
+            constexpr std::chrono::seconds save_deadline{ 30 };
+            constexpr std::size_t save_workers          { 8 };
+            constexpr std::chrono::seconds disconnect_timeout{ 3 };
+        }
+        namespace cluster {
+            inline const std::string& socket_path       { "data/cluster.sock" };
+            constexpr std::size_t workers               { 4 };
+            constexpr uint16_t worker_base_port         { 17092 };
+            constexpr std::chrono::seconds report_interval{ 1 };
+            constexpr std::chrono::seconds worker_timeout{ 5 };
+            constexpr std::chrono::seconds respawn_delay{ 2 };
+            constexpr std::chrono::seconds transfer_timeout{ 30 };
+            constexpr std::chrono::seconds claim_timeout{ 5 };
+            constexpr std::size_t max_message_size      { 1024 * 1024 };
+        }
+        namespace outbound {
+            constexpr std::chrono::milliseconds check_interval{ 250 };
+            constexpr std::size_t soft_bytes            { 128 * 1024 };
+            constexpr std::size_t soft_packets          { 256 };
+            constexpr std::size_t hard_bytes            { 1024 * 1024 };
+            constexpr std::size_t hard_packets          { 2048 };
+            constexpr std::chrono::seconds grace_period { 5 };
+        }
+        namespace item_data {
+            constexpr std::size_t max_streams           { 16 }; // peers receiving items.dat at the same time
+            constexpr std::size_t drained_bytes         { 64 * 1024 }; // backlog left when a stream counts as done
+            constexpr std::chrono::seconds stream_timeout{ 60 };
+            constexpr std::chrono::seconds refresh_interval{ 30 }; // per connection
+        }
+        namespace interest {
+            constexpr uint32_t cell_size                { 10 }; // tiles
+            constexpr uint32_t near_cells               { 1 };
+            constexpr uint32_t mid_cells                { 3 };
+            constexpr std::chrono::milliseconds mid_interval{ 100 };
+            constexpr std::chrono::milliseconds far_interval{ 400 };
+            constexpr float mid_delta                   { 8.f }; // pixels
+            constexpr float far_delta                   { 32.f };
+        }
+        namespace rate_limit {
+            // tokens per second and bucket size for each message class
+            constexpr double movement_rate              { 30.0 };
+            constexpr double movement_burst             { 60.0 };
+            constexpr double game_rate                  { 25.0 };
+            constexpr double game_burst                 { 50.0 };
+            constexpr double chat_rate                  { 2.0 };
+            constexpr double chat_burst                 { 5.0 };
+            constexpr double dialog_rate                { 5.0 };
+            constexpr double dialog_burst               { 10.0 };
+            constexpr double action_rate                { 5.0 };
+            constexpr double action_burst               { 15.0 };
+            constexpr double drop_rate                  { 2.0 };
+            constexpr double drop_burst                 { 5.0 };
+            constexpr double join_rate                  { 0.5 };
+            constexpr double join_burst                 { 3.0 };
+            constexpr double search_rate                { 0.2 };
+            constexpr double search_burst               { 2.0 };
+            constexpr double render_rate                { 1.0 / 60.0 };
+            constexpr double render_burst               { 1.0 };
+            constexpr double connect_rate               { 1.0 };
+            constexpr double connect_burst              { 5.0 };
+
+            constexpr uint32_t kick_strikes             { 40 };
+            constexpr std::chrono::seconds strike_window{ 10 };
+            constexpr uint32_t max_delayed              { 8 };
+            constexpr std::chrono::milliseconds max_delay{ 2000 };
+            constexpr std::chrono::seconds connect_cleanup_interval{ 60 };
         }
     }
 }
\ No newline at end of file
@@ -11,8 +11,7 @@ namespace GTServer {
         delete m_config_table;
     }
 
-    bool Database::Connect() {
-        sqlpp::mysql::global_library_init();
+    static std::shared_ptr<sqlpp::mysql::connection_config> make_config() {
         auto config = std::make_shared<sqlpp::mysql::connection_config>();
         config->host = config::database::host;
         config->port = config::database::port;
@@ -21,6 +20,12 @@ namespace GTServer {
         config->database = config::database::database;
         config->auto_reconnect = config::database::auto_reconnect;
         config->debug = config::database::debug;
+        return config;
+    }
+
+    bool Database::Connect() {
+        sqlpp::mysql::global_library_init();
+        auto config = make_config();
 
         try {
             m_connection = new sqlpp::mysql::connection{ config };
@@ -43,6 +48,16 @@ namespace GTServer {
         return true;
     }
 
+    std::unique_ptr<sqlpp::mysql::connection> Database::CreateConnection() {
+        try {
+            return std::make_unique<sqlpp::mysql::connection>(make_config());
+        }
+        catch (const sqlpp::exception &e) {
+            fmt::print("Database::CreateConnection -> {}\n", e.what());
+            return nullptr;
+        }
+    }
+
     void* Database::GetTable_Interface(const eDatabaseTable& table) {
         switch (table) {
             case DATABASE_PLAYER_TABLE: return m_player_table;
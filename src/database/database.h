@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <memory>
 #include <sqlpp11/sqlpp11.h>
 #include <sqlpp11/mysql/mysql.h>
 #include <config.h>
@@ -32,6 +33,8 @@ namespace GTServer
         bool Connect();
 
         static sqlpp::mysql::connection *GetConnection() { return Get().m_connection; }
+        // extra connection for worker threads, a single connection can't be shared between threads
+        static std::unique_ptr<sqlpp::mysql::connection> CreateConnection();
         static void *GetTable(const eDatabaseTable &table) { return Get().GetTable_Interface(table); }
 
     public:
@@ -1,10 +1,13 @@
 #include <database/item/item_database.h>
 #include <fmt/core.h>
+#include <cstring>
 #include <nlohmann/json.hpp>
 #include <config.h>
 #include <utils/binary_reader.h>
 #include <utils/binary_writer.h>
 #include <utils/file_manager.h>
+#include <utils/mapped_file.h>
+#include <utils/memory_usage.h>
 #include <utils/text.h>
 #include <proton/utils/misc_utils.h>
 
@@ -13,161 +16,306 @@ namespace GTServer {
         this->Kill();
     }
 
-    bool ItemDatabase::Serialize() {
+    bool ItemDatabase::Load() {
         if (!std::filesystem::exists("cache/items.dat") 
         || !std::filesystem::exists("utils/punch_data.dat")
         || !std::filesystem::exists("utils/items_detail.json"))
             return false;
-        m_data = FileManager::read_all_bytes("cache/items.dat", m_size);
-        if (!m_data)
+        const std::vector<uint8_t> items_data{ FileManager::read_all_bytes("cache/items.dat") };
+        const std::vector<uint8_t> details_data{ FileManager::read_all_bytes("utils/items_detail.json") };
+        if (items_data.empty())
             return false;
-        m_hash = proton::utils::RTHash(m_data, m_size);
+        const uint32_t items_hash{ proton::utils::RTHash(items_data.data(), items_data.size()) };
+        const uint32_t details_hash{ proton::utils::RTHash(details_data.data(), details_data.size()) };
 
-        BinaryReader br{ m_data };
+        if (!this->LoadCache(items_hash, details_hash)) {
+            this->Kill();
+            if (!this->Parse(items_data.data(), items_data.size()))
+                return false;
+            this->ModifyIOSSupport();
+
+            const std::vector<uint8_t> data{ this->Encode() };
+            if (!this->CreatePacket(data.data(), data.size()))
+                return false;
+            m_hash = proton::utils::RTHash(data.data(), data.size());
+
+            const std::vector<ItemDetail> details{ this->ParseDetails(details_data) };
+            this->ApplyDetails(details);
+            this->SaveCache(items_hash, details_hash, details);
+        }
+        this->LoadRewards();
+        return true;
+    }
+
+    bool ItemDatabase::Parse(const uint8_t* data, const std::size_t& size) {
+        BinaryReader br{ const_cast<uint8_t*>(data), size };
         m_version = br.read<uint16_t>();
         m_item_count = br.read<uint32_t>();
 
         m_items.reserve(m_item_count);
         for (uint32_t i = 0; i < m_item_count; i++) {
-            m_items.push_back(new ItemInfo{});
-            m_items[i]->Serialize(br);
+            m_items.emplace_back().Serialize(br, m_strings);
 
-            if (i != m_items[i]->m_id) {
+            if (i != m_items[i].m_id) {
                 fmt::print(" - unsupported items.dat version -> {}\n", m_version);
-                break;
+                return false;
             }
         }
-
-        m_update_packet = (GameUpdatePacket*)std::malloc(sizeof(GameUpdatePacket) + m_size);
-        std::memset(m_update_packet, 0, sizeof(GameUpdatePacket) + m_size);
-        m_update_packet->m_type = NET_GAME_PACKET_SEND_ITEM_DATABASE_DATA;
-        m_update_packet->m_net_id = -1;
-        m_update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-        m_update_packet->m_data_size = static_cast<uint32_t>(m_size);
-        std::memcpy(&m_update_packet->m_data, m_data, m_size);
         return true;
     }
-    void ItemDatabase::SerializeDetails() {
-        {
-            std::ifstream file("utils/items_detail.json");
-            if (!file.is_open())
-                return;
-            nlohmann::json j{};
-            file >> j;
-            file.close();
-
-            nlohmann::json array = j["items"];
-            for (auto index = 0; index < array.size(); index++) {
-                ItemInfo* item = this->GetItem(array[index]["itemID"].get<uint32_t>());
-                if (!item)
-                    continue;
-                item->m_mods = array[index]["mods"].get<uint32_t>();
-                item->m_description = array[index]["description"].get<std::string>();
-            }
-            j.clear();
-        } {
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_ATM_MACHINE, {
-                { ITEM_GEMS, 200 }
-            });
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_AWKWARD_FRIENDLY_UNICORN, {
-                { ITEM_CLOUDS, 6 },
-                { ITEM_DREAMSTONE_BLOCK, 6 },
-                { ITEM_RAINBOW_BLOCK, 6 },
-                { ITEM_RAINBOW_WIG, 6 },
-                { ITEM_ENCHANTED_SPATULA, 6 },
-                { ITEM_HAPPY_UNICORN_BLOCK, 15 },
-                { ITEM_ANGRY_UNICORN_BLOCK, 15 },
-                { ITEM_UNICORN_JUMPER, 30 },
-                { ITEM_HORSE_MASK, 30 },
-                { ITEM_SCROLL_BULLETIN, 60 },
-                { ITEM_VERY_BAD_UNICORN, 1 },
-                { ITEM_TEDDY_BEAR, 1 },
-                { ITEM_GIFT_OF_THE_UNICORN, 1 },
-                { ITEM_RETRO_LEG_WARMERS, 1 },
-                { ITEM_RAINBOW_SCARF, 1 },
-                { ITEM_TWINTAIL_HAIR, 1},
-                { ITEM_GROWMOJI_COOL_SHADES_MASK, 1 },
-                { ITEM_CARTOON_GLOVE_HAT_RED, 1 },
-                { ITEM_CARTOON_GLOVE_HAT_BLUE, 1 },
-                { ITEM_THAT_90S_HAIR, 1 },
-                { ITEM_FREAKY_FRIED_EGG_EYES, 1 },
-                { ITEM_PEAS_IN_A_POD_HAT, 1 },
-                { ITEM_PET_PINK_CROCODILE, 1 }
-            });
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_BENBARRAGES_AWESOME_ITEM_O_MATIC, {
-                { ITEM_BENBARRAGES_RED_BLOCK, 10 },
-                { ITEM_BENBARRAGES_GREEN_BLOCK, 10 },
-                { ITEM_BENBARRAGES_YELLOW_BLOCK, 10 },
-                { ITEM_BENBARRAGES_BLUE_BLOCK, 10 },
-                { ITEM_BENBARRAGES_RUBY_BLOCK, 10 }
-            });
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_BUFFALO, {
-                { ITEM_MILK, 2 }
-            });
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_CHICKEN, {
-                { ITEM_EGG, 2 }
-            });
-            this->AddReward(REWARD_TYPE_PROVIDER, ITEM_COFFEE_MAKER, {
-                { ITEM_COFFEE, 1 }
+    std::vector<uint8_t> ItemDatabase::Encode() {
+        std::size_t alloc = 6;
+        for (const ItemInfo& item : m_items)
+            alloc += item.GetMemoryUsage() + 20;
+
+        std::vector<uint8_t> ret{};
+        ret.resize(alloc);
+        BinaryWriter buffer{ ret.data() };
+        buffer.write<uint16_t>(this->m_version);
+        buffer.write<uint32_t>(this->m_item_count);
+        for (ItemInfo& item : m_items)
+            item.Pack(buffer);
+        ret.resize(buffer.get_pos());
+        return ret;
+    }
+    std::vector<ItemDatabase::ItemDetail> ItemDatabase::ParseDetails(const std::vector<uint8_t>& data) {
+        std::vector<ItemDetail> ret{};
+        nlohmann::json j{ nlohmann::json::parse(data.begin(), data.end(), nullptr, false) };
+        if (j.is_discarded() || !j.contains("items"))
+            return ret;
+        const nlohmann::json& array{ j["items"] };
+        ret.reserve(array.size());
+        for (const auto& entry : array) {
+            ret.push_back(ItemDetail{
+                entry["itemID"].get<uint32_t>(),
+                entry["mods"].get<uint32_t>(),
+                entry["description"].get<std::string>()
             });
         }
+        return ret;
     }
-    void ItemDatabase::Kill() {
-        for (auto item : m_items) {
+    void ItemDatabase::ApplyDetails(const std::vector<ItemDetail>& details) {
+        for (const auto& detail : details) {
+            ItemInfo* item = this->GetItem(detail.m_id);
             if (!item)
                 continue;
-            delete item;
-            item = nullptr;
+            item->m_mods = detail.m_mods;
+            item->m_description = m_strings.Intern(detail.m_description);
         }
-        m_items.clear();
+    }
+    void ItemDatabase::LoadRewards() {
         m_provider_rewards.clear();
-        // std::free(m_data);
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_ATM_MACHINE, {
+            { ITEM_GEMS, 200 }
+        });
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_AWKWARD_FRIENDLY_UNICORN, {
+            { ITEM_CLOUDS, 6 },
+            { ITEM_DREAMSTONE_BLOCK, 6 },
+            { ITEM_RAINBOW_BLOCK, 6 },
+            { ITEM_RAINBOW_WIG, 6 },
+            { ITEM_ENCHANTED_SPATULA, 6 },
+            { ITEM_HAPPY_UNICORN_BLOCK, 15 },
+            { ITEM_ANGRY_UNICORN_BLOCK, 15 },
+            { ITEM_UNICORN_JUMPER, 30 },
+            { ITEM_HORSE_MASK, 30 },
+            { ITEM_SCROLL_BULLETIN, 60 },
+            { ITEM_VERY_BAD_UNICORN, 1 },
+            { ITEM_TEDDY_BEAR, 1 },
+            { ITEM_GIFT_OF_THE_UNICORN, 1 },
+            { ITEM_RETRO_LEG_WARMERS, 1 },
+            { ITEM_RAINBOW_SCARF, 1 },
+            { ITEM_TWINTAIL_HAIR, 1},
+            { ITEM_GROWMOJI_COOL_SHADES_MASK, 1 },
+            { ITEM_CARTOON_GLOVE_HAT_RED, 1 },
+            { ITEM_CARTOON_GLOVE_HAT_BLUE, 1 },
+            { ITEM_THAT_90S_HAIR, 1 },
+            { ITEM_FREAKY_FRIED_EGG_EYES, 1 },
+            { ITEM_PEAS_IN_A_POD_HAT, 1 },
+            { ITEM_PET_PINK_CROCODILE, 1 }
+        });
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_BENBARRAGES_AWESOME_ITEM_O_MATIC, {
+            { ITEM_BENBARRAGES_RED_BLOCK, 10 },
+            { ITEM_BENBARRAGES_GREEN_BLOCK, 10 },
+            { ITEM_BENBARRAGES_YELLOW_BLOCK, 10 },
+            { ITEM_BENBARRAGES_BLUE_BLOCK, 10 },
+            { ITEM_BENBARRAGES_RUBY_BLOCK, 10 }
+        });
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_BUFFALO, {
+            { ITEM_MILK, 2 }
+        });
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_CHICKEN, {
+            { ITEM_EGG, 2 }
+        });
+        this->AddReward(REWARD_TYPE_PROVIDER, ITEM_COFFEE_MAKER, {
+            { ITEM_COFFEE, 1 }
+        });
     }
-    void ItemDatabase::Encode() {
-        std::size_t alloc = 6;
-        for (ItemInfo* item : m_items)
-            alloc += item->GetMemoryUsage() + 20;
 
-        BinaryWriter buffer{ alloc };
-        buffer.write<uint16_t>(this->m_version);
-        buffer.write<uint32_t>(this->m_item_count);
-        for (ItemInfo* item : m_items)
-            item->Pack(buffer);
+    bool ItemDatabase::LoadCache(const uint32_t& items_hash, const uint32_t& details_hash) {
+        // only mapped while it's read, CreatePacket copies the packet and the details are copied into the items
+        MappedFile cache{};
+        if (!cache.Open("cache/items.cache"))
+            return false;
+        const std::size_t size{ cache.GetSize() };
+        constexpr std::size_t header_size{ 32 };
+        if (size < header_size)
+            return false;
+
+        BinaryReader br{ cache.GetData(), header_size };
+        if (br.read<uint32_t>() != CACHE_MAGIC || br.read<uint16_t>() != CACHE_VERSION)
+            return false;
+        br.skip(2);
+        if (br.read<uint32_t>() != items_hash || br.read<uint32_t>() != details_hash)
+            return false;
+        const uint32_t hash{ br.read<uint32_t>() };
+        const uint32_t packet_size{ br.read<uint32_t>() };
+        const uint32_t details_offset{ br.read<uint32_t>() };
+        const uint32_t details_size{ br.read<uint32_t>() };
+        if (packet_size < sizeof(GameUpdatePacket) || header_size + packet_size > details_offset || static_cast<std::size_t>(details_offset) + details_size > size)
+            return false;
+
+        // the item data is hashed when the cache is written, a damaged copy is caught before it's parsed
+        GameUpdatePacket* update_packet{ reinterpret_cast<GameUpdatePacket*>(cache.GetData() + header_size) };
+        if (sizeof(GameUpdatePacket) + update_packet->m_data_size != packet_size)
+            return false;
+        const uint8_t* items_data{ reinterpret_cast<const uint8_t*>(&update_packet->m_data) };
+        if (proton::utils::RTHash(items_data, update_packet->m_data_size) != hash)
+            return false;
+
+        std::vector<ItemDetail> details{};
+        if (details_size > 0) {
+            const uint8_t* begin{ cache.GetData() + details_offset };
+            std::size_t pos{ 0 };
+            auto read = [&](void* value, const std::size_t& length) {
+                if (details_size - pos < length)
+                    return false;
+                std::memcpy(value, begin + pos, length);
+                pos += length;
+                return true;
+            };
+            uint32_t count{};
+            if (!read(&count, sizeof(uint32_t)) || count > (details_size - pos) / (sizeof(uint32_t) * 2 + sizeof(uint16_t)))
+                return false;
+            details.reserve(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                ItemDetail detail{};
+                uint16_t length{};
+                if (!read(&detail.m_id, sizeof(uint32_t)) || !read(&detail.m_mods, sizeof(uint32_t)) || !read(&length, sizeof(uint16_t)))
+                    return false;
+                detail.m_description.resize(length);
+                if (!read(detail.m_description.data(), length))
+                    return false;
+                details.push_back(std::move(detail));
+            }
+        }
 
-        FileManager::write_all_bytes("cache/items.dat", reinterpret_cast<char*>(buffer.get()), buffer.get_pos());
+        this->Kill();
+        if (!this->Parse(items_data, update_packet->m_data_size) || !this->CreatePacket(items_data, update_packet->m_data_size)) {
+            this->Kill();
+            return false;
+        }
+        m_hash = hash;
+        this->ApplyDetails(details);
+        return true;
     }
+    bool ItemDatabase::CreatePacket(const uint8_t* data, const std::size_t& size) {
+        auto packet{ std::make_unique<GamePacket>(NET_GAME_PACKET_SEND_ITEM_DATABASE_DATA, size) };
+        if (!packet->IsValid())
+            return false;
+        (*packet)->m_net_id = -1;
+        std::memcpy(packet->GetData(), data, size);
+        packet->Retain();
 
+        m_packet = std::move(packet);
+        m_update_packet = m_packet->Get();
+        m_size = size;
+        return true;
+    }
+    void ItemDatabase::SaveCache(const uint32_t& items_hash, const uint32_t& details_hash, const std::vector<ItemDetail>& details) const {
+        constexpr std::size_t header_size{ 32 };
+        const std::size_t packet_size{ sizeof(GameUpdatePacket) + m_size };
+        std::size_t details_size{ sizeof(uint32_t) };
+        for (const auto& detail : details)
+            details_size += sizeof(uint32_t) * 2 + sizeof(uint16_t) + detail.m_description.size();
+
+        std::vector<uint8_t> data{};
+        data.resize(header_size + packet_size + details_size);
+        BinaryWriter buffer{ data.data() };
+        buffer.write<uint32_t>(CACHE_MAGIC);
+        buffer.write<uint16_t>(CACHE_VERSION);
+        buffer.write<uint16_t>(0);
+        buffer.write<uint32_t>(items_hash);
+        buffer.write<uint32_t>(details_hash);
+        buffer.write<uint32_t>(m_hash);
+        buffer.write<uint32_t>(static_cast<uint32_t>(packet_size));
+        buffer.write<uint32_t>(static_cast<uint32_t>(header_size + packet_size));
+        buffer.write<uint32_t>(static_cast<uint32_t>(details_size));
+        buffer.write(reinterpret_cast<const uint8_t*>(m_update_packet), packet_size);
+
+        buffer.write<uint32_t>(static_cast<uint32_t>(details.size()));
+        for (const auto& detail : details) {
+            buffer.write<uint32_t>(detail.m_id);
+            buffer.write<uint32_t>(detail.m_mods);
+            buffer.write(detail.m_description);
+        }
+        // written next to the old cache and renamed over it, a crash never leaves a half written cache behind
+        if (!FileManager::write_all_bytes("cache/items.cache.tmp", reinterpret_cast<char*>(data.data()), buffer.get_pos())) {
+            fmt::print(" - failed to write cache/items.cache\n");
+            return;
+        }
+        std::error_code ec{};
+        std::filesystem::rename("cache/items.cache.tmp", "cache/items.cache", ec);
+        if (ec)
+            fmt::print(" - failed to replace cache/items.cache, {}\n", ec.message());
+    }
+    void ItemDatabase::Kill() {
+        m_items.clear();
+        m_strings.Clear();
+        m_provider_rewards.clear();
+    }
     void ItemDatabase::ModifyIOSSupport() {
-        for (ItemInfo* item : m_items) {
-            if (item->m_extra_file.find(".mp3") == std::string::npos || item->m_extra_file.find("audio/mp3/") == std::string::npos)
+        for (ItemInfo& item : m_items) {
+            if (item.m_extra_file.find(".mp3") == std::string::npos || item.m_extra_file.find("audio/mp3/") == std::string::npos)
                 continue;
+            std::string extra_file{ item.m_extra_file };
             { 
-                std::size_t start_pos = item->m_extra_file.find("audio/mp3/");
+                std::size_t start_pos = extra_file.find("audio/mp3/");
                 if (start_pos != std::string::npos)
-                    item->m_extra_file.replace(start_pos, 10, "audio/ogg/");
+                    extra_file.replace(start_pos, 10, "audio/ogg/");
             } {   
-                std::size_t start_pos = item->m_extra_file.find(".mp3");
+                std::size_t start_pos = extra_file.find(".mp3");
                 if (start_pos != std::string::npos)
-                    item->m_extra_file.replace(start_pos, 4, ".ogg");
+                    extra_file.replace(start_pos, 4, ".ogg");
             }
+            item.m_extra_file = m_strings.Intern(extra_file);
         }
     }
-
     ItemInfo* ItemDatabase::get_item__interface(const uint32_t& item) {
-        if (item < ITEM_BLANK || item > m_items.size())
+        if (item < ITEM_BLANK || item >= m_items.size())
             return nullptr;
-        return m_items[item];
+        return &m_items[item];
     }
     ItemInfo* ItemDatabase::get_item_by_name__interface(std::string name) {
         std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
 
-        for (auto item : this->GetItems()) {
-            std::string item_name = item->m_name;
+        for (ItemInfo& item : m_items) {
+            std::string item_name{ item.m_name };
             std::transform(item_name.begin(), item_name.end(), item_name.begin(), [](unsigned char c) { return std::tolower(c); });
             if (item_name != name)
                 continue;
-            return item;
+            return &item;
         }
         return nullptr;
     }
+    std::size_t ItemDatabase::get_resident_memory_usage__interface() const {
+        std::size_t ret{};
+        if (m_update_packet)
+            ret += sizeof(GameUpdatePacket) + m_update_packet->m_data_size;
+        ret += MemoryUsage::of(m_items);
+        ret += m_strings.GetMemoryUsage();
+        ret += MemoryUsage::of(m_provider_rewards);
+        for (const auto& [base, rewards] : m_provider_rewards)
+            ret += MemoryUsage::of(rewards);
+        return ret;
+    }
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
 #include <database/item/item_info.h>
 #include <database/item/item_collision.h>
 #include <database/item/item_component.h>
-#include <proton/packet.h>
+#include <proton/game_packet.h>
+#include <utils/string_table.h>
 
 namespace GTServer
 {
@@ -18,19 +20,20 @@ namespace GTServer
         ItemDatabase() = default;
         ~ItemDatabase();
         
-        bool Serialize();
-        void SerializeDetails();
+        // parses items.dat once, the patched client packet and the merged details are reused from
+        // cache/items.cache on the next start as long as both input files are unchanged
+        bool Load();
         void Kill();
-        void Encode();
 
         void ModifyIOSSupport();
 
         static uint32_t GetHash() { return Get().m_hash; }
-        static GameUpdatePacket* GetPacket() { return Get().m_update_packet; }
-        static std::vector<ItemInfo*> GetItems() { return Get().m_items; }
+        static GamePacket* GetPacket() { return Get().m_packet.get(); }
+        static const std::vector<ItemInfo>& GetItems() { return Get().m_items; }
 
         static ItemInfo* GetItem(const uint32_t& item) { return Get().get_item__interface(item); }
         static ItemInfo* GetItemByName(std::string name) { return Get().get_item_by_name__interface(name); }
+        static std::size_t GetResidentMemoryUsage() { return Get().get_resident_memory_usage__interface(); }
 
         static std::vector<std::pair<uint32_t, uint8_t>> GetRewards(eRewardType type, const uint32_t& base) {
             switch (type) {
@@ -50,6 +53,7 @@ namespace GTServer
     public:
         ItemInfo* get_item__interface(const uint32_t& item);
         ItemInfo* get_item_by_name__interface(std::string name);
+        std::size_t get_resident_memory_usage__interface() const;
 
         void AddReward(eRewardType type, const uint32_t& base, std::vector<std::pair<uint32_t, uint8_t>> rewards) { 
             switch (type) {
@@ -62,18 +66,40 @@ namespace GTServer
         }
 
     private:
-        std::size_t m_size;
-        uint8_t* m_data;
+        struct ItemDetail {
+            uint32_t m_id;
+            uint32_t m_mods;
+            std::string m_description;
+        };
+        static constexpr uint32_t CACHE_MAGIC = 0x43495447; // GTIC
+        static constexpr uint16_t CACHE_VERSION = 1;
 
-        uint32_t m_hash;
-        uint16_t m_version;
-        uint32_t m_item_count;
+        bool Parse(const uint8_t* data, const std::size_t& size);
+        std::vector<uint8_t> Encode();
+        std::vector<ItemDetail> ParseDetails(const std::vector<uint8_t>& data);
+        void ApplyDetails(const std::vector<ItemDetail>& details);
+        void LoadRewards();
 
-        GameUpdatePacket* m_update_packet;
+        bool CreatePacket(const uint8_t* data, const std::size_t& size);
+        bool LoadCache(const uint32_t& items_hash, const uint32_t& details_hash);
+        void SaveCache(const uint32_t& items_hash, const uint32_t& details_hash, const std::vector<ItemDetail>& details) const;
 
     private:
+        std::size_t m_size{ 0 };
 
-        std::vector<ItemInfo*> m_items;
+        uint32_t m_hash{ 0 };
+        uint16_t m_version{ 0 };
+        uint32_t m_item_count{ 0 };
+
+        // built once and shared by every peer it's sent to, m_update_packet points into it
+        std::unique_ptr<GamePacket> m_packet{};
+        GameUpdatePacket* m_update_packet{ nullptr };
+
+    private:
+
+        // indexed by item id, the string fields point into m_strings
+        std::vector<ItemInfo> m_items;
+        StringTable m_strings{};
         std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint8_t>>> m_provider_rewards;
     };
 }
\ No newline at end of file
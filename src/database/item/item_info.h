@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <fmt/core.h>
 #include <database/item/item_component.h>
 #include <database/item/item_type.h>
@@ -9,42 +10,44 @@
 #include <utils/binary_writer.h>
 #include <utils/text.h>
 #include <utils/file_manager.h>
+#include <utils/string_table.h>
 #include <proton/utils/misc_utils.h>
 
 namespace GTServer {
+    // laid out in one contiguous array by ItemDatabase, the fields read on every tile/packet come first so
+    // the common lookups stay on one cache line. strings are views into the database's string table.
     struct ItemInfo {
         uint32_t m_id;
+        uint32_t m_flags1 = 0;
+        uint32_t m_grow_time = 0;
+        uint32_t m_clothing_type = 0;
+        uint16_t m_rarity = 0;
+        uint16_t m_flags2 = 0;
+        uint8_t m_item_type = 0;
+        uint8_t m_collision_type = 0;
+        uint8_t m_break_hits = 0;
+        uint8_t m_max_amount = 0;
+        uint8_t m_spread_type = 0;
         uint8_t m_editable_type = 0;
         uint8_t m_item_category = 0;
-        uint8_t m_item_type = 0;
         uint8_t m_marterial = 0;
-
-        std::string m_name = "";
-        std::string m_texture = "";
-
-        uint32_t m_texture_hash = 0;
-        uint8_t m_visual_effect = 0;
-
-        uint32_t m_flags1 = 0;
-        uint32_t m_ingredient = 0;
-
+        bool m_has_extra = false;
         uint8_t m_texture_x = 0;
         uint8_t m_texture_y = 0;
-        uint8_t m_spread_type = 0;
+        uint8_t m_default_texture_x = 0;
+        uint8_t m_default_texture_y = 0;
+        uint8_t m_visual_effect = 0;
         uint8_t m_is_stripey_wallpaper = 0;
-        uint8_t m_collision_type = 0;
-
-        uint8_t m_break_hits = 0;
 
         uint32_t m_reset_time = 0;
+        uint32_t m_mods = 0;
 
-        uint32_t m_grow_time = 0;
-        uint32_t m_clothing_type = 0;
-
-        uint16_t m_rarity = 0;
-        uint8_t m_max_amount = 0;
+        std::string_view m_name = "";
+        std::string_view m_texture = "";
+        uint32_t m_texture_hash = 0;
+        uint32_t m_ingredient = 0;
 
-        std::string m_extra_file = "";
+        std::string_view m_extra_file = "";
         uint32_t m_extra_file_hash = 0;
 
         union {
@@ -52,10 +55,10 @@ namespace GTServer {
             uint32_t m_weather_id;
         };
 
-        std::string m_pet_name = "";
-        std::string m_pet_prefix = "";
-        std::string m_pet_suffix = "";
-        std::string m_pet_ability = "";
+        std::string_view m_pet_name = "";
+        std::string_view m_pet_prefix = "";
+        std::string_view m_pet_suffix = "";
+        std::string_view m_pet_ability = "";
 
         uint8_t m_seed_base = 0;
         uint8_t m_seed_overlay = 0;
@@ -65,13 +68,12 @@ namespace GTServer {
         uint32_t m_seed_color = 0;
         uint32_t m_seed_overlay_color = 0;
 
-        uint16_t m_flags2 = 0;
         uint16_t m_rayman = 0;
 
-        std::string m_extra_options = "";
-        std::string m_texture2 = "";
-        std::string m_extra_options2 = "";
-        std::string m_punch_options = "";
+        std::string_view m_extra_options = "";
+        std::string_view m_texture2 = "";
+        std::string_view m_extra_options2 = "";
+        std::string_view m_punch_options = "";
 
         uint32_t m_val3 = 0;
         uint32_t m_val4 = 0;
@@ -80,14 +82,9 @@ namespace GTServer {
         uint8_t m_bodypart[9] = { 0 };
         uint8_t m_reserved[80] = { 0 };
 
-        bool m_has_extra = false;
-        uint8_t m_default_texture_x = 0;
-        uint8_t m_default_texture_y = 0;
-
-        uint32_t m_mods = 0;
-        std::string m_description = "This is a seed.";
+        std::string_view m_description = "This is a seed.";
 
-        static std::string Cypher(const std::string& input, uint32_t item_id) {
+        static std::string Cypher(const std::string_view& input, uint32_t item_id) {
             constexpr std::string_view key{ "PBG892FXX982ABC*" };
             std::string ret(input.size(), 0);
 
@@ -128,6 +125,10 @@ namespace GTServer {
             ret += 21;
             return ret;
         }
+        // strings are accounted for by the string table they live in
+        std::size_t GetResidentMemoryUsage() const {
+            return sizeof(ItemInfo);
+        }
         void Pack(BinaryWriter& buffer) {
             buffer.write<uint32_t>(m_id);
             buffer.write<uint8_t>(m_editable_type);
@@ -208,15 +209,15 @@ namespace GTServer {
             buffer.write<uint32_t>(m_val4);
             buffer.write<uint32_t>(m_val5);
         }
-        void Serialize(BinaryReader& br) {
+        void Serialize(BinaryReader& br, StringTable& strings) {
             m_id = br.read<uint32_t>();
             m_editable_type = br.read<uint8_t>();
             m_item_category = br.read<uint8_t>();
             m_item_type = br.read<uint8_t>();
             m_marterial = br.read<uint8_t>();
 
-            m_name = this->Cypher(br.read_string(), m_id);
-            m_texture = br.read_string();
+            m_name = strings.Intern(this->Cypher(br.read_string_view(), m_id));
+            m_texture = strings.Intern(br.read_string_view());
 
             m_texture_hash = br.read<uint32_t>();
             m_visual_effect = br.read<uint8_t>();
@@ -232,15 +233,15 @@ namespace GTServer {
             m_rarity = br.read<uint16_t>();
             m_max_amount = br.read<uint8_t>();
 
-            m_extra_file = br.read_string();
+            m_extra_file = strings.Intern(br.read_string_view());
 
             m_extra_file_hash = br.read<uint32_t>();
             m_audio_volume = br.read<uint32_t>();
 
-            m_pet_name = br.read_string();
-            m_pet_prefix = br.read_string();
-            m_pet_suffix = br.read_string();
-            m_pet_ability = br.read_string();
+            m_pet_name = strings.Intern(br.read_string_view());
+            m_pet_prefix = strings.Intern(br.read_string_view());
+            m_pet_suffix = strings.Intern(br.read_string_view());
+            m_pet_ability = strings.Intern(br.read_string_view());
 
             m_seed_base = br.read<uint8_t>();
             m_seed_overlay = br.read<uint8_t>();
@@ -253,13 +254,13 @@ namespace GTServer {
             m_flags2 = br.read<uint16_t>();
             m_rayman = br.read<uint16_t>();
 
-            m_extra_options = br.read_string();
-            m_texture2 = br.read_string();
-            m_extra_options2 = br.read_string();
+            m_extra_options = strings.Intern(br.read_string_view());
+            m_texture2 = strings.Intern(br.read_string_view());
+            m_extra_options2 = strings.Intern(br.read_string_view());
             for (auto index = 0; index < 80; index++)
                 m_reserved[index] = br.read<uint8_t>();
             
-            m_punch_options = br.read_string();
+            m_punch_options = strings.Intern(br.read_string_view());
             m_val3 = br.read<uint32_t>();
             for (auto index = 0; index < 9; index++)
                 m_bodypart[index] = br.read<uint8_t>();
@@ -0,0 +1,372 @@
+#include <database/kv_store.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <config.h>
+#include <utils/file_manager.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace GTServer {
+    static uint32_t checksum(const char* data, const std::size_t& size) {
+        uint32_t hash = 0x811C9DC5;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x01000193;
+        }
+        return hash;
+    }
+    static bool sync_file(std::FILE* file) {
+        if (std::fflush(file) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    KeyValueStore::~KeyValueStore() {
+        this->Close();
+    }
+
+    bool KeyValueStore::Open(const std::string& path) {
+        if (m_file)
+            return true;
+        m_path = path;
+        std::filesystem::path parent{ std::filesystem::path{ path }.parent_path() };
+        if (!parent.empty() && !std::filesystem::is_directory(parent))
+            std::filesystem::create_directories(parent);
+
+        if (!this->Load())
+            return false;
+        m_file = std::fopen(m_path.c_str(), "ab");
+        if (!m_file)
+            return false;
+        if (m_file_size > config::store::compact_min_size && m_file_size > m_live_size * 2)
+            this->Compact();
+
+        m_running.store(true);
+        m_thread = std::thread{ &KeyValueStore::FlushThread, this };
+        return true;
+    }
+    void KeyValueStore::OpenReplica(ChangeCallback on_change) {
+        m_on_change = std::move(on_change);
+    }
+    void KeyValueStore::Close() {
+        if (m_running.exchange(false)) {
+            m_condition.notify_all();
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+        this->WritePending();
+        if (!m_file)
+            return;
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    std::optional<std::string> KeyValueStore::Find(const std::string& key) const {
+        std::scoped_lock lock{ m_mutex };
+        if (auto it = m_index.find(key); it != m_index.end())
+            return it->second;
+        return std::nullopt;
+    }
+    bool KeyValueStore::Contains(const std::string& key) const {
+        std::scoped_lock lock{ m_mutex };
+        return m_index.contains(key);
+    }
+    std::size_t KeyValueStore::GetKeyCount() const {
+        std::scoped_lock lock{ m_mutex };
+        return m_index.size();
+    }
+    void KeyValueStore::Put(const std::string& key, const std::string& value) {
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (auto it = m_index.find(key); it != m_index.end()) {
+                if (it->second == value)
+                    return;
+                m_live_size -= GetRecordSize(key, it->second);
+                it->second = value;
+            }
+            else
+                m_index.emplace(key, value);
+            m_live_size += GetRecordSize(key, value);
+            if (!m_on_change) {
+                EncodeRecord(m_pending, RECORD_TYPE_PUT, key, value);
+                if (m_pending.size() >= config::store::flush_threshold)
+                    m_condition.notify_one();
+                return;
+            }
+        }
+        m_on_change(key, value);
+    }
+    void KeyValueStore::Remove(const std::string& key) {
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto it = m_index.find(key);
+            if (it == m_index.end())
+                return;
+            m_live_size -= GetRecordSize(key, it->second);
+            m_index.erase(it);
+            if (!m_on_change) {
+                EncodeRecord(m_pending, RECORD_TYPE_REMOVE, key, std::string{});
+                return;
+            }
+        }
+        m_on_change(key, std::nullopt);
+    }
+    void KeyValueStore::Apply(const std::string& key, const std::optional<std::string>& value) {
+        std::scoped_lock lock{ m_mutex };
+        if (auto it = m_index.find(key); it != m_index.end()) {
+            m_live_size -= GetRecordSize(key, it->second);
+            m_index.erase(it);
+        }
+        if (!value)
+            return;
+        m_live_size += GetRecordSize(key, value.value());
+        m_index.emplace(key, value.value());
+    }
+    void KeyValueStore::ForEach(const std::function<void(const std::string&, const std::string&)>& callback) const {
+        std::scoped_lock lock{ m_mutex };
+        for (const auto& [key, value] : m_index)
+            callback(key, value);
+    }
+    void KeyValueStore::Flush() {
+        this->WritePending();
+    }
+
+    void KeyValueStore::EncodeRecord(std::string& buffer, const eRecordType& type, const std::string& key, const std::string& value) {
+        const std::size_t offset{ buffer.size() };
+        const uint32_t length{ static_cast<uint32_t>(RECORD_PAYLOAD_SIZE + key.size() + value.size()) };
+        const uint16_t key_length{ static_cast<uint16_t>(key.size()) };
+        buffer.resize(offset + RECORD_HEADER_SIZE + length);
+
+        char* data{ buffer.data() + offset };
+        char* payload{ data + RECORD_HEADER_SIZE };
+        payload[0] = static_cast<char>(type);
+        std::memcpy(payload + sizeof(uint8_t), &key_length, sizeof(uint16_t));
+        std::memcpy(payload + RECORD_PAYLOAD_SIZE, key.data(), key.size());
+        std::memcpy(payload + RECORD_PAYLOAD_SIZE + key.size(), value.data(), value.size());
+
+        const uint32_t hash{ checksum(payload, length) };
+        std::memcpy(data, &length, sizeof(uint32_t));
+        std::memcpy(data + sizeof(uint32_t), &hash, sizeof(uint32_t));
+    }
+
+    bool KeyValueStore::Load() {
+        if (!std::filesystem::exists(m_path))
+            return true;
+        std::vector<uint8_t> content{ FileManager::read_all_bytes(m_path) };
+        const char* data{ reinterpret_cast<const char*>(content.data()) };
+
+        std::size_t pos{ 0 };
+        while (pos + RECORD_HEADER_SIZE <= content.size()) {
+            uint32_t length{}, hash{};
+            std::memcpy(&length, data + pos, sizeof(uint32_t));
+            std::memcpy(&hash, data + pos + sizeof(uint32_t), sizeof(uint32_t));
+            if (length < RECORD_PAYLOAD_SIZE || pos + RECORD_HEADER_SIZE + length > content.size())
+                break;
+            const char* payload{ data + pos + RECORD_HEADER_SIZE };
+            if (checksum(payload, length) != hash)
+                break;
+            uint16_t key_length{};
+            std::memcpy(&key_length, payload + sizeof(uint8_t), sizeof(uint16_t));
+            if (RECORD_PAYLOAD_SIZE + key_length > length)
+                break;
+
+            std::string key{ payload + RECORD_PAYLOAD_SIZE, key_length };
+            std::string value{ payload + RECORD_PAYLOAD_SIZE + key_length, length - RECORD_PAYLOAD_SIZE - key_length };
+            if (auto it = m_index.find(key); it != m_index.end()) {
+                m_live_size -= GetRecordSize(key, it->second);
+                m_index.erase(it);
+            }
+            if (static_cast<eRecordType>(payload[0]) == RECORD_TYPE_PUT) {
+                m_live_size += GetRecordSize(key, value);
+                m_index.emplace(std::move(key), std::move(value));
+            }
+            pos += RECORD_HEADER_SIZE + length;
+        }
+        if (pos != content.size()) {
+            // torn or corrupted tail from a crash mid-write, everything after the last good record is dropped
+            fmt::print("KeyValueStore -> discarding {} bytes of damaged records at the end of {}\n", content.size() - pos, m_path);
+            std::error_code ec{};
+            std::filesystem::resize_file(m_path, pos, ec);
+            if (ec)
+                return false;
+        }
+        m_file_size = pos;
+        return true;
+    }
+
+    bool KeyValueStore::WritePending() {
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::string pending{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            pending.swap(m_pending);
+        }
+        if (pending.empty())
+            return true;
+        if (!m_file || std::fwrite(pending.data(), 1, pending.size(), m_file) != pending.size() || !sync_file(m_file)) {
+            fmt::print("KeyValueStore -> failed to write {} bytes to {}\n", pending.size(), m_path);
+            // a torn record would hide everything after it on the next load, the log goes back to its last good size
+            // and the records wait for the next flush in front of whatever was queued since
+            if (m_file) {
+                std::fclose(m_file);
+                std::error_code ec{};
+                std::filesystem::resize_file(m_path, m_file_size, ec);
+                m_file = std::fopen(m_path.c_str(), "ab");
+            }
+            std::scoped_lock lock{ m_mutex };
+            m_pending.insert(0, pending);
+            return false;
+        }
+        m_file_size += pending.size();
+        return true;
+    }
+
+    bool KeyValueStore::Compact() {
+        // pending records are written to the old log first, anything queued while the snapshot is
+        // written below is appended to the new log afterwards, replaying it twice is harmless
+        this->WritePending();
+
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::string buffer{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            buffer.reserve(m_live_size);
+            for (const auto& [key, value] : m_index)
+                EncodeRecord(buffer, RECORD_TYPE_PUT, key, value);
+        }
+        const std::string temp_path{ m_path + ".tmp" };
+        std::FILE* file{ std::fopen(temp_path.c_str(), "wb") };
+        if (!file)
+            return false;
+        const bool written{ std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && sync_file(file) };
+        std::fclose(file);
+        if (!written) {
+            std::filesystem::remove(temp_path);
+            return false;
+        }
+
+        if (m_file)
+            std::fclose(m_file);
+        std::error_code ec{};
+        std::filesystem::rename(temp_path, m_path, ec);
+        m_file = std::fopen(m_path.c_str(), "ab");
+        if (ec || !m_file) {
+            fmt::print("KeyValueStore -> failed to replace {} with its compacted copy\n", m_path);
+            return false;
+        }
+        m_file_size = buffer.size();
+        return true;
+    }
+
+    void KeyValueStore::FlushThread() {
+        while (m_running.load()) {
+            {
+                std::unique_lock lock{ m_mutex };
+                m_condition.wait_for(lock, config::store::flush_interval, [&] {
+                    return !m_running.load() || m_pending.size() >= config::store::flush_threshold;
+                });
+            }
+            this->WritePending();
+
+            bool compact{ false };
+            {
+                std::scoped_lock lock{ m_mutex };
+                compact = m_file_size > config::store::compact_min_size && m_file_size > m_live_size * 2;
+            }
+            if (compact)
+                this->Compact();
+        }
+    }
+
+    bool KeyValueStore::Migrate() {
+        namespace fs = std::filesystem;
+        if (this->Contains("meta:migrated"))
+            return true;
+
+        auto read_lines = [](const fs::path& path) {
+            std::vector<std::string> ret{};
+            std::ifstream file{ path };
+            std::string line{};
+            while (std::getline(file, line)) {
+                line.erase(0, line.find_first_not_of(" \t\r"));
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                ret.push_back(line);
+            }
+            return ret;
+        };
+        auto is_number = [](const std::string& str) {
+            return !str.empty() && str.size() < 11 && str.find_first_not_of("0123456789") == std::string::npos;
+        };
+
+        std::size_t nicknames{ 0 }, friends{ 0 }, bans{ 0 }, globals{ 0 };
+        std::error_code ec{};
+        if (fs::is_directory("PlayerData")) {
+            // PlayerData/<raw_name> holds the nickname, PlayerData/<user_id> the friends list
+            for (const auto& entry : fs::directory_iterator{ "PlayerData", ec }) {
+                if (!entry.is_directory())
+                    continue;
+                const std::string name{ entry.path().filename().string() };
+                for (const auto& line : read_lines(entry.path() / "PlayerData.txt")) {
+                    if (line.rfind("CustomNickname:", 0) != 0)
+                        continue;
+                    std::string nickname{ line.substr(15) };
+                    nickname.erase(0, nickname.find_first_not_of(' '));
+                    if (!nickname.empty()) {
+                        this->Put(StoreKey::nickname(name), nickname);
+                        ++nicknames;
+                    }
+                    break;
+                }
+                if (!is_number(name))
+                    continue;
+                std::string list{};
+                for (const auto& line : read_lines(entry.path() / "friends.txt")) {
+                    if (is_number(line))
+                        list.append(line).push_back('\n');
+                }
+                if (!list.empty()) {
+                    this->Put(StoreKey::friends(static_cast<uint32_t>(std::stoul(name))), list);
+                    ++friends;
+                }
+            }
+        }
+        if (fs::is_directory("bans")) {
+            for (const auto& entry : fs::directory_iterator{ "bans", ec }) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".txt")
+                    continue;
+                std::string reason{};
+                for (const auto& line : read_lines(entry.path())) {
+                    if (!reason.empty())
+                        reason.push_back('\n');
+                    reason.append(line);
+                }
+                this->Put(StoreKey::ban_reason(entry.path().stem().string()), reason);
+                ++bans;
+            }
+        }
+        for (const auto& line : read_lines("GlobalGameVariables.txt")) {
+            const std::size_t separator{ line.find(':') };
+            if (separator == std::string::npos || separator == 0)
+                continue;
+            std::string value{ line.substr(separator + 1) };
+            value.erase(0, value.find_first_not_of(' '));
+            this->Put(StoreKey::global(line.substr(0, separator)), value);
+            ++globals;
+        }
+
+        this->Put("meta:migrated", "1");
+        if (!this->WritePending())
+            return false;
+        fmt::print(" - KeyValueStore migrated {} nicknames, {} friend lists, {} bans and {} global variables\n", nicknames, friends, bans, globals);
+        return true;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <fmt/core.h>
+
+namespace GTServer {
+    // append-only log of put/remove records, replayed into an in-memory index on open.
+    // writes are buffered and fsynced in batches by a background thread.
+    class KeyValueStore {
+    public:
+        // key and the new value, nullopt once it was removed
+        using ChangeCallback = std::function<void(const std::string&, const std::optional<std::string>&)>;
+
+        KeyValueStore() = default;
+        ~KeyValueStore();
+
+        bool Open(const std::string& path);
+        // in memory only, for a worker whose gateway owns the log. Put and Remove hand the change to
+        // `on_change` and the changes coming back from the gateway are applied with Apply
+        void OpenReplica(ChangeCallback on_change);
+        void Close();
+        // imports PlayerData/, bans/ and GlobalGameVariables.txt once, the files are left untouched
+        bool Migrate();
+
+        [[nodiscard]] std::optional<std::string> Find(const std::string& key) const;
+        [[nodiscard]] bool Contains(const std::string& key) const;
+        [[nodiscard]] std::size_t GetKeyCount() const;
+        void Put(const std::string& key, const std::string& value);
+        void Remove(const std::string& key);
+        void Apply(const std::string& key, const std::optional<std::string>& value);
+        void ForEach(const std::function<void(const std::string&, const std::string&)>& callback) const;
+        void Flush();
+
+    public:
+        static KeyValueStore& Get() { static KeyValueStore ret; return ret; }
+
+    private:
+        enum eRecordType : uint8_t {
+            RECORD_TYPE_PUT = 1,
+            RECORD_TYPE_REMOVE
+        };
+        static constexpr std::size_t RECORD_HEADER_SIZE = sizeof(uint32_t) * 2;
+        static constexpr std::size_t RECORD_PAYLOAD_SIZE = sizeof(uint8_t) + sizeof(uint16_t);
+
+        static void EncodeRecord(std::string& buffer, const eRecordType& type, const std::string& key, const std::string& value);
+        static std::size_t GetRecordSize(const std::string& key, const std::string& value) { return RECORD_HEADER_SIZE + RECORD_PAYLOAD_SIZE + key.size() + value.size(); }
+
+        bool Load();
+        bool WritePending();
+        bool Compact();
+        void FlushThread();
+
+    private:
+        std::string m_path{};
+        std::FILE* m_file{ nullptr };
+        std::size_t m_file_size{ 0 };
+
+        mutable std::mutex m_mutex{};
+        std::mutex m_io_mutex{};
+        std::condition_variable m_condition{};
+        std::unordered_map<std::string, std::string> m_index{};
+        std::string m_pending{};
+        std::size_t m_live_size{ 0 };
+        ChangeCallback m_on_change{};
+
+        std::atomic<bool> m_running{ false };
+        std::thread m_thread{};
+    };
+
+    namespace StoreKey {
+        inline std::string nickname(const std::string& raw_name) { return fmt::format("nick:{}", raw_name); }
+        inline std::string friends(const uint32_t& user_id) { return fmt::format("friends:{}", user_id); }
+        inline std::string ban_reason(const std::string& raw_name) { return fmt::format("ban:{}", raw_name); }
+        inline std::string global(const std::string& name) { return fmt::format("global:{}", name); }
+    }
+}
@@ -1,9 +1,17 @@
 #include <database/table/player_table.h>
 #include <fmt/chrono.h>
 #include <utils/text.h>
+#include <server/metrics.h>
 
 namespace GTServer {
+    static LatencyHistogram& query_latency(const std::string& query) {
+        return Metrics::Get().GetHistogram("gtserver_database_query_duration_seconds", "Time spent on database queries",
+            fmt::format("table=\"player\",query=\"{}\"", query));
+    }
+
     bool PlayerTable::IsAccountExist(const std::string& name) const {
+        static LatencyHistogram& histogram{ query_latency("IsAccountExist") };
+        ScopedLatency latency{ histogram };
         PlayerDB player_db{};
         for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(
             player_db.raw_name == name and player_db.tank_id_name != std::string{}
@@ -14,6 +22,8 @@ namespace GTServer {
         return false;
     }
     std::string PlayerTable::GetName(const int32_t& uid) const {
+        static LatencyHistogram& histogram{ query_latency("GetName") };
+        ScopedLatency latency{ histogram };
         PlayerDB player_db{};
         for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(player_db.id == uid).limit(1u))) {
             if (row._is_valid)
@@ -22,6 +32,8 @@ namespace GTServer {
         return {};
     }
     std::unordered_map<uint32_t, std::string> PlayerTable::GetPlayersMatchingName(const std::string& name) {
+        static LatencyHistogram& histogram{ query_latency("GetPlayersMatchingName") };
+        ScopedLatency latency{ histogram };
         std::unordered_map<uint32_t, std::string> ret{};
         PlayerDB player_db{};
         for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(player_db.raw_name.like(
@@ -34,6 +46,8 @@ namespace GTServer {
     }
 
     uint32_t PlayerTable::Insert(std::shared_ptr<Player> player) {
+        static LatencyHistogram& histogram{ query_latency("Insert") };
+        ScopedLatency latency{ histogram };
         std::shared_ptr<LoginInformation> login{ player->m_login_info };
 
         if (this->IsAccountExist(login->m_tank_id_name))
@@ -59,6 +73,8 @@ namespace GTServer {
         return id;
     }
     bool PlayerTable::Save(std::shared_ptr<Player> player) {
+        static LatencyHistogram& histogram{ query_latency("Save") };
+        ScopedLatency latency{ histogram };
         try {
             PlayerDB player_db{};
             (*m_connection)(update(player_db).set(
@@ -85,12 +101,35 @@ namespace GTServer {
         return false;
     } 
     bool PlayerTable::Load(std::shared_ptr<Player> player) {
+        const auto& user_id{ this->Authenticate(player->GetLoginDetail()->m_tank_id_name, player->GetLoginDetail()->m_tank_id_pass) };
+        if (!user_id)
+            return false;
+        return this->LoadProfile(player, user_id.value());
+    }
+    std::optional<uint32_t> PlayerTable::Authenticate(const std::string& tank_id_name, const std::string& tank_id_pass) {
+        static LatencyHistogram& histogram{ query_latency("Authenticate") };
+        ScopedLatency latency{ histogram };
         try {
             PlayerDB player_db{};
-            for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(
-                player_db.tank_id_name == player->GetLoginDetail()->m_tank_id_name &&
-                player_db.tank_id_pass == player->GetLoginDetail()->m_tank_id_pass
+            for (const auto &row : (*m_connection)(select(player_db.id).from(player_db).where(
+                player_db.tank_id_name == tank_id_name &&
+                player_db.tank_id_pass == tank_id_pass
             ).limit(1u))) {
+                if (row._is_valid)
+                    return static_cast<uint32_t>(row.id);
+            }
+        }
+        catch(const std::exception &e) {
+            return std::nullopt;
+        }
+        return std::nullopt;
+    }
+    bool PlayerTable::LoadProfile(std::shared_ptr<Player> player, const uint32_t& user_id) {
+        static LatencyHistogram& histogram{ query_latency("LoadProfile") };
+        ScopedLatency latency{ histogram };
+        try {
+            PlayerDB player_db{};
+            for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(player_db.id == user_id).limit(1u))) {
                 if (!row._is_valid)
                     continue;
                 player->SetUserId(static_cast<uint32_t>(row.id));
@@ -117,6 +156,8 @@ namespace GTServer {
         return false;
     }
     bool PlayerTable::SerializeByName(std::shared_ptr<Player>& player, const std::string& name) {
+        static LatencyHistogram& histogram{ query_latency("SerializeByName") };
+        ScopedLatency latency{ histogram };
         PlayerDB player_db{};
         for (const auto& row : (*m_connection)(select(all_of(player_db)).from(player_db).where(player_db.raw_name.like(
             fmt::format("%{}%", name)
@@ -128,12 +169,14 @@ namespace GTServer {
         return false;
     }
     bool PlayerTable::SerializeByUserID(std::shared_ptr<Player>& player, const uint32_t& user_id) {
+        static LatencyHistogram& histogram{ query_latency("SerializeByUserID") };
+        ScopedLatency latency{ histogram };
         PlayerDB player_db{};
         for (const auto &row : (*m_connection)(select(all_of(player_db)).from(player_db).where(player_db.id == user_id).limit(1u))) {
             if (row._is_valid) {
                 player->GetLoginDetail()->m_tank_id_name = row.tank_id_name;
                 player->GetLoginDetail()->m_tank_id_pass = row.tank_id_pass;
-                return this->Load(player);
+                return this->LoadProfile(player, user_id);
             }
         }
         return false;
@@ -1,4 +1,5 @@
 #pragma once
+#include <optional>
 #include <type_traits>
 #include <variant>
 #include <fmt/core.h>
@@ -63,6 +64,8 @@ namespace GTServer {
         uint32_t Insert(std::shared_ptr<Player> player);
         bool Save(std::shared_ptr<Player> player);
         bool Load(std::shared_ptr<Player> player);
+        std::optional<uint32_t> Authenticate(const std::string& tank_id_name, const std::string& tank_id_pass);
+        bool LoadProfile(std::shared_ptr<Player> player, const uint32_t& user_id);
 
         bool SerializeByName(std::shared_ptr<Player>& player, const std::string& name);
         bool SerializeByUserID(std::shared_ptr<Player>& player, const uint32_t& user_id);
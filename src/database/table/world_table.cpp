@@ -3,9 +3,17 @@
 #include <database/interface/world_i.h>
 #include <config.h>
 #include <utils/file_manager.h>
+#include <server/metrics.h>
 
 namespace GTServer {
+    static LatencyHistogram& query_latency(const std::string& query) {
+        return Metrics::Get().GetHistogram("gtserver_database_query_duration_seconds", "Time spent on database queries",
+            fmt::format("table=\"world\",query=\"{}\"", query));
+    }
+
     bool WorldTable::is_exist(const std::string& name) {
+        static LatencyHistogram& histogram{ query_latency("is_exist") };
+        ScopedLatency latency{ histogram };
         WorldDB worlds{};
         for (const auto &row : (*m_connection)(select(all_of(worlds)).from(worlds).where(worlds.name == name)))
             if (row._is_valid)
@@ -14,6 +22,8 @@ namespace GTServer {
     }
 
     uint32_t WorldTable::insert(std::shared_ptr<World> world) {
+        static LatencyHistogram& histogram{ query_latency("insert") };
+        ScopedLatency latency{ histogram };
         if (this->is_exist(world->GetName()))
             return 0;
         WorldDB world_db{};
@@ -38,7 +48,9 @@ namespace GTServer {
         FileManager::write_all_bytes(world_path, reinterpret_cast<char*>(tiles.data()), tiles.size());
         return id;
     }
-    bool WorldTable::save(std::shared_ptr<World> world) {
+    bool WorldTable::save(std::shared_ptr<const WorldSnapshot> world) {
+        static LatencyHistogram& histogram{ query_latency("save") };
+        ScopedLatency latency{ histogram };
         try {
             if (!m_connection->is_valid()) {
                 fmt::print("connection is dead, reconnecting...\n");
@@ -59,8 +71,12 @@ namespace GTServer {
                 world_db.base_weather_id = world->GetBaseWeatherId()
             ).where(world_db.id == world->GetID()));
             const std::string& world_path{ fmt::format("{}_{}.bin", config::server::worlds_dir, world->GetID()) };
+            const std::string& temp_path{ fmt::format("{}.tmp", world_path) };
             auto tiles{ world->PackTiles(true) };
-            FileManager::write_all_bytes(world_path, reinterpret_cast<char*>(tiles.data()), tiles.size());
+            // never leave a half written tile file behind, the journal is only replayed on top of a complete one
+            if (!FileManager::write_all_bytes(temp_path, reinterpret_cast<char*>(tiles.data()), tiles.size()))
+                return false;
+            std::filesystem::rename(temp_path, world_path);
             return true;
         }
         catch(const std::exception &e) {
@@ -70,6 +86,8 @@ namespace GTServer {
         return false;
     }
     bool WorldTable::load(std::shared_ptr<World> world) {
+        static LatencyHistogram& histogram{ query_latency("load") };
+        ScopedLatency latency{ histogram };
         WorldDB world_db{};
         for (const auto &row : (*m_connection)(select(all_of(world_db)).from(world_db).where(
             world_db.name == world->GetName()
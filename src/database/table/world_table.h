@@ -13,7 +13,8 @@ namespace GTServer {
         bool is_exist(const std::string& name);
 
         uint32_t insert(std::shared_ptr<World> world);
-        bool save(std::shared_ptr<World> world);
+        // reads only from the snapshot, so it doesn't have to run on the game thread
+        bool save(std::shared_ptr<const WorldSnapshot> world);
         bool load(std::shared_ptr<World> world);
 
     private:
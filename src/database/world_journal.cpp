@@ -0,0 +1,309 @@
+#include <database/world_journal.h>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <fmt/core.h>
+#include <config.h>
+#include <utils/binary_reader.h>
+#include <utils/binary_writer.h>
+#include <utils/file_manager.h>
+#include <world/world.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace GTServer {
+    static uint32_t checksum(const char* data, const std::size_t& size) {
+        uint32_t hash = 0x811C9DC5;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x01000193;
+        }
+        return hash;
+    }
+    static bool sync_file(std::FILE* file) {
+        if (std::fflush(file) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+    template <typename T>
+    static void append(std::string& buffer, const T& value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    WorldJournal::~WorldJournal() {
+        this->Stop();
+    }
+
+    bool WorldJournal::Start() {
+        if (m_running.load())
+            return true;
+        m_commit_latency = &Metrics::Get().GetHistogram("gtserver_world_journal_commit_duration_seconds", "Time spent writing and syncing a group of journal records");
+        m_records = &Metrics::Get().GetCounter("gtserver_world_journal_records_total", "Tile and object records appended to world journals");
+        m_running.store(true);
+        m_thread = std::thread{ &WorldJournal::WriterThread, this };
+        return true;
+    }
+    void WorldJournal::Stop() {
+        if (m_running.exchange(false)) {
+            m_condition.notify_all();
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+        this->WritePending();
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::scoped_lock lock{ m_mutex };
+        for (auto& [world_id, journal] : m_journals) {
+            if (journal.m_file)
+                std::fclose(journal.m_file);
+            journal.m_file = nullptr;
+        }
+    }
+
+    void WorldJournal::Commit(std::shared_ptr<World> world) {
+        if (!world || world->GetID() < 1)
+            return;
+        const World::JournalChanges changes{ world->TakeJournalChanges() };
+        if (changes.IsEmpty())
+            return;
+
+        std::string buffer{};
+        std::size_t offset{};
+        std::vector<uint8_t> tile_data{};
+        auto& tiles{ world->GetTiles() };
+        for (const auto& index : changes.m_tiles) {
+            if (index >= tiles.size())
+                continue;
+            Tile& tile{ tiles[index] };
+            tile_data.assign(tile.GetMemoryUsage(true), 0);
+            BinaryWriter writer{ tile_data.data() };
+            tile.Pack(writer, true);
+
+            BeginRecord(buffer, offset, RECORD_TYPE_TILE);
+            append<uint32_t>(buffer, index);
+            buffer.append(reinterpret_cast<const char*>(tile_data.data()), writer.get_pos());
+            EndRecord(buffer, offset);
+        }
+        auto& objects{ world->GetObjects() };
+        for (const auto& object_id : changes.m_objects) {
+            auto it{ objects.find(object_id) };
+            if (it == objects.end()) {
+                BeginRecord(buffer, offset, RECORD_TYPE_OBJECT_REMOVE);
+                append<int32_t>(buffer, object_id);
+                EndRecord(buffer, offset);
+                continue;
+            }
+            BeginRecord(buffer, offset, RECORD_TYPE_OBJECT);
+            append<int32_t>(buffer, object_id);
+            append<uint16_t>(buffer, it->second.m_item_id);
+            append<float>(buffer, it->second.m_pos.m_x);
+            append<float>(buffer, it->second.m_pos.m_y);
+            append<uint8_t>(buffer, it->second.m_item_amount);
+            append<uint8_t>(buffer, it->second.m_flags);
+            EndRecord(buffer, offset);
+        }
+        if (changes.m_meta) {
+            BeginRecord(buffer, offset, RECORD_TYPE_META);
+            append<uint32_t>(buffer, world->GetFlags());
+            append<int32_t>(buffer, world->GetOwnerId());
+            append<int32_t>(buffer, world->GetMainLock());
+            append<uint32_t>(buffer, world->GetWeatherId());
+            append<uint32_t>(buffer, world->GetBaseWeatherId());
+            append<uint32_t>(buffer, world->GetObjectId());
+            EndRecord(buffer, offset);
+        }
+        m_records->Increase(changes.m_tiles.size() + changes.m_objects.size() + (changes.m_meta ? 1 : 0));
+
+        std::scoped_lock lock{ m_mutex };
+        Journal& journal{ m_journals[world->GetID()] };
+        journal.m_pending.append(buffer);
+    }
+    bool WorldJournal::Flush(const int32_t& world_id) {
+        return this->WritePending(world_id);
+    }
+    void WorldJournal::Checkpoint(const int32_t& world_id) {
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::scoped_lock lock{ m_mutex };
+        if (auto it = m_journals.find(world_id); it != m_journals.end()) {
+            if (it->second.m_file)
+                std::fclose(it->second.m_file);
+            m_journals.erase(it);
+        }
+        std::error_code ec{};
+        std::filesystem::remove(GetPath(world_id), ec);
+    }
+    void WorldJournal::Discard(const int32_t& world_id) {
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::scoped_lock lock{ m_mutex };
+        auto it{ m_journals.find(world_id) };
+        if (it == m_journals.end())
+            return;
+        if (it->second.m_file)
+            std::fclose(it->second.m_file);
+        m_journals.erase(it);
+    }
+
+    std::size_t WorldJournal::Replay(std::shared_ptr<World> world) {
+        const std::string path{ GetPath(world->GetID()) };
+        if (!std::filesystem::exists(path)) {
+            // setters used while loading from the database mark the meta as changed
+            world->TakeJournalChanges();
+            return 0;
+        }
+        std::vector<uint8_t> content{ FileManager::read_all_bytes(path) };
+        const char* data{ reinterpret_cast<const char*>(content.data()) };
+
+        auto& tiles{ world->GetTiles() };
+        auto& objects{ world->GetObjects() };
+        std::size_t pos{ 0 }, records{ 0 };
+        while (pos + RECORD_HEADER_SIZE <= content.size()) {
+            uint32_t length{}, hash{};
+            std::memcpy(&length, data + pos, sizeof(uint32_t));
+            std::memcpy(&hash, data + pos + sizeof(uint32_t), sizeof(uint32_t));
+            if (length < sizeof(uint8_t) + sizeof(int32_t) || pos + RECORD_HEADER_SIZE + length > content.size())
+                break;
+            uint8_t* payload{ content.data() + pos + RECORD_HEADER_SIZE };
+            if (checksum(reinterpret_cast<const char*>(payload), length) != hash)
+                break;
+
+            BinaryReader br{ payload, length };
+            switch (br.read<uint8_t>()) {
+            case RECORD_TYPE_TILE: {
+                const uint32_t index{ br.read<uint32_t>() };
+                if (index >= tiles.size() || length <= sizeof(uint8_t) + sizeof(uint32_t))
+                    break;
+                Tile tile{};
+                tile.Serialize(br);
+                tiles[index] = std::move(tile);
+            } break;
+            case RECORD_TYPE_OBJECT: {
+                const int32_t object_id{ br.read<int32_t>() };
+                WorldObject object{};
+                object.m_item_id = br.read<uint16_t>();
+                object.m_pos = CL_Vec2f{ br.read<float>(), br.read<float>() };
+                object.m_item_amount = br.read<uint8_t>();
+                object.m_flags = br.read<uint8_t>();
+                objects.insert_or_assign(object_id, object);
+            } break;
+            case RECORD_TYPE_OBJECT_REMOVE: {
+                objects.erase(br.read<int32_t>());
+            } break;
+            case RECORD_TYPE_META: {
+                world->SetFlags(br.read<uint32_t>());
+                world->SetOwnerId(br.read<int32_t>());
+                world->SetMainLock(br.read<int32_t>());
+                world->SetWeatherId(br.read<uint32_t>());
+                world->SetBaseWeatherId(br.read<uint32_t>());
+                world->SetObjectId(br.read<uint32_t>());
+            } break;
+            default:
+                break;
+            }
+            pos += RECORD_HEADER_SIZE + length;
+            ++records;
+        }
+        if (pos != content.size()) {
+            // torn write at the end, later records never reached the disk completely
+            fmt::print("WorldJournal -> discarding {} bytes of damaged records in {}\n", content.size() - pos, path);
+            std::error_code ec{};
+            std::filesystem::resize_file(path, pos, ec);
+        }
+        // replayed state is written back with the next checkpoint, not before
+        if (records > 0)
+            world->MarkDirty();
+        world->TakeJournalChanges();
+        std::scoped_lock lock{ m_mutex };
+        m_journals[world->GetID()].m_size = pos;
+        return records;
+    }
+
+    std::size_t WorldJournal::GetSize(const int32_t& world_id) const {
+        std::scoped_lock lock{ m_mutex };
+        if (auto it = m_journals.find(world_id); it != m_journals.end())
+            return it->second.m_size + it->second.m_pending.size();
+        return 0;
+    }
+
+    std::string WorldJournal::GetPath(const int32_t& world_id) {
+        return fmt::format("{}_{}.journal", config::server::worlds_dir, world_id);
+    }
+    void WorldJournal::BeginRecord(std::string& buffer, std::size_t& offset, const eRecordType& type) {
+        offset = buffer.size();
+        buffer.append(RECORD_HEADER_SIZE, '\0');
+        buffer.push_back(static_cast<char>(type));
+    }
+    void WorldJournal::EndRecord(std::string& buffer, const std::size_t& offset) {
+        const char* payload{ buffer.data() + offset + RECORD_HEADER_SIZE };
+        const uint32_t length{ static_cast<uint32_t>(buffer.size() - offset - RECORD_HEADER_SIZE) };
+        const uint32_t hash{ checksum(payload, length) };
+        std::memcpy(buffer.data() + offset, &length, sizeof(uint32_t));
+        std::memcpy(buffer.data() + offset + sizeof(uint32_t), &hash, sizeof(uint32_t));
+    }
+
+    bool WorldJournal::WritePending(const int32_t& world_id) {
+        std::scoped_lock io_lock{ m_io_mutex };
+        std::vector<std::pair<int32_t, std::string>> pending{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            for (auto& [id, journal] : m_journals) {
+                if (journal.m_pending.empty() || (world_id != -1 && id != world_id))
+                    continue;
+                pending.emplace_back(id, std::move(journal.m_pending));
+                journal.m_pending.clear();
+            }
+        }
+        if (pending.empty())
+            return true;
+
+        ScopedLatency latency{ *m_commit_latency };
+        bool ret{ true };
+        for (auto& [id, data] : pending) {
+            std::FILE* file{ nullptr };
+            {
+                std::scoped_lock lock{ m_mutex };
+                file = m_journals[id].m_file;
+            }
+            if (!file)
+                file = std::fopen(GetPath(id).c_str(), "ab");
+            long previous{ -1 };
+            if (file && std::fseek(file, 0, SEEK_END) == 0)
+                previous = std::ftell(file);
+            if (previous < 0 || std::fwrite(data.data(), 1, data.size(), file) != data.size() || !sync_file(file)) {
+                fmt::print("WorldJournal -> failed to write {} bytes to {}\n", data.size(), GetPath(id));
+                ret = false;
+                // a partial record would end the replay early, the file goes back to where it was and the records are kept for the next try
+                if (file)
+                    std::fclose(file);
+                if (previous >= 0) {
+                    std::error_code ec{};
+                    std::filesystem::resize_file(GetPath(id), static_cast<std::uintmax_t>(previous), ec);
+                }
+                std::scoped_lock lock{ m_mutex };
+                Journal& journal{ m_journals[id] };
+                journal.m_file = nullptr;
+                journal.m_pending.insert(0, data);
+                continue;
+            }
+            std::scoped_lock lock{ m_mutex };
+            Journal& journal{ m_journals[id] };
+            journal.m_file = file;
+            journal.m_size += data.size();
+        }
+        return ret;
+    }
+    void WorldJournal::WriterThread() {
+        while (m_running.load()) {
+            {
+                std::unique_lock lock{ m_mutex };
+                m_condition.wait_for(lock, config::journal::commit_interval, [&] { return !m_running.load(); });
+            }
+            this->WritePending();
+        }
+    }
+}
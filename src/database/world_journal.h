@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <server/metrics.h>
+
+namespace GTServer {
+    class World;
+
+    // write-ahead journal of tile/object changes, one file per world next to its tile file.
+    // changes are encoded on the game thread by Commit() and fsynced in groups by a writer thread,
+    // a full WorldPool::SaveWorld is the checkpoint that removes the journal again.
+    class WorldJournal {
+    public:
+        WorldJournal() = default;
+        ~WorldJournal();
+
+        bool Start();
+        void Stop();
+
+        void Commit(std::shared_ptr<World> world);
+        // blocks until everything queued for the world is on disk
+        bool Flush(const int32_t& world_id);
+        void Checkpoint(const int32_t& world_id);
+        // closes the journal and drops what wasn't written yet, the file is left for whoever owns the world now
+        void Discard(const int32_t& world_id);
+        std::size_t Replay(std::shared_ptr<World> world);
+
+        [[nodiscard]] std::size_t GetSize(const int32_t& world_id) const;
+
+    public:
+        static WorldJournal& Get() { static WorldJournal ret; return ret; }
+
+    private:
+        enum eRecordType : uint8_t {
+            RECORD_TYPE_TILE = 1,
+            RECORD_TYPE_OBJECT,
+            RECORD_TYPE_OBJECT_REMOVE,
+            RECORD_TYPE_META
+        };
+        static constexpr std::size_t RECORD_HEADER_SIZE = sizeof(uint32_t) * 2;
+
+        struct Journal {
+            std::FILE* m_file{ nullptr };
+            std::size_t m_size{ 0 };
+            std::string m_pending{};
+        };
+
+        static std::string GetPath(const int32_t& world_id);
+        static void BeginRecord(std::string& buffer, std::size_t& offset, const eRecordType& type);
+        static void EndRecord(std::string& buffer, const std::size_t& offset);
+
+        bool WritePending(const int32_t& world_id = -1);
+        void WriterThread();
+
+    private:
+        mutable std::mutex m_mutex{};
+        std::mutex m_io_mutex{};
+        std::condition_variable m_condition{};
+        std::unordered_map<int32_t, Journal> m_journals{};
+
+        std::atomic<bool> m_running{ false };
+        std::thread m_thread{};
+
+        LatencyHistogram* m_commit_latency{ nullptr };
+        Counter* m_records{ nullptr };
+    };
+}
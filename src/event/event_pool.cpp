@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <event/event_pool.h>
 #include <fmt/core.h>
+#include <magic_enum.hpp>
 #include <utils/text.h>
 
 #include <event/tank_events/OnItemActiveObjectRequest.h>
@@ -34,6 +35,9 @@
 namespace GTServer {
     EventPool::EventPool() {
         fmt::print("Initializing EventPool\n");
+        for (std::size_t type = 0; type < NUM_EVENTS; ++type)
+            m_unhandled[type] = &Metrics::Get().GetCounter("gtserver_events_unhandled_total", "Events that had no registered handler",
+                fmt::format("type=\"{}\"", magic_enum::enum_name(static_cast<eEventType>(type))));
     }
     EventPool::~EventPool() {
         this->unload_events();
@@ -79,13 +83,18 @@ namespace GTServer {
     }
 
     void EventPool::reg_generic(const std::string& ev, std::function<void(EventContext&)> fn) {
-        m_events[EVENT_TYPE_GENERIC_TEXT].push_back({ utils::quick_hash(ev), fn });
+        this->reg_event(EVENT_TYPE_GENERIC_TEXT, ev, ev, fn);
     }
     void EventPool::reg_action(const std::string& ev, std::function<void(EventContext&)> fn) {
-         m_events[EVENT_TYPE_ACTION].push_back({ utils::quick_hash(ev), fn });
+        this->reg_event(EVENT_TYPE_ACTION, ev, ev, fn);
     }
     void EventPool::reg_packet(const uint8_t& ev, std::function<void(EventContext&)> fn) {
-         m_events[EVENT_TYPE_GAME_PACKET].push_back({ utils::quick_hash("gup_" + std::to_string(ev)), fn });
+        this->reg_event(EVENT_TYPE_GAME_PACKET, "gup_" + std::to_string(ev), std::string{ magic_enum::enum_name(static_cast<eNetPacketType>(ev)) }, fn);
+    }
+    void EventPool::reg_event(const eEventType& type, const std::string& ev, const std::string& name, std::function<void(EventContext&)> fn) {
+        LatencyHistogram& latency = Metrics::Get().GetHistogram("gtserver_event_duration_seconds", "Time spent executing an event handler",
+            fmt::format("type=\"{}\",event=\"{}\"", magic_enum::enum_name(type), name));
+        m_events[type].push_back(Event{ .m_hash = utils::quick_hash(ev), .m_fn = fn, .m_latency = &latency });
     }
 
     std::size_t EventPool::get_registered_event(const eEventType& type) const {
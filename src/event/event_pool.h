@@ -4,11 +4,17 @@
 #include <proton/packet.h>
 #include <utils/text.h>
 #include <event/event_context.h>
+#include <server/metrics.h>
 
 namespace GTServer {
     class EventPool {
     public:
-        using event_list = std::vector<std::pair<uint32_t, std::function<void(EventContext&)>>>;
+        struct Event {
+            uint32_t m_hash;
+            std::function<void(EventContext&)> m_fn;
+            LatencyHistogram* m_latency;
+        };
+        using event_list = std::vector<Event>;
         using event_type = std::unordered_map<eEventType, event_list>;
 
     public:
@@ -31,15 +37,21 @@ namespace GTServer {
 
             const uint32_t& ev_hash{ utils::quick_hash(data) };
             for (const auto& ev : it->second) {
-                if (ev_hash != ev.first)
+                if (ev_hash != ev.m_hash)
                     continue;
-                ev.second(ctx);
+                ScopedLatency latency{ *ev.m_latency };
+                ev.m_fn(ctx);
                 return true;
             }
+            m_unhandled[type]->Increase();
             return false;
         }
 
+    private:
+        void reg_event(const eEventType& type, const std::string& ev, const std::string& name, std::function<void(EventContext&)> fn);
+
     private:
         event_type m_events;
+        std::array<Counter*, NUM_EVENTS> m_unhandled{};
     };
 }
\ No newline at end of file
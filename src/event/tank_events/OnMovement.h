@@ -7,11 +7,6 @@ namespace GTServer::events {
     void OnMovement(EventContext& ctx) {
         if (!ctx.m_player->IsFlagOn(PLAYERFLAG_IS_IN))
             return;
-        for (const auto& mod : ctx.m_player->GetPlaymods()) {
-            if (mod.m_time.GetPassedTime() >= mod.m_time.GetTimeout() && mod.m_time.GetTimeout() != std::chrono::seconds(-1) && mod.m_type != PLAYMOD_TYPE_GHOST_IN_THE_SHELL && mod.m_type != PLAYMOD_TYPE_NICK && mod.m_type != PLAYMOD_TYPE_INVISIBLE) {
-                ctx.m_player->RemovePlaymod(mod.m_type);
-            }
-        }
         std::shared_ptr<WorldPool> world_pool{ ctx.m_server->GetWorldPool() };
         std::shared_ptr<World> world{ world_pool->GetWorld(ctx.m_player->GetWorld()) };
         if (!world)
@@ -63,8 +58,6 @@ namespace GTServer::events {
         else
             ctx.m_player->RemoveFlag(PLAYERFLAG_IS_FACING_LEFT);
 
-        world->Broadcast([&](const std::shared_ptr<Player>& player) {
-            player->SendPacket(NET_MESSAGE_GAME_PACKET, packet, sizeof(GameUpdatePacket));
-        });
+        world->BroadcastMovement(ctx.m_player, packet);
     }
 }
\ No newline at end of file
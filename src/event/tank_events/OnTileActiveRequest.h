@@ -72,6 +72,7 @@ namespace GTServer::events {
                 CL_Vec2f position = { static_cast<float>(main_door.m_x * 32), static_cast<float>(main_door.m_y * 32) };
                 if (dest_id.empty()) {
                     ctx.m_player->SetPosition(position.m_x, position.m_y);
+                    world->UpdatePlayerCell(ctx.m_player);
                     ctx.m_player->v_sender.OnSetPos(ctx.m_player->GetNetId(), position, 200);
                     return;
                 }
@@ -86,6 +87,7 @@ namespace GTServer::events {
                     }
                 }
                 ctx.m_player->SetPosition(position.m_x, position.m_y);
+                world->UpdatePlayerCell(ctx.m_player);
                 ctx.m_player->v_sender.OnSetPos(ctx.m_player->GetNetId(), position, 200);
                 return;
             }
@@ -27,5 +27,6 @@ namespace GTServer::events {
             tile_change_req::OnPlace(ctx, world, CL_Vec2i{ ctx.m_update_packet->m_int_x, ctx.m_update_packet->m_int_y });
         } break;
         }
+        world->MarkDirty(CL_Vec2i{ ctx.m_update_packet->m_int_x, ctx.m_update_packet->m_int_y });
     }
 }
\ No newline at end of file
@@ -66,7 +66,7 @@ namespace GTServer::events::tile_change_req {
                 });
             world->SendTileUpdate(tile, 0);
 
-            player->v_sender.OnTextOverlay(fmt::format("`w{} aged `${}``", fmt::format("{}", base->m_item_type == ITEMTYPE_SEED ? fmt::format("{} Tree", ItemDatabase::GetItem(base->m_id - 1)->m_name) : base->m_name), spray_text));
+            player->v_sender.OnTextOverlay(fmt::format("`w{} aged `${}``", fmt::format("{}", base->m_item_type == ITEMTYPE_SEED ? fmt::format("{} Tree", ItemDatabase::GetItem(base->m_id - 1)->m_name) : std::string{ base->m_name }), spray_text));
         } break;
         case ITEM_BEACH_BLAST: {
 
@@ -206,7 +206,7 @@ namespace GTServer::events::tile_change_req {
 
             world->SendTileUpdate(tile, 0);
             world->Broadcast([&](const std::shared_ptr<Player>& ply) {
-                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket));
+                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE);
             ply->v_sender.OnConsoleMessage("`7[```4MWAHAHAHA!! FIRE FIRE FIRE```7]``");
             ply->v_sender.OnTalkBubble(player->GetNetId(), "`7[```4MWAHAHAHA!! FIRE FIRE FIRE```7]``");
                 });
@@ -272,7 +272,7 @@ namespace GTServer::events::tile_change_req {
                     effect_packet.m_pos_x = (tile->GetPosition().m_x * 32) + 15;
                     effect_packet.m_pos_y = (tile->GetPosition().m_y * 32) + 15;
 
-                    world->Broadcast([&](const std::shared_ptr<Player>& ply) { ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket)); });
+                    world->Broadcast([&](const std::shared_ptr<Player>& ply) { ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE); });
                 }
             }
             world->SendTileUpdate(packs);
@@ -106,7 +106,7 @@ namespace GTServer::events::tile_change_req {
                     effect_packet.m_item_id_alt = item->m_id;
                     effect_packet.m_target_net_id = player->GetNetId();
                     effect_packet.m_particle_size_alt = 1;
-                    world->Broadcast([&](const std::shared_ptr<Player>& ply) { ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket)); });
+                    world->Broadcast([&](const std::shared_ptr<Player>& ply) { ply->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE); });
                     world->SendTileUpdate(tile, 0);
                 } return;
                 case ITEMTYPE_MANNEQUIN: {
@@ -173,7 +173,7 @@ namespace GTServer::events::tile_change_req {
                             update_packet.m_pos_x = (position.m_x * 32) + 15;
                             update_packet.m_pos_y = (position.m_y * 32) + 15;
                             world->Broadcast([&](const std::shared_ptr<Player>& ply) {
-                                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket));
+                                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE);
                             });
                             world->SendTileUpdate(tile, 0);
                             return;
@@ -316,7 +316,7 @@ namespace GTServer::events::tile_change_req {
                             update_packet.m_pos_x = (position.m_x * 32) + 15;
                             update_packet.m_pos_y = (position.m_y * 32) + 15;
                             world->Broadcast([&](const std::shared_ptr<Player>& ply) {
-                                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket));
+                                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE);
                             });
                             world->SendTileUpdate(tile, 0);
                             return;
@@ -339,7 +339,7 @@ namespace GTServer::events::tile_change_req {
                         update_packet.m_pos_x = (position.m_x * 32) + 15;
                         update_packet.m_pos_y = (position.m_y * 32) + 15;
                         world->Broadcast([&](const std::shared_ptr<Player>& ply) {
-                            ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket));
+                            ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE);
                             ply->SendPacket(NET_MESSAGE_GAME_PACKET, packet, sizeof(GameUpdatePacket) + packet->m_data_size);
                         });
 
@@ -36,7 +36,7 @@ namespace GTServer::events::tile_change_req {
             update_packet.m_pos_x = (tile->GetPosition().m_x * 32) + 15;
             update_packet.m_pos_y = (tile->GetPosition().m_y * 32) + 15;
             world->Broadcast([&](const std::shared_ptr<Player>& ply) {
-                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket));
+                ply->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE);
             });
             world->SendTileUpdate(tile, 0);
             return;
@@ -473,7 +473,7 @@ namespace GTServer::events::tile_change_req {
 
                 cloth = ITEM_BLANK;
                 world->SendTileUpdate(tile);
-                world->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket)); });
+                world->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE); });
                 return;
             }
         } break;
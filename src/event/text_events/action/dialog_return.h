@@ -5,6 +5,7 @@
 #include <event/event_context.h>
 #include <proton/utils/text_scanner.h>
 #include <database/database.h>
+#include <database/kv_store.h>
 #include <discord/discord_bot.h>
 #include <store/store_manager.h>
 #include <utils/text.h>
@@ -101,7 +102,7 @@ namespace GTServer::events {
                         custom_count = item->m_max_amount - ((ctx.m_player->m_inventory.GetItemCount(item->m_id) + count) - count);
                     if (ctx.m_player->m_inventory.Add(item->m_id, custom_count != 0 ? custom_count : count, true)) {
                         added_items.push_back(item->m_id);
-                        claimed_items.push_back({ item->m_name, (custom_count != 0 ? custom_count : count) });
+                        claimed_items.push_back({ std::string{ item->m_name }, (custom_count != 0 ? custom_count : count) });
                     }
                 }
                 ctx.m_player->SendLog(fmt::format("Claimed `w{}``/`w{}`` Selected Items", added_items.size(), items_list.size()));
@@ -187,7 +188,7 @@ namespace GTServer::events {
                     effect_packet.m_pos_x = (tile_next->GetPosition().m_x * 32) + 15;
                     effect_packet.m_pos_y = (tile_next->GetPosition().m_y * 32) + 15;
 
-                    world->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket)); });
+                    world->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, &effect_packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE); });
                     world->SendTileUpdate(tile_next, 0);
                 } return;
                 default:
@@ -299,6 +300,7 @@ namespace GTServer::events {
                         ctx.m_server->GetWorldPool()->OnPlayerSyncing(world2, ctx.m_player);
                         if (ctx.m_player->GetRole() > PLAYER_ROLE_MODERATOR) {
                             ctx.m_player->SetPosition(target->GetPosition().m_x, target->GetPosition().m_y);
+                            world2->UpdatePlayerCell(ctx.m_player);
                         }
                     }
                 } break;
@@ -319,10 +321,7 @@ namespace GTServer::events {
                             playerthing2->SendLog("`5** `$The Ancient Ones `ohave `4banned`o {} `5** `w(`4/rules`o to see the rules!)", target->GetDisplayName(world));
                         }
                         auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                        std::ofstream ban_log_file_check;
-                        ban_log_file_check.open(fmt::format("bans/{}.txt", target->GetRawName()), std::ios::trunc | std::ios::out);
-                        std::ofstream ban_log_file(fmt::format("bans/{}.txt", target->GetRawName()), std::ios_base::app);
-                        ban_log_file << ban_reason << std::endl;
+                        KeyValueStore::Get().Put(StoreKey::ban_reason(target->GetRawName()), ban_reason);
                         std::ofstream ban_log_file_main("banlogs.txt", std::ios_base::app);
                         ban_log_file_main << target->GetRawName() << " was banned by " << player->GetRawName() << " at " << std::put_time(std::localtime(&now), "%c %Z") << std::endl;
                         fmt::print("{} was banned by {}\n", target->GetDisplayName(world), player->GetRawName());
@@ -614,6 +613,7 @@ namespace GTServer::events {
                         for (auto& t : world->GetTiles()) {
                             if (t.HasAccess(user_id) && tile->GetParent() != tile->GetPosition().m_x + tile->GetPosition().m_y * world->GetSize().m_x) {
                                 t.RemoveAccess(user_id);
+                                world->MarkDirty(t.GetPosition());
                             }
                         }
                     }
@@ -648,6 +648,7 @@ namespace GTServer::events {
                         for (auto& t : world->GetTiles()) {
                             if (t.GetBaseItem()->m_item_type != ITEMTYPE_LOCK && t.GetParent() == tile->GetPosition().m_x + tile->GetPosition().m_y * world->GetSize().m_x) {
                                 t.AddAccess(player->GetUserId());
+                                world->MarkDirty(t.GetPosition());
                             }
                         }
                         world->SyncPlayerData(player);
@@ -1054,10 +1055,16 @@ namespace GTServer::events {
                 auto world{ ctx.m_server->GetWorldPool()->GetWorld(ctx.m_player->GetWorld()) };
                 if (!world)
                     return;
+                steady_clock::duration wait{};
+                if (ctx.m_player->m_rate_limiter.Check(RATE_CLASS_RENDER, wait) != RATE_ACTION_ALLOW) {
+                    ctx.m_player->SendLog("`4Oops! `oyou can render your world again in `w{}`` seconds.", std::chrono::ceil<std::chrono::seconds>(wait).count());
+                    return;
+                }
                 ctx.m_servers->AddQueue(QUEUE_TYPE_RENDER_WORLD, ServerQueue {
                     .m_keyword = world->GetName(),
                     .m_player = ctx.m_player,
-                    .m_world = world
+                    .m_world = world,
+                    .m_snapshot = world->CreateSnapshot()
                 });
             } break;
             default: {
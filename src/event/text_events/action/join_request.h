@@ -1,43 +1,14 @@
 #pragma once
 #include <world/world.h>
 #include <player/player_pool.h>
+#include <server/cluster_client.h>
 
 namespace GTServer::events {
     void join_request(EventContext& ctx) {
         std::shared_ptr<Player> player{ ctx.m_player };
         std::string world_name = ctx.m_parser.Get("name", 1);
         std::transform(world_name.begin(), world_name.end(), world_name.begin(), ::toupper);
-        std::shared_ptr<WorldPool> world_pool{ ctx.m_server->GetWorldPool() };
-        std::shared_ptr<World> world{ world_pool->GetWorld(world_name) };
-        if (player->HasPlaymod(PLAYMOD_TYPE_BAN)) {
-            player->v_sender.OnConsoleMessage("You have been banned from BetterGrowtopia.");
-            player->v_sender.OnFailedToEnterWorld(true);
-            return;
-        }
-        if (player->GetRole() >= PLAYER_ROLE_MODERATOR) {
-            player->SetPunchRange(500);
-            player->SetBuildRange(500);
-        }
-        if (world->IsFlagOn(WORLDFLAG_NUKED) && player->GetRole() < PLAYER_ROLE_MODERATOR) {
-            player->v_sender.OnConsoleMessage("Sorry, that world has been removed from BetterGrowtopia to keep our players safe.");
-            player->v_sender.OnFailedToEnterWorld(true);
-            return;
-        }
-        if (!player->IsFlagOn(PLAYERFLAG_IS_IN)) {
-            player->Disconnect(0U);
-            return;
-        }
-        for (const auto& mod : ctx.m_player->GetPlaymods()) {
-            if (mod.m_time.GetPassedTime() >= mod.m_time.GetTimeout() && mod.m_time.GetTimeout() != std::chrono::seconds(-1) && mod.m_type != PLAYMOD_TYPE_GHOST_IN_THE_SHELL && mod.m_type != PLAYMOD_TYPE_NICK && mod.m_type != PLAYMOD_TYPE_INVISIBLE) {
-                ctx.m_player->RemovePlaymod(mod.m_type);
-            }
-        }
-        if (world->HasBan(player) && player->GetRole() < PLAYER_ROLE_DEVELOPER) {
-            player->v_sender.OnConsoleMessage("`4Oops`o, you are currently banned from that world, come back to that world soon!");
-            player->v_sender.OnFailedToEnterWorld(true);
-            return;
-        }
-
+        // checked before the gateway is asked for it, a claim is kept for as long as the world is loaded
         if (world_name.empty())
             world_name = std::string{ "START" };
 
@@ -72,16 +43,63 @@ namespace GTServer::events {
             player->v_sender.OnFailedToEnterWorld(true);
             return;
         }
-        if (player->HasPlaymod(PLAYMOD_TYPE_CURSE) && world_name != "HELL") {
-            player->v_sender.OnConsoleMessage("You are only able to go to HELL since you broke the rules!");
-            std::shared_ptr<World> worldHELL{ world_pool->GetWorld("HELL")};
-            world = worldHELL;
+        // cursed players end up in HELL whatever they asked for, so that's the world that has to be here
+        const std::string target{ player->HasPlaymod(PLAYMOD_TYPE_CURSE) ? std::string{ "HELL" } : world_name };
+        // the world is loaded on another worker, the player is sent over instead of loading a second copy
+        if (const int32_t owner{ ClusterClient::Get().GetRemoteOwner(target) }; owner != -1 && ClusterClient::Get().Transfer(player, target, owner))
+            return;
+        // nothing is loaded or journaled before the gateway gave us the world, the join runs again once it answered
+        if (ClusterClient::Get().NeedsClaim(target)) {
+            EventContext deferred{ ctx };
+            deferred.m_update_packet = nullptr;
+            ClusterClient::Get().ClaimWorld(target, [deferred, target](const int32_t& owner) mutable {
+                std::shared_ptr<Player> player{ deferred.m_player };
+                // the peer may have been handed to someone else since, only the pool knows who's still here
+                if (deferred.m_server->GetPlayerPool()->GetPlayer(player->GetConnectID()) != player)
+                    return;
+                if (owner == ClusterClient::Get().GetWorkerId()) {
+                    deferred.m_events->execute(EVENT_TYPE_ACTION, "join_request", deferred);
+                    return;
+                }
+                if (owner == -1 || !ClusterClient::Get().Transfer(player, target, owner))
+                    player->v_sender.OnFailedToEnterWorld(true);
+            });
+            return;
         }
+        std::shared_ptr<WorldPool> world_pool{ ctx.m_server->GetWorldPool() };
+        std::shared_ptr<World> world{ world_pool->GetWorld(target) };
+        if (player->HasPlaymod(PLAYMOD_TYPE_BAN)) {
+            player->v_sender.OnConsoleMessage("You have been banned from BetterGrowtopia.");
+            player->v_sender.OnFailedToEnterWorld(true);
+            return;
+        }
+        if (player->GetRole() >= PLAYER_ROLE_MODERATOR) {
+            player->SetPunchRange(500);
+            player->SetBuildRange(500);
+        }
+        if (world->IsFlagOn(WORLDFLAG_NUKED) && player->GetRole() < PLAYER_ROLE_MODERATOR) {
+            player->v_sender.OnConsoleMessage("Sorry, that world has been removed from BetterGrowtopia to keep our players safe.");
+            player->v_sender.OnFailedToEnterWorld(true);
+            return;
+        }
+        if (!player->IsFlagOn(PLAYERFLAG_IS_IN)) {
+            player->Disconnect(0U);
+            return;
+        }
+        if (world->HasBan(player) && player->GetRole() < PLAYER_ROLE_DEVELOPER) {
+            player->v_sender.OnConsoleMessage("`4Oops`o, you are currently banned from that world, come back to that world soon!");
+            player->v_sender.OnFailedToEnterWorld(true);
+            return;
+        }
+
+        if (player->HasPlaymod(PLAYMOD_TYPE_CURSE) && world_name != "HELL")
+            player->v_sender.OnConsoleMessage("You are only able to go to HELL since you broke the rules!");
 
         if (!world) {
             player->v_sender.OnFailedToEnterWorld(true);
             return;
         }
+        ClusterClient::Get().ClaimWorld(world->GetName());
         if (world->HasPlayer(player)) {
             world_pool->OnPlayerLeave(world, player, false);
             player->v_sender.OnFailedToEnterWorld(true);
@@ -118,9 +136,7 @@ namespace GTServer::events {
                     }
                 }
                 });
-            WorldTable* db{ (WorldTable*)Database::GetTable(Database::DATABASE_WORLD_TABLE) };
-            if (!db->save(world))
-                fmt::print("WorldTable::save, Failed to save {}\n", world->GetName());
+            world_pool->SaveWorld(world);
             world->SyncPlayerData(player);
         }
         else {
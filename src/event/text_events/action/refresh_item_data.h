@@ -1,10 +1,11 @@
 #pragma once
+#include <server/item_data_stream.h>
 
 namespace GTServer::events {
     void refresh_item_data(EventContext& ctx) {
+        // sent by ItemDataStream once a slot is free
+        if (!ItemDataStream::Get().Request(ctx.m_player))
+            return;
         ctx.m_player->SendLog("One moment, updating item data...");
-
-        auto* packet = ItemDatabase::GetPacket();
-        ctx.m_player->SendPacket(NET_MESSAGE_GAME_PACKET, packet, sizeof(GameUpdatePacket) + packet->m_data_size);
     }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <server/login_pipeline.h>
 
 namespace GTServer::events {
     void tank_id_name(EventContext& ctx) {
@@ -31,6 +32,6 @@ namespace GTServer::events {
             ctx.m_player->Disconnect(0U);
             return;
         }
-        ctx.m_server->AddQueue(SERVERQUEUE_TYPE_LOGIN, ServerQueue{ .m_player = ctx.m_player });
+        ctx.m_servers->GetLoginPipeline()->Submit(ctx.m_player);
     }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
+#include <atomic>
 #include <iostream>
 #include <signal.h>
 #include <stdlib.h>
+#include <string_view>
 #include <thread>
 #include <vector>
 #include <filesystem>
@@ -8,11 +10,19 @@
 
 #include <discord/discord_bot.h>
 #include <database/database.h>
+#include <database/kv_store.h>
+#include <database/world_journal.h>
 #include <database/item/item_database.h>
 #include <event/event_pool.h>
 #include <server/http.h>
+#include <server/login_pipeline.h>
+#include <server/metrics.h>
+#include <server/cluster_client.h>
+#include <server/memory_report.h>
 #include <server/server.h>
+#include <server/server_gateway.h>
 #include <server/server_pool.h>
+#include <server/startup.h>
 #include <store/store_manager.h>
 #include <render/world_render.h>
 #include <command/command_manager.h>
@@ -20,8 +30,13 @@
 using namespace GTServer;
 std::shared_ptr<ServerPool> g_servers;
 std::shared_ptr<EventPool> g_events;
+std::atomic<bool> g_shutdown{ false };
 
-int main() {
+void on_signal(int) {
+    g_shutdown.store(true);
+}
+
+int main(int argc, char* argv[]) {
     fmt::print("starting {} V{}\n", SERVER_NAME, SERVER_VERSION);
     if (!std::filesystem::is_directory(config::server::worlds_dir))
         std::filesystem::create_directory(config::server::worlds_dir);
@@ -29,63 +44,139 @@ int main() {
         std::filesystem::create_directory(config::server::utils_dir);
     if (!std::filesystem::is_directory(config::server::renders_dir))
         std::filesystem::create_directory(config::server::renders_dir);
+
+    // no arguments runs a standalone server, --gateway spawns and fronts the workers, --worker N is one of them
+    bool gateway{ false };
+    int32_t worker_id{ -1 };
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{ argv[i] };
+        if (arg == "--gateway")
+            gateway = true;
+        else if (arg == "--worker" && i + 1 < argc)
+            worker_id = std::atoi(argv[++i]);
+    }
         
 #ifdef HTTP_SERVER
-    auto http_server{ std::make_unique<HTTPServer>(
-        std::string{ config::http::address.begin(), config::http::address.end() }, 
-        config::http::port
-    ) };
-    if (!http_server->listen())
-        fmt::print("failed to starting http server, please run an external http service.\n");
+    // server_data.php belongs to whoever owns the public port
+    std::unique_ptr<HTTPServer> http_server{};
+    if (worker_id == -1) {
+        http_server = std::make_unique<HTTPServer>(
+            std::string{ config::http::address.begin(), config::http::address.end() }, 
+            config::http::port
+        );
+        if (!http_server->listen())
+            fmt::print("failed to starting http server, please run an external http service.\n");
+    }
 #endif
-
-    Database& database{ Database::Get() };
-    if (!database.Connect()) {
-        fmt::print(" - failed to connect MySQL server, please check server configuration.\n");
-        return EXIT_FAILURE;
+    if (gateway) {
+        if (enet_initialize() != 0) {
+            fmt::print("failed to initialize enet, shutting down the gateway.\n");
+            return EXIT_FAILURE;
+        }
+        ServerGateway server_gateway{ argv[0] };
+        if (!server_gateway.Start()) {
+            fmt::print("failed to start the gateway, shutting down.\n");
+            return EXIT_FAILURE;
+        }
+#ifdef HTTP_SERVER
+        http_server->set_server_data(std::string{ config::http::gt::address }, server_gateway.GetPort());
+#endif
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+        while (!g_shutdown.load())
+            server_gateway.Poll();
+        server_gateway.Stop();
+#ifdef HTTP_SERVER
+        http_server->stop();
+#endif
+        enet_deinitialize();
+        return EXIT_SUCCESS;
     }
 
-    PlayerTribute& player_tribute{ PlayerTribute::get() }  ;
-    if (!player_tribute.build())
-        fmt::print(" - failed to build PlayerTribute\n");
-    else 
+    Startup startup{};
+    startup.AddStage("database", {}, [] {
+        if (Database::Get().Connect())
+            return true;
+        fmt::print(" - failed to connect MySQL server, please check server configuration.\n");
+        return false;
+    });
+    startup.AddStage("kv_store", {}, [worker_id] {
+        KeyValueStore& store{ KeyValueStore::Get() };
+        // the gateway owns the log, a worker only keeps the copy the gateway sends it once connected
+        if (worker_id != -1) {
+            store.OpenReplica([](const std::string& key, const std::optional<std::string>& value) {
+                ClusterClient::Get().StoreChanged(key, value);
+            });
+            return true;
+        }
+        if (!store.Open(config::store::path)) {
+            fmt::print(" - failed to open KeyValueStore at {}\n", config::store::path);
+            return false;
+        }
+        if (!store.Migrate())
+            fmt::print(" - failed to migrate legacy player files into KeyValueStore\n");
+        else
+            fmt::print(" - KeyValueStore -> {} keys loaded\n", store.GetKeyCount());
+        return true;
+    });
+    startup.AddStage("world_journal", {}, [] {
+        if (WorldJournal::Get().Start())
+            return true;
+        fmt::print(" - failed to start WorldJournal\n");
+        return false;
+    });
+    startup.AddStage("player_tribute", {}, [] {
+        PlayerTribute& player_tribute{ PlayerTribute::get() };
+        if (!player_tribute.build()) {
+            fmt::print(" - failed to build PlayerTribute\n");
+            return false;
+        }
         fmt::print(" - PlayerTribute is built with hash {}\n", player_tribute.get_hash());
-
-    ItemDatabase& items{ ItemDatabase::Get() };
-    if (!items.Serialize()) {
-        fmt::print("ItemDatabase::Serialize -> failed to load items.dat, please make sure the file is on /cache\n");
-        return EXIT_FAILURE;
-    }
-    items.ModifyIOSSupport();
-    items.Encode();
-    items.Kill();
-    if (!items.Serialize()) {
-        fmt::print(" - failed to serialization items.dat\n");
-    } else {
-        items.SerializeDetails();
+        return true;
+    }, Startup::STAGE_FLAG_NONE);
+    startup.AddStage("items", {}, [] {
+        ItemDatabase& items{ ItemDatabase::Get() };
+        if (!items.Load()) {
+            fmt::print("ItemDatabase::Load -> failed to load items.dat, please make sure the file is on /cache\n");
+            return false;
+        }
         fmt::print(" - items.dat -> {} items loaded with hash {}\n", items.GetItems().size(), items.GetHash());
-    }
-
-    StoreManager& store_manager{ StoreManager::Get() };
-    if (store_manager.Init()) {
+        return true;
+    });
+    startup.AddStage("store", {}, [] {
+        if (!StoreManager::Init())
+            return false;
         uint16_t size = 0;
-        for (auto& [type, items] : store_manager.GetItems())
+        for (auto& [type, items] : StoreManager::GetItems())
             size += items.size();
         fmt::print("StoreManager Initialized, {} items are loaded.\n", size);
-    }
-
-    WorldRender& world_render{ WorldRender::get() };
-    world_render.load_caches();
-
-    CommandManager& commands{ CommandManager::get() };
-    commands.register_commands();
-
-    g_events = std::make_shared<EventPool>();
-    g_events->load_events();
-
-    g_servers = std::make_shared<ServerPool>(g_events);
-    if (!g_servers->InitializeENet()) {
+        return true;
+    }, Startup::STAGE_FLAG_NONE);
+    // thousands of png decodes, renders are refused until it is done
+    startup.AddStage("render_caches", { "items" }, [] {
+        WorldRender::get().load_caches();
+        return true;
+    }, Startup::STAGE_FLAG_DEFERRED);
+    startup.AddStage("commands", {}, [] {
+        CommandManager::get().register_commands();
+        return true;
+    });
+    startup.AddStage("events", {}, [] {
+        g_events = std::make_shared<EventPool>();
+        g_events->load_events();
+        return true;
+    });
+    startup.AddStage("enet", { "events" }, [worker_id] {
+        g_servers = std::make_shared<ServerPool>(g_events);
+        if (worker_id != -1)
+            g_servers->SetPort(static_cast<uint16_t>(config::cluster::worker_base_port + worker_id));
+        if (g_servers->InitializeENet())
+            return true;
         fmt::print("failed to initialize enet, shutting down the server.\n");
+        return false;
+    });
+    if (!startup.Run()) {
+        fmt::print(" - a required startup stage failed, shutting down the server.\n");
         return EXIT_FAILURE;
     }
     /*
@@ -96,8 +187,40 @@ int main() {
     }, g_servers); */ // crash, not configured perfectly for now.
 
     g_servers->StartService();  
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (worker_id != -1 && !g_servers->GetServers().empty())
+        ClusterClient::Get().Start(worker_id, g_servers->GetServers().front()->GetPort());
+
+    Metrics& metrics{ Metrics::Get() };
+    // scrapes run on the http thread, they only read what the service loop published
+    metrics.AddGauge("gtserver_online_players", "Players connected to all instances", [] {
+        return static_cast<double>(g_servers->GetStats().m_players.load(std::memory_order_relaxed));
+    });
+    metrics.AddGauge("gtserver_loaded_worlds", "Worlds currently loaded in memory", [] {
+        return static_cast<double>(g_servers->GetStats().m_worlds.load(std::memory_order_relaxed));
+    });
+    metrics.AddGauge("gtserver_worlds_memory_bytes", "Sum of World::GetMemoryUsage over loaded worlds", [] {
+        return static_cast<double>(g_servers->GetStats().m_worlds_memory.load(std::memory_order_relaxed));
+    });
+    metrics.AddGauge("gtserver_queue_depth", "Jobs waiting in the server queues", [] {
+        return static_cast<double>(g_servers->GetStats().m_queue_depth.load(std::memory_order_relaxed));
+    }, "queue=\"global\"");
+    metrics.AddGauge("gtserver_queue_depth", "Jobs waiting in the server queues", [] {
+        return static_cast<double>(g_servers->GetLoginPipeline()->GetPendingCount());
+    }, "queue=\"login\"");
+    MemoryAccounting::Get().RegisterMetrics();
+#ifdef HTTP_SERVER
+    if (http_server && !g_servers->GetServers().empty())
+        http_server->set_server_data(std::string{ config::http::gt::address }, g_servers->GetServers().front()->GetPort());
+#endif
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    while (!g_shutdown.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
+    g_servers->Shutdown();
+#ifdef HTTP_SERVER
+    if (http_server)
+        http_server->stop();
+#endif
     return EXIT_SUCCESS;
 }
\ No newline at end of file
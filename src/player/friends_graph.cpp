@@ -0,0 +1,108 @@
+#include <player/friends_graph.h>
+#include <algorithm>
+#include <database/kv_store.h>
+#include <utils/text.h>
+
+namespace GTServer {
+    void FriendsGraph::OnLogin(std::shared_ptr<Player> player) {
+        const uint32_t user_id{ player->GetUserId() };
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (auto it = m_online.find(user_id); it != m_online.end() && it->second.lock() == player)
+                return;
+            m_online.insert_or_assign(user_id, player);
+            if (!m_friends.contains(user_id)) {
+                auto& friends{ m_friends[user_id] = Load(user_id) };
+                for (const auto& friend_id : friends)
+                    m_watchers[friend_id].insert(user_id);
+            }
+        }
+        this->Notify(user_id, player->GetDisplayName(), true);
+    }
+    void FriendsGraph::OnLogout(std::shared_ptr<Player> player) {
+        const uint32_t user_id{ player->GetUserId() };
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto it{ m_online.find(user_id) };
+            // a newer session of the same account has already taken over
+            if (it == m_online.end() || it->second.lock() != player)
+                return;
+            m_online.erase(it);
+        }
+        this->Notify(user_id, player->GetDisplayName(), false);
+
+        std::scoped_lock lock{ m_mutex };
+        auto it{ m_friends.find(user_id) };
+        if (it == m_friends.end())
+            return;
+        for (const auto& friend_id : it->second) {
+            auto watchers{ m_watchers.find(friend_id) };
+            if (watchers == m_watchers.end())
+                continue;
+            watchers->second.erase(user_id);
+            if (watchers->second.empty())
+                m_watchers.erase(watchers);
+        }
+        m_friends.erase(it);
+    }
+
+    std::vector<FriendsGraph::Friend> FriendsGraph::GetFriends(const uint32_t& user_id) {
+        std::vector<Friend> ret{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            std::unordered_set<uint32_t> offline{};
+            const std::unordered_set<uint32_t>* friends{ &offline };
+            if (auto it = m_friends.find(user_id); it != m_friends.end())
+                friends = &it->second;
+            else
+                offline = Load(user_id);
+            ret.reserve(friends->size());
+            for (const auto& friend_id : *friends)
+                ret.push_back(Friend{ friend_id, this->GetOnline(friend_id) });
+        }
+        std::sort(ret.begin(), ret.end(), [](const Friend& a, const Friend& b) {
+            if ((a.m_player != nullptr) != (b.m_player != nullptr))
+                return a.m_player != nullptr;
+            return a.m_user_id < b.m_user_id;
+        });
+        return ret;
+    }
+
+    std::unordered_set<uint32_t> FriendsGraph::Load(const uint32_t& user_id) {
+        std::unordered_set<uint32_t> ret{};
+        const auto& data{ KeyValueStore::Get().Find(StoreKey::friends(user_id)) };
+        if (!data)
+            return ret;
+        for (const auto& line : utils::split(data.value(), "\n")) {
+            if (line.empty() || line.find_first_not_of("0123456789") != std::string::npos)
+                continue;
+            ret.insert(static_cast<uint32_t>(std::stoul(line)));
+        }
+        return ret;
+    }
+    std::shared_ptr<Player> FriendsGraph::GetOnline(const uint32_t& user_id) const {
+        if (auto it = m_online.find(user_id); it != m_online.end())
+            return it->second.lock();
+        return nullptr;
+    }
+    void FriendsGraph::Notify(const uint32_t& user_id, const std::string& display_name, const bool& logged_on) {
+        std::vector<std::shared_ptr<Player>> watchers{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto it{ m_watchers.find(user_id) };
+            if (it == m_watchers.end())
+                return;
+            watchers.reserve(it->second.size());
+            for (const auto& watcher_id : it->second) {
+                if (auto player = this->GetOnline(watcher_id); player)
+                    watchers.push_back(std::move(player));
+            }
+        }
+        for (auto& player : watchers) {
+            if (logged_on)
+                player->SendLog("`3FRIEND ALERT:`` {} has `2logged on``.", display_name);
+            else
+                player->SendLog("`3FRIEND ALERT:`` {} has `4logged off``.", display_name);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <player/player.h>
+
+namespace GTServer {
+    // friend lists of online players kept as adjacency sets, loaded from the KeyValueStore on login.
+    // m_watchers is the reverse index (user -> online players listing that user), so login and
+    // logout alerts only touch the players that actually care.
+    class FriendsGraph {
+    public:
+        struct Friend {
+            uint32_t m_user_id;
+            std::shared_ptr<Player> m_player;
+        };
+
+    public:
+        FriendsGraph() = default;
+        ~FriendsGraph() = default;
+
+        void OnLogin(std::shared_ptr<Player> player);
+        void OnLogout(std::shared_ptr<Player> player);
+
+        // online friends first, each group ordered by user id
+        [[nodiscard]] std::vector<Friend> GetFriends(const uint32_t& user_id);
+
+    public:
+        static FriendsGraph& Get() { static FriendsGraph ret; return ret; }
+
+    private:
+        static std::unordered_set<uint32_t> Load(const uint32_t& user_id);
+
+        std::shared_ptr<Player> GetOnline(const uint32_t& user_id) const;
+        void Notify(const uint32_t& user_id, const std::string& display_name, const bool& logged_on);
+
+    private:
+        std::mutex m_mutex{};
+        std::unordered_map<uint32_t, std::unordered_set<uint32_t>> m_friends{};
+        std::unordered_map<uint32_t, std::unordered_set<uint32_t>> m_watchers{};
+        std::unordered_map<uint32_t, std::weak_ptr<Player>> m_online{};
+    };
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include <unordered_map>
+#include <vector>
 #include <player/objects/packet_sender.h>
 #include <database/item/item_database.h>
 #include <utils/binary_reader.h>
 #include <utils/binary_writer.h>
+#include <utils/memory_usage.h>
 
 #define MAX_INVENTORY_SLOTS 396
 
@@ -13,76 +15,85 @@ namespace GTServer {
         INVENTORY_ITEM_FLAGS_ACTIVATED = (1 << 0)
     };
 
+    struct InventoryItem {
+        uint16_t m_item_id{ 0 };
+        uint8_t m_count{ 0 };
+
+        [[nodiscard]] bool IsEmpty() const { return m_count == 0; }
+    };
+
+    // items live in a slot array that keeps its order, removing an item leaves a hole the next new item reuses.
+    // the packed inventory state is cached until the next change.
     class Inventory : public PacketSender {
     public:
         Inventory(ENetPeer* peer) : PacketSender{ peer } {}
         ~Inventory() = default;
 
         [[nodiscard]] uint32_t GetSize() const { return m_size; }
-        [[nodiscard]] std::unordered_map<uint16_t, uint8_t> GetItems() const { return m_items; }
+        // includes empty slots, check InventoryItem::IsEmpty
+        [[nodiscard]] const std::vector<InventoryItem>& GetItems() const { return m_slots; }
+        [[nodiscard]] std::size_t GetUsedSlots() const { return m_index.size(); }
+        [[nodiscard]] std::size_t GetMemoryUsage() const { 
+            return sizeof(Inventory) + MemoryUsage::of(m_slots) + MemoryUsage::of(m_free_slots) + MemoryUsage::of(m_index) + MemoryUsage::of(m_packet);
+        }
         
-        bool IsMaxed() const { return m_items.size() + 1 > m_size; }
-        bool Contain(const uint16_t& item_id) {
-            return m_items.find(item_id) != m_items.end();
+        bool IsMaxed() const { return m_index.size() + 1 > m_size; }
+        bool Contain(const uint16_t& item_id) const {
+            return m_index.find(item_id) != m_index.end();
         }
         bool Add(const uint16_t& item_id, const uint8_t& count, const bool& send_packet = false) {
             if (count == 0)
                 return false;
-            if (auto it = m_items.find(item_id); it != m_items.end()) {
+            if (auto it = m_index.find(item_id); it != m_index.end()) {
                 const auto& item = ItemDatabase::GetItem(item_id);
                 if (!item)
                     return false;
-                if ((it->second + count) > item->m_max_amount)
+                InventoryItem& slot{ m_slots[it->second] };
+                if ((slot.m_count + count) > item->m_max_amount)
                     return false;
-                it->second += count;
+                slot.m_count += count;
             }
             else {
-                if (m_items.size() >= m_size)
+                if (m_index.size() >= m_size)
                     return false;
-                m_items.insert_or_assign(item_id, count);
+                this->Insert(item_id, count);
             }
+            m_packet.clear();
             if (send_packet)
                 this->Update(item_id, count, true);
             return true;
         }
         bool Erase(const uint16_t& item_id, const uint8_t& count, const bool& send_packet = false ){
-            auto it = m_items.find(item_id);
-            if (it == m_items.end())
+            auto it = m_index.find(item_id);
+            if (it == m_index.end())
                 return false;
             ItemInfo* item{ ItemDatabase::GetItem(item_id) };
             if (!item)
                 return false;
-            if (count > item->m_max_amount || (it->second - count) <= 0)
-                m_items.erase(it);
+            InventoryItem& slot{ m_slots[it->second] };
+            if (count > item->m_max_amount || (slot.m_count - count) <= 0) {
+                slot = InventoryItem{};
+                m_free_slots.push_back(it->second);
+                m_index.erase(it);
+            }
             else
-                it->second -= count;
+                slot.m_count -= count;
+            m_packet.clear();
             if (send_packet)
                 this->Update(item_id, count, false);
             return true;
         }
-        uint8_t GetItemCount(uint16_t item) {
-            if (auto it = m_items.find(item); it != m_items.end())
-                return m_items[item];
+        uint8_t GetItemCount(const uint16_t& item) const {
+            if (auto it = m_index.find(item); it != m_index.end())
+                return m_slots[it->second].m_count;
             return 0;
         }
 
         std::vector<uint8_t> Pack() const {
-            std::size_t alloc{ 8 + (4 * m_items.size()) };
-            std::vector<uint8_t> ret{};
-            ret.resize(alloc);
-            
-            BinaryWriter buffer{ ret.data() };
-            buffer.write<uint8_t>(0x1); // inventory version??
-            buffer.write<uint32_t>(m_size);
-            buffer.write<uint16_t>(static_cast<uint16_t>(m_items.size()));
-
-            for (const auto& [item_id, count] : m_items) {
-                uint8_t flags = INVENTORY_ITEM_FLAGS_NONE; // irrelevant
-                buffer.write<uint16_t>(item_id);
-                buffer.write<uint8_t>(count);
-                buffer.write<uint8_t>(flags);
-            }
-            return ret;
+            const auto& packet{ this->GetPacket() };
+            const GameUpdatePacket* update_packet{ reinterpret_cast<const GameUpdatePacket*>(packet.data()) };
+            const uint8_t* data{ reinterpret_cast<const uint8_t*>(&update_packet->m_data) };
+            return std::vector<uint8_t>{ data, data + update_packet->m_data_size };
         }
         void Serialize(const std::vector<uint8_t>& data) {
             BinaryReader br{ data };
@@ -90,27 +101,27 @@ namespace GTServer {
             m_size = br.read<uint32_t>();
             const uint16_t& items{ br.read<uint16_t>() };
 
+            m_slots.clear();
+            m_free_slots.clear();
+            m_index.clear();
+            m_slots.reserve(items);
             for (uint16_t i = 0; i < items; i++) {
                 const uint16_t item_id{ br.read<uint16_t>() };
                 const uint8_t count{ br.read<uint8_t>() };
                 br.skip(1); // flags irrelevant
-                m_items.insert_or_assign(item_id, count);
+                if (count == 0)
+                    continue;
+                if (auto it = m_index.find(item_id); it != m_index.end())
+                    m_slots[it->second].m_count = count;
+                else
+                    this->Insert(item_id, count);
             }
+            m_packet.clear();
         }
 
         void Send() {
-            auto data{ this->Pack() };
-            GameUpdatePacket* update_packet{ static_cast<GameUpdatePacket*>(std::malloc(sizeof(GameUpdatePacket) + data.size())) };
-            std::memset(update_packet, 0, data.size());
-
-            update_packet->m_type = NET_GAME_PACKET_SEND_INVENTORY_STATE;
-            update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-            update_packet->m_data_size = static_cast<uint32_t>(data.size());
-            std::memcpy(&update_packet->m_data, data.data(), data.size());
-            this->SendPacket(NET_MESSAGE_GAME_PACKET, update_packet, sizeof(GameUpdatePacket) + data.size());
-
-            data.clear();
-            std::free(update_packet);
+            const auto& packet{ this->GetPacket() };
+            this->SendPacket(NET_MESSAGE_GAME_PACKET, packet.data(), packet.size());
         }
 
     public:
@@ -118,6 +129,7 @@ namespace GTServer {
             if (this->GetSize() >= MAX_INVENTORY_SLOTS)
                 return false;
             this->m_size += 10;
+            m_packet.clear();
             return true;
         }
         
@@ -157,8 +169,47 @@ namespace GTServer {
                 update_packet.m_lost_item_count = quantity;
             this->SendPacket(NET_MESSAGE_GAME_PACKET, &update_packet, sizeof(GameUpdatePacket));
         }
+        void Insert(const uint16_t& item_id, const uint8_t& count) {
+            uint16_t slot{ static_cast<uint16_t>(m_slots.size()) };
+            if (!m_free_slots.empty()) {
+                slot = m_free_slots.back();
+                m_free_slots.pop_back();
+            }
+            else
+                m_slots.emplace_back();
+            m_slots[slot] = InventoryItem{ item_id, count };
+            m_index.insert_or_assign(item_id, slot);
+        }
+        const std::vector<uint8_t>& GetPacket() const {
+            if (!m_packet.empty())
+                return m_packet;
+            const std::size_t alloc{ 8 + (4 * m_index.size()) };
+            m_packet.assign(sizeof(GameUpdatePacket) + alloc, 0);
+
+            GameUpdatePacket* update_packet{ reinterpret_cast<GameUpdatePacket*>(m_packet.data()) };
+            update_packet->m_type = NET_GAME_PACKET_SEND_INVENTORY_STATE;
+            update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
+            update_packet->m_data_size = static_cast<uint32_t>(alloc);
+
+            BinaryWriter buffer{ reinterpret_cast<uint8_t*>(&update_packet->m_data) };
+            buffer.write<uint8_t>(0x1); // inventory version??
+            buffer.write<uint32_t>(m_size);
+            buffer.write<uint16_t>(static_cast<uint16_t>(m_index.size()));
+            for (const auto& slot : m_slots) {
+                if (slot.IsEmpty())
+                    continue;
+                buffer.write<uint16_t>(slot.m_item_id);
+                buffer.write<uint8_t>(slot.m_count);
+                buffer.write<uint8_t>(INVENTORY_ITEM_FLAGS_NONE);
+            }
+            return m_packet;
+        }
+
     private:
         uint32_t m_size{ 200 };
-        std::unordered_map<uint16_t, uint8_t> m_items{};
+        std::vector<InventoryItem> m_slots{};
+        std::vector<uint16_t> m_free_slots{};
+        std::unordered_map<uint16_t, uint16_t> m_index{};
+        mutable std::vector<uint8_t> m_packet{};
     };
 }
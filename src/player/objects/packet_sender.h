@@ -2,8 +2,10 @@
 #include <fmt/format.h>
 #include <enet/enet.h>
 #include <proton/packet.h>
+#include <proton/game_packet.h>
 #include <proton/variant.h>
 #include <proton/utils/text_scanner.h>
+#include <server/outbound_budget.h>
 
 namespace GTServer {
     class PacketSender {
@@ -35,10 +37,10 @@ namespace GTServer {
             if (enet_peer_send(m_peer, 0, packet) != 0)
                 enet_packet_destroy(packet);
         }
-        void SendPacket(eNetMessageType type, const void* data, uintmax_t data_size) {
+        void SendPacket(eNetMessageType type, const void* data, uintmax_t data_size, const eDelivery& delivery = DELIVERY_RELIABLE) {
             if (!this->GetPeer())
                 return;
-            ENetPacket* packet = enet_packet_create(nullptr, 5 + data_size, ENET_PACKET_FLAG_RELIABLE);
+            ENetPacket* packet = enet_packet_create(nullptr, 5 + data_size, GetPacketFlags(delivery));
             if (!packet)
                 return;
             std::memcpy(packet->data, &type, 4);
@@ -47,9 +49,14 @@ namespace GTServer {
             if (data)
                 std::memcpy(packet->data + 4, data, data_size);
 
-            if (enet_peer_send(m_peer, 0, packet) != 0)
+            if (enet_peer_send(m_peer, GetChannel(delivery), packet) != 0)
                 enet_packet_destroy(packet);
         }
+        void SendPacket(GamePacket& packet) {
+            if (!this->GetPeer() || !packet.IsValid())
+                return;
+            enet_peer_send(m_peer, packet.GetChannel(), packet.GetPacket());
+        }
         
         template <typename... Args>
         void SendLog(const std::string& format, Args&&... args) {
@@ -62,7 +69,7 @@ namespace GTServer {
             parser.add("file", fmt::format("audio/{}.wav", sound));
             parser.add<int32_t>("delayMS", delay);
             const auto& data{ parser.get_all_raw() };
-            this->SendPacket(NET_MESSAGE_GAME_MESSAGE, data.data(), data.size());
+            this->SendPacket(NET_MESSAGE_GAME_MESSAGE, data.data(), data.size(), DELIVERY_UNRELIABLE);
         }
         void SendDanceAnimation(int32_t net_id) {
             TextScanner parser{};
@@ -70,7 +77,7 @@ namespace GTServer {
             parser.add("type", "8");
             parser.add<int32_t>("netID", net_id);
             const auto& data{ parser.get_all_raw() };
-            this->SendPacket(NET_MESSAGE_GAME_MESSAGE, data.data(), data.size());
+            this->SendPacket(NET_MESSAGE_GAME_MESSAGE, data.data(), data.size(), DELIVERY_UNRELIABLE);
         }
         void SendSetURL(const std::string& url, const std::string& label) {
             TextScanner parser{};
@@ -80,25 +87,54 @@ namespace GTServer {
             const auto& data{ parser.get_all_raw() };
             this->SendPacket(NET_MESSAGE_GAME_MESSAGE, data.data(), data.size());
         }
-        void SendVariant(const variantlist_t& var, int32_t delay = 0, int32_t net_id = -1) {
-            size_t alloc = 1;
-            for(const auto& v : var.get_objects()) 
-                alloc += v.get_memory_allocate() + 1;
-            const uint8_t* var_data = var.serialize();
-            
-            GameUpdatePacket* update_packet = reinterpret_cast<GameUpdatePacket*>(std::malloc(sizeof(GameUpdatePacket) + alloc));
-            update_packet->m_type = NET_GAME_PACKET_CALL_FUNCTION;
-            update_packet->m_net_id = net_id;
-            update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-            update_packet->m_delay = delay;
-            update_packet->m_data_size = static_cast<uint32_t>(alloc);
-            std::memcpy(&update_packet->m_data, var_data, alloc);
+        void SendVariant(const variantlist_t& var, int32_t delay = 0, int32_t net_id = -1, const eDelivery& delivery = DELIVERY_RELIABLE) {
+            GamePacket packet{ NET_GAME_PACKET_CALL_FUNCTION, var.get_memory_allocate(), delivery };
+            if (!packet.IsValid())
+                return;
+            packet->m_net_id = net_id;
+            packet->m_delay = delay;
+            BinaryWriter buffer{ packet.GetData() };
+            var.serialize(buffer);
+            this->SendPacket(packet);
+        }
+
+        // packets waiting in enet's outgoing and in-flight lists for this peer, must run on the service thread
+        OutboundBacklog GetOutboundBacklog() {
+            OutboundBacklog ret{};
+            if (!this->GetPeer())
+                return ret;
+            for (ENetList* list : { &m_peer->outgoingCommands, &m_peer->sentReliableCommands, &m_peer->sentUnreliableCommands }) {
+                for (ENetListIterator it = enet_list_begin(list); it != enet_list_end(list); it = enet_list_next(it)) {
+                    const ENetOutgoingCommand* command{ reinterpret_cast<const ENetOutgoingCommand*>(it) };
+                    if (!command->packet)
+                        continue;
+                    ret.m_bytes += command->fragmentLength;
+                    // a fragmented packet counts once
+                    if (command->fragmentOffset == 0)
+                        ++ret.m_packets;
+                }
+            }
+            return ret;
+        }
+        void SetCongested(const bool& congested) { m_congested = congested; }
+        [[nodiscard]] bool IsCongested() const { return m_congested; }
 
-            this->SendPacket(NET_MESSAGE_GAME_PACKET, update_packet, sizeof(GameUpdatePacket) + update_packet->m_data_size);    
-            std::free(update_packet);
+        // commands waiting in enet's outgoing and in-flight lists for this peer, must run on the service thread
+        std::size_t GetQueuedMemoryUsage() {
+            if (!this->GetPeer())
+                return 0;
+            std::size_t ret{ 0 };
+            for (ENetList* list : { &m_peer->outgoingCommands, &m_peer->sentReliableCommands, &m_peer->sentUnreliableCommands }) {
+                for (ENetListIterator it = enet_list_begin(list); it != enet_list_end(list); it = enet_list_next(it)) {
+                    const ENetOutgoingCommand* command{ reinterpret_cast<const ENetOutgoingCommand*>(it) };
+                    ret += sizeof(ENetOutgoingCommand) + (command->packet ? command->fragmentLength : 0);
+                }
+            }
+            return ret;
         }
 
     private:
         ENetPeer* m_peer;
+        bool m_congested{ false };
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <unordered_map>
 #include <utils/timing_clock.h>
 
@@ -108,7 +109,8 @@ namespace GTServer {
         PLAYMOD_TYPE_HAUNTED,
         PLAYMOD_TYPE_INVISIBLE,
         PLAYMOD_TYPE_1HIT,
-        PLAYMOD_TYPE_RAISE_THE_FLAG__BANNER_BANDOLIER
+        PLAYMOD_TYPE_RAISE_THE_FLAG__BANNER_BANDOLIER,
+        NUM_PLAYMOD_TYPES
     };
 
     struct Playmod {
@@ -116,6 +118,11 @@ namespace GTServer {
         uint16_t m_icon_id;
         TimingClock m_time;
 
+        // permanent playmods and the ones toggled by commands never run out
+        [[nodiscard]] bool IsTimed() const {
+            return m_time.GetTimeout() != std::chrono::seconds(-1) && m_type != PLAYMOD_TYPE_GHOST_IN_THE_SHELL && m_type != PLAYMOD_TYPE_NICK && m_type != PLAYMOD_TYPE_INVISIBLE;
+        }
+        [[nodiscard]] steady_clock::time_point GetExpiry() const { return m_time.GetTime() + m_time.GetTimeout(); }
         std::string GetTabString() const {
             std::chrono::seconds time = std::chrono::duration_cast<std::chrono::seconds>(m_time.GetTime() - std::chrono::steady_clock::now()) + m_time.GetTimeout();
 
@@ -1,4 +1,5 @@
 #pragma once 
+#include <array>
 #include <enet/enet.h>
 #include <proton/packet.h>
 #include <proton/variant.h>
@@ -74,7 +75,7 @@ namespace GTServer {
                 "OnAction",
                 net_id,
                 actionthing
-                });
+                }, 0, -1, DELIVERY_UNRELIABLE);
         }
         void OnRequestWorldSelectMenu(const std::string& data, int32_t delay = 0) {
             this->SendVariant({
@@ -165,7 +166,7 @@ namespace GTServer {
             this->SendVariant({
                 "OnPlayPositioned",
                 fmt::format("audio/{}.wav", sound)
-            }, delay, net_id);
+            }, delay, net_id, DELIVERY_UNRELIABLE);
         }
         void SetHasGrowID(const bool& active, const std::string& tankIDName, const std::string& tankIDPass) {
             this->SendVariant({
@@ -186,7 +187,7 @@ namespace GTServer {
                 "OnParticleEffect",
                 particle_id,
                 position
-            }, delay);
+            }, delay, -1, DELIVERY_UNRELIABLE);
         }
         void OnSetBux(const int32_t& gems, const int32_t& ranks) {
             this->SendVariant({
@@ -202,6 +203,17 @@ namespace GTServer {
                 weather
             });
         }
+        // sub-server redirect, the client reconnects to address:port and logs in again with the token and user
+        void OnSendToServer(const int32_t& port, const int32_t& token, const int32_t& user_id, const std::string& address, const int32_t& door_id = 0, const std::string& uuid = "") {
+            this->SendVariant({
+                "OnSendToServer",
+                port,
+                token,
+                user_id,
+                fmt::format("{}|{}|{}", address, door_id, uuid),
+                0
+            });
+        }
     private:
         ENetPeer* m_peer;
     };
@@ -1,4 +1,5 @@
 #include <player/player.h>
+#include <player/playmod_timer.h>
 #include <world/world.h>
 #include <world/world_pool.h>
 #include <render/world_render.h>
@@ -169,7 +170,10 @@ namespace GTServer {
                 val.m_type = static_cast<ePlaymodType>(br.read<uint16_t>());
                 val.m_icon_id = br.read<uint16_t>();
                 val.m_time = TimingClock{ steady_clock::time_point{ std::chrono::nanoseconds(br.read<uint64_t>()) }, std::chrono::seconds{ br.read<std::chrono::seconds>() } };
+                if (val.m_type >= NUM_PLAYMOD_TYPES || this->HasPlaymod(val.m_type))
+                    continue;
                 this->m_playmods.push_back(val);
+                m_active_playmods.set(val.m_type);
             }
         } break; 
         case PLAYER_DATA_CHARACTER_STATE: {
@@ -477,8 +481,13 @@ namespace GTServer {
     }
 
     void Player::AddPlaymod(ePlaymodType type, uint16_t icon_id, steady_clock::time_point apply_mod, std::chrono::seconds time) {  
+        if (type >= NUM_PLAYMOD_TYPES)
+            return;
         if (this->HasPlaymod(type)) {
-            this->GetPlaymods()[static_cast<std::size_t>(type)].m_icon_id = icon_id;
+            auto iterator = std::find_if(m_playmods.begin(), m_playmods.end(), 
+                [&type](const Playmod& mod) { return mod.m_type == type; });
+            if (iterator != m_playmods.end())
+                iterator->m_icon_id = icon_id;
             return;
         }
         Playmod mod{};
@@ -486,8 +495,10 @@ namespace GTServer {
         mod.m_icon_id = icon_id;
         mod.m_time = TimingClock{ apply_mod, time };
         m_playmods.push_back(mod);
+        m_active_playmods.set(type);
         if (!this->GetPeer())
             return;
+        PlaymodTimer::Get().Schedule(this->weak_from_this(), mod);
 
         switch (type) {
         case PLAYMOD_TYPE_DOUBLE_JUMP: { CharacterState::SetFlag(STATEFLAG_DOUBLE_JUMP); } break;
@@ -530,13 +541,20 @@ namespace GTServer {
         PlaymodData mod_data = PlaymodManager::Get(type);
         this->SendLog("`o{}`` (`${} `omod added.)``", mod_data.m_adding, mod_data.m_name);
     }
+    void Player::SchedulePlaymods() {
+        if (!this->GetPeer())
+            return;
+        for (const auto& mod : m_playmods)
+            PlaymodTimer::Get().Schedule(this->weak_from_this(), mod);
+    }
     void Player::RemovePlaymod(ePlaymodType type) {
-        auto& playmods = this->GetPlaymods();
-        auto iterator = std::find_if(playmods.begin(), playmods.end(), 
-            [&type](const Playmod& mod) { return mod.m_type == type; });
-        if (iterator == playmods.end())
+        if (!this->HasPlaymod(type))
             return;
-        iterator = playmods.erase(iterator);
+        auto iterator = std::find_if(m_playmods.begin(), m_playmods.end(), 
+            [&type](const Playmod& mod) { return mod.m_type == type; });
+        if (iterator != m_playmods.end())
+            m_playmods.erase(iterator);
+        m_active_playmods.reset(type);
         if (!this->GetPeer())
             return;
 
@@ -591,14 +609,9 @@ namespace GTServer {
         this->SendLog("`o{}`` (`${} `omod removed.)``", mod_data.m_removing, mod_data.m_name);
         this->PlaySfx("dialog_confirm", 0);
     }
-    bool Player::HasPlaymod(ePlaymodType type) {
-        for (auto& mod : this->GetPlaymods()) {
-            if (mod.m_type == type)
-                return true;
-        }
-        return false;
-    }
     bool Player::GetPlaymod(ePlaymodType type, Playmod& val) {
+        if (!this->HasPlaymod(type))
+            return false;
         for (auto& mod : this->GetPlaymods()) {
             if (mod.m_type == type) {
                 val = mod;
@@ -614,4 +627,24 @@ namespace GTServer {
             return PUNCH_EFFECT_TINY_TANK;
         return PUNCH_EFFECT_NONE;
     }
+
+    eOutboundState Player::UpdateOutboundBudget(const steady_clock::time_point& now) {
+        const eOutboundState state{ m_outbound_budget.Update(this->GetOutboundBacklog(), now) };
+        this->SetCongested(state != OUTBOUND_STATE_OK);
+        v_sender.SetCongested(state != OUTBOUND_STATE_OK);
+        return state;
+    }
+
+    Player::MemoryBreakdown Player::GetMemoryBreakdown() {
+        MemoryBreakdown ret{};
+        ret.m_base = sizeof(Player) - sizeof(Inventory) + sizeof(LoginInformation);
+        for (const auto& str : { &m_raw_name, &m_display_name, &m_ip_address, &m_ban_reason, &m_email, &m_world })
+            ret.m_base += MemoryUsage::of(*str);
+        for (const auto& str : { &m_login_info->m_tank_id_name, &m_login_info->m_tank_id_pass, &m_login_info->m_email, &m_login_info->m_rid, &m_login_info->m_mac })
+            ret.m_base += MemoryUsage::of(*str);
+        ret.m_inventory = m_inventory.GetMemoryUsage();
+        ret.m_playmods = MemoryUsage::of(m_playmods);
+        ret.m_packet_queue = this->GetQueuedMemoryUsage();
+        return ret;
+    }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <bitset>
+#include <memory>
 #include <enet/enet.h>
 #include <player/player_component.h>
 #include <player/objects/enums.h>
@@ -18,7 +20,17 @@
 
 namespace GTServer {
     class World;
-    class Player : public PacketSender, public PlayerComponent, public CharacterState {
+    class Player : public PacketSender, public PlayerComponent, public CharacterState, public std::enable_shared_from_this<Player> {
+    public:
+        struct MemoryBreakdown {
+            std::size_t m_base{ 0 };
+            std::size_t m_inventory{ 0 };
+            std::size_t m_playmods{ 0 };
+            std::size_t m_packet_queue{ 0 };
+
+            [[nodiscard]] std::size_t GetTotal() const { return m_base + m_inventory + m_playmods + m_packet_queue; }
+        };
+
     public:
         explicit Player(ENetPeer* peer);
         ~Player();
@@ -30,6 +42,8 @@ namespace GTServer {
         [[nodiscard]] ENetPeer* GetPeer() const { return m_peer; }
         [[nodiscard]] const char* GetIPAddress() const { return m_ip_address.data(); }
         void Disconnect(const enet_uint32& data) { enet_peer_disconnect_later(this->GetPeer(), data); }
+        // samples the peer's backlog against its budget, a congested player gets cosmetic updates unreliably or not at all
+        eOutboundState UpdateOutboundBudget(const steady_clock::time_point& now);
 
         void SetUserId(const uint32_t& uid) { m_user_id = uid; }
         [[nodiscard]] uint32_t GetUserId() const { return m_user_id; }
@@ -93,11 +107,15 @@ namespace GTServer {
     public:
         void AddPlaymod(ePlaymodType type, uint16_t icon_id, steady_clock::time_point apply_mod, std::chrono::seconds time);
         void RemovePlaymod(ePlaymodType type);
+        // hands the playmods loaded with the profile to the expiry timer, service thread only
+        void SchedulePlaymods();
         void SetBan(std::string& reason);
-        bool HasPlaymod(ePlaymodType type);
+        bool HasPlaymod(ePlaymodType type) const { return type < NUM_PLAYMOD_TYPES && m_active_playmods.test(type); }
         bool GetPlaymod(ePlaymodType type, Playmod& val);
         uint8_t GetActivePunchID();
-        std::vector<Playmod>& GetPlaymods() { return m_playmods; }
+        const std::vector<Playmod>& GetPlaymods() const { return m_playmods; }
+
+        MemoryBreakdown GetMemoryBreakdown();
 
     public:
         std::shared_ptr<LoginInformation> m_login_info;
@@ -131,5 +149,6 @@ namespace GTServer {
         Color m_skin_color = Color{ 0xB4, 0x8A, 0x78, 0xFF };
 
         std::vector<Playmod> m_playmods{};
+        std::bitset<NUM_PLAYMOD_TYPES> m_active_playmods{};
     };
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <proton/utils/common.h>
+#include <server/outbound_budget.h>
+#include <server/rate_limiter.h>
 #include <utils/timing_clock.h>
 
 #define MAX_PLAYER_OUTFITS 5
@@ -32,8 +34,8 @@ namespace GTServer {
         system_clock::time_point m_last_active;
         TimingClock m_respawn_time = TimingClock{ std::chrono::seconds(2) };
 
-        long long int m_packet_sec = 0;
-        int m_packet_in_sec = 0;
+        RateLimiter m_rate_limiter{};
+        OutboundBudget m_outbound_budget{};
 
     public:
         struct ReceiveMessage {
@@ -0,0 +1,36 @@
+#include <player/playmod_timer.h>
+#include <player/player.h>
+
+namespace GTServer {
+    void PlaymodTimer::Schedule(std::weak_ptr<Player> player, const Playmod& mod) {
+        if (!mod.IsTimed())
+            return;
+        std::scoped_lock lock{ m_mutex };
+        m_entries.push(Entry{ mod.GetExpiry(), mod.m_type, std::move(player) });
+    }
+    void PlaymodTimer::Poll() {
+        const auto now{ steady_clock::now() };
+        std::vector<Entry> expired{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            while (!m_entries.empty() && m_entries.top().m_expires_at <= now) {
+                expired.push_back(m_entries.top());
+                m_entries.pop();
+            }
+        }
+        for (const auto& entry : expired) {
+            std::shared_ptr<Player> player{ entry.m_player.lock() };
+            if (!player)
+                continue;
+            Playmod mod{};
+            if (!player->GetPlaymod(entry.m_type, mod) || !mod.IsTimed() || mod.GetExpiry() != entry.m_expires_at)
+                continue;
+            player->RemovePlaymod(entry.m_type);
+        }
+    }
+
+    std::size_t PlaymodTimer::GetSize() const {
+        std::scoped_lock lock{ m_mutex };
+        return m_entries.size();
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <player/objects/playmod.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    class Player;
+
+    // one min-heap of playmod expirations for every online player, polled by the server loop.
+    // entries are never removed early, a popped entry only applies if the player still has that playmod
+    // with the same expiry, so a removed or re-applied playmod simply leaves a stale entry behind.
+    class PlaymodTimer {
+    public:
+        PlaymodTimer() = default;
+        ~PlaymodTimer() = default;
+
+        void Schedule(std::weak_ptr<Player> player, const Playmod& mod);
+        void Poll();
+
+        [[nodiscard]] std::size_t GetSize() const;
+
+    public:
+        static PlaymodTimer& Get() { static PlaymodTimer ret; return ret; }
+
+    private:
+        struct Entry {
+            steady_clock::time_point m_expires_at;
+            ePlaymodType m_type;
+            std::weak_ptr<Player> m_player;
+
+            bool operator>(const Entry& other) const { return m_expires_at > other.m_expires_at; }
+        };
+
+    private:
+        mutable std::mutex m_mutex{};
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> m_entries{};
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <enet/enet.h>
+#include <proton/packet.h>
+
+namespace GTServer {
+    // a NET_MESSAGE_GAME_PACKET built straight in its ENetPacket at the final size, the GameUpdatePacket fields
+    // and the extended data are written in place and every peer it's sent to shares the same packet
+    class GamePacket {
+    public:
+        GamePacket(const eNetPacketType& type, const std::size_t& data_size = 0, const eDelivery& delivery = DELIVERY_RELIABLE) :
+            m_delivery{ delivery } {
+            // same layout SendPacket produces, message type + update packet + extended data + terminator
+            const std::size_t size{ sizeof(eNetMessageType) + sizeof(GameUpdatePacket) + data_size + 1 };
+            m_packet = enet_packet_create(nullptr, size, GetPacketFlags(delivery));
+            if (!m_packet)
+                return;
+            std::memset(m_packet->data, 0, size);
+            const eNetMessageType message{ NET_MESSAGE_GAME_PACKET };
+            std::memcpy(m_packet->data, &message, sizeof(eNetMessageType));
+
+            GameUpdatePacket* update_packet{ this->Get() };
+            update_packet->m_type = type;
+            if (data_size == 0)
+                return;
+            update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
+            update_packet->m_data_size = static_cast<uint32_t>(data_size);
+        }
+        ~GamePacket() {
+            if (!m_packet)
+                return;
+            if (m_retained)
+                --m_packet->referenceCount;
+            // enet owns it once it went to a peer and frees it after the last one is done with it
+            if (m_packet->referenceCount == 0)
+                enet_packet_destroy(m_packet);
+        }
+        GamePacket(const GamePacket&) = delete;
+        GamePacket& operator=(const GamePacket&) = delete;
+
+        // keeps the packet alive after the peers it was sent to are done with it, so it can be sent again
+        void Retain() {
+            if (!m_packet || m_retained)
+                return;
+            ++m_packet->referenceCount;
+            m_retained = true;
+        }
+
+        [[nodiscard]] bool IsValid() const { return m_packet != nullptr; }
+        [[nodiscard]] GameUpdatePacket* Get() { return reinterpret_cast<GameUpdatePacket*>(m_packet->data + sizeof(eNetMessageType)); }
+        GameUpdatePacket* operator->() { return this->Get(); }
+
+        [[nodiscard]] uint8_t* GetData() { return reinterpret_cast<uint8_t*>(&this->Get()->m_data); }
+
+        [[nodiscard]] ENetPacket* GetPacket() const { return m_packet; }
+        [[nodiscard]] uint8_t GetChannel() const { return GTServer::GetChannel(m_delivery); }
+
+    private:
+        ENetPacket* m_packet{ nullptr };
+        eDelivery m_delivery;
+        bool m_retained{ false };
+    };
+}
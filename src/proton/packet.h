@@ -72,6 +72,33 @@ namespace GTServer {
         char* m_data;
     };
     #pragma pack(pop)
+
+    // state that the client has to end up with goes reliably on its own channel, so a lost movement or effect
+    // never holds it back and a resend of stale transient data never happens
+    enum eChannel : uint8_t {
+        CHANNEL_STATE,
+        CHANNEL_TRANSIENT,
+        NUM_CHANNELS
+    };
+    enum eDelivery : uint8_t {
+        DELIVERY_RELIABLE,
+        DELIVERY_UNRELIABLE_SEQUENCED, // may be lost, older than what the peer already got is dropped
+        DELIVERY_UNRELIABLE            // may be lost or arrive out of order
+    };
+
+    inline uint32_t GetPacketFlags(const eDelivery& delivery) {
+        switch (delivery) {
+        case DELIVERY_UNRELIABLE_SEQUENCED:
+            return ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
+        case DELIVERY_UNRELIABLE:
+            return ENET_PACKET_FLAG_UNSEQUENCED | ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
+        default:
+            return ENET_PACKET_FLAG_RELIABLE;
+        }
+    }
+    inline uint8_t GetChannel(const eDelivery& delivery) {
+        return delivery == DELIVERY_RELIABLE ? CHANNEL_STATE : CHANNEL_TRANSIENT;
+    }
     
     #pragma pack(push, 1)
     struct GameUpdatePacket {
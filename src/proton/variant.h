@@ -82,7 +82,7 @@ namespace GTServer {
             return alloc;
         }
 
-        void pack(BinaryWriter& buffer) {
+        void pack(BinaryWriter& buffer) const {
             buffer.write<uint8_t>((uint8_t)this->get_type());
 
             switch (this->get_type()) {
@@ -134,20 +134,19 @@ namespace GTServer {
         variantlist_t(const variant::var_type& v0, const variant::var_type& v1, const variant::var_type& v2, const variant::var_type& v3, const variant::var_type& v4, const variant::var_type& v5, const variant::var_type& v6) 
             : m_objects({ { v0 }, { v1 }, { v2 }, { v3 }, { v4 }, { v5 }, { v6 } }) {}
 
-        [[nodiscard]] uint8_t* serialize() const {
+        [[nodiscard]] size_t get_memory_allocate() const {
             size_t alloc = 1;
             for(const auto& var : m_objects)
                 alloc += var.get_memory_allocate() + 1;
-            BinaryWriter buffer(alloc);
+            return alloc;
+        }
+        // writes get_memory_allocate() bytes at the buffer's position
+        void serialize(BinaryWriter& buffer) const {
             buffer.write<uint8_t>(m_objects.size());
             for (size_t index = 0; index < m_objects.size(); index++) {
-                variant var = m_objects[index];
                 buffer.write<uint8_t>(index);
-                var.pack(buffer);
+                m_objects[index].pack(buffer);
             }
-            uint8_t* ret = (uint8_t*)std::malloc(alloc);
-            std::memcpy(ret, buffer.get(), alloc);
-            return ret;
         }
         [[nodiscard]] std::vector<variant> get_objects() const { return m_objects; }
     private:
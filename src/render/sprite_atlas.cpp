@@ -0,0 +1,228 @@
+#include <render/sprite_atlas.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+#include <utils/binary_reader.h>
+#include <utils/binary_writer.h>
+#include <utils/file_manager.h>
+#include <utils/memory_usage.h>
+
+namespace GTServer {
+    constexpr uint32_t ATLAS_INDEX_MAGIC = 0x534C5441; // ATLS
+    constexpr uint16_t ATLAS_INDEX_VERSION = 1;
+    constexpr uint32_t ATLAS_PADDING = 1;
+
+    SpriteAtlas::~SpriteAtlas() {
+        for (auto& page : m_pages)
+            delete page;
+        m_pages.clear();
+    }
+
+    bool SpriteAtlas::build(const std::vector<std::pair<std::string, std::string>>& files) {
+        const uint64_t hash = this->hash_inputs(files);
+        if (this->load_from_disk(hash))
+            return true;
+
+        std::vector<std::pair<std::string, sf::Image>> images{};
+        images.reserve(files.size());
+        std::unordered_map<std::string, bool> seen{};
+        for (const auto& [key, path] : files) {
+            if (seen.contains(key) || !std::filesystem::exists(path))
+                continue;
+            sf::Image image{};
+            if (!image.loadFromFile(path))
+                continue;
+            if (image.getSize().x + ATLAS_PADDING > m_page_size || image.getSize().y + ATLAS_PADDING > m_page_size) {
+                fmt::print("SpriteAtlas({}) -> {} is bigger than atlas page ({}px), skipping.\n", m_name, path, m_page_size);
+                continue;
+            }
+            seen.insert_or_assign(key, true);
+            images.emplace_back(key, std::move(image));
+        }
+
+        std::vector<std::size_t> order(images.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](const std::size_t& a, const std::size_t& b) {
+            return images[a].second.getSize().y > images[b].second.getSize().y;
+        });
+
+        // simple shelf packer, tallest first so every shelf wastes as little height as possible
+        std::vector<Entry> entries(images.size());
+        std::vector<uint32_t> page_heights{ 0 };
+        uint32_t shelf_x = 0, shelf_y = 0, shelf_height = 0;
+        for (const auto& index : order) {
+            const sf::Vector2u& size = images[index].second.getSize();
+            if (shelf_x + size.x + ATLAS_PADDING > m_page_size) {
+                shelf_x = 0;
+                shelf_y += shelf_height;
+                shelf_height = 0;
+            }
+            if (shelf_y + size.y + ATLAS_PADDING > m_page_size) {
+                page_heights.push_back(0);
+                shelf_x = 0;
+                shelf_y = 0;
+                shelf_height = 0;
+            }
+            entries[index] = Entry{
+                .m_key = images[index].first,
+                .m_page = static_cast<uint16_t>(page_heights.size() - 1),
+                .m_x = shelf_x,
+                .m_y = shelf_y,
+                .m_width = size.x,
+                .m_height = size.y
+            };
+            shelf_x += size.x + ATLAS_PADDING;
+            shelf_height = std::max(shelf_height, size.y + ATLAS_PADDING);
+            page_heights.back() = std::max(page_heights.back(), shelf_y + shelf_height);
+        }
+
+        std::vector<sf::Image> pages(page_heights.size());
+        for (std::size_t page = 0; page < pages.size(); ++page)
+            pages[page].create(m_page_size, std::max(page_heights[page], 1u), sf::Color::Transparent);
+        for (std::size_t index = 0; index < images.size(); ++index)
+            pages[entries[index].m_page].copy(images[index].second, entries[index].m_x, entries[index].m_y);
+        images.clear();
+
+        if (!this->save_to_disk(hash, pages, entries))
+            fmt::print("SpriteAtlas({}) -> failed to write atlas cache, it will be rebuilt on next startup.\n", m_name);
+
+        for (const auto& image : pages) {
+            sf::Texture* texture = new sf::Texture();
+            texture->loadFromImage(image);
+            m_pages.push_back(texture);
+        }
+        this->finalize(entries);
+        return true;
+    }
+
+    uint64_t SpriteAtlas::hash_inputs(const std::vector<std::pair<std::string, std::string>>& files) const {
+        uint64_t hash = 0xCBF29CE484222325;
+        auto mix = [&hash](const uint8_t* data, const std::size_t& len) {
+            for (std::size_t i = 0; i < len; ++i) {
+                hash ^= data[i];
+                hash *= 0x100000001B3;
+            }
+        };
+        mix(reinterpret_cast<const uint8_t*>(&m_page_size), sizeof(m_page_size));
+        for (const auto& [key, path] : files) {
+            std::vector<uint8_t> content = FileManager::read_all_bytes(path);
+            if (content.empty())
+                continue;
+            mix(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+            mix(content.data(), content.size());
+        }
+        return hash;
+    }
+
+    bool SpriteAtlas::load_from_disk(const uint64_t& hash) {
+        // magic, version, hash, page size, page count, sprite count
+        constexpr std::size_t header_size = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
+        // key length, page, x, y, width, height, the key itself comes on top
+        constexpr std::size_t entry_size = sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t) * 4;
+        std::vector<uint8_t> content = FileManager::read_all_bytes(this->get_index_path());
+        if (content.size() < header_size)
+            return false;
+        BinaryReader br{ content };
+        if (br.read<uint32_t>() != ATLAS_INDEX_MAGIC || br.read<uint16_t>() != ATLAS_INDEX_VERSION)
+            return false;
+        if (br.read<uint64_t>() != hash || br.read<uint32_t>() != m_page_size)
+            return false;
+
+        const uint16_t page_count = br.read<uint16_t>();
+        const uint32_t sprite_count = br.read<uint32_t>();
+        // a damaged index is rebuilt, nothing is reserved or read beyond what the file holds
+        if (sprite_count > (content.size() - br.get_pos()) / entry_size)
+            return false;
+        std::vector<Entry> entries{};
+        entries.reserve(sprite_count);
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            if (content.size() - br.get_pos() < entry_size)
+                return false;
+            uint16_t key_length{};
+            std::memcpy(&key_length, content.data() + br.get_pos(), sizeof(uint16_t));
+            if (content.size() - br.get_pos() < entry_size + key_length)
+                return false;
+            Entry entry{};
+            entry.m_key = br.read_string();
+            entry.m_page = br.read<uint16_t>();
+            entry.m_x = br.read<uint32_t>();
+            entry.m_y = br.read<uint32_t>();
+            entry.m_width = br.read<uint32_t>();
+            entry.m_height = br.read<uint32_t>();
+            if (entry.m_page >= page_count)
+                return false;
+            entries.push_back(std::move(entry));
+        }
+
+        std::vector<sf::Texture*> pages{};
+        for (uint16_t page = 0; page < page_count; ++page) {
+            sf::Texture* texture = new sf::Texture();
+            if (!texture->loadFromFile(this->get_page_path(page))) {
+                delete texture;
+                for (auto& loaded : pages)
+                    delete loaded;
+                return false;
+            }
+            pages.push_back(texture);
+        }
+        m_pages = std::move(pages);
+        m_from_disk = true;
+        this->finalize(entries);
+        return true;
+    }
+
+    bool SpriteAtlas::save_to_disk(const uint64_t& hash, const std::vector<sf::Image>& pages, const std::vector<Entry>& entries) const {
+        if (!std::filesystem::exists("cache/atlas"))
+            std::filesystem::create_directory("cache/atlas");
+        for (std::size_t page = 0; page < pages.size(); ++page) {
+            if (!pages[page].saveToFile(this->get_page_path(page)))
+                return false;
+        }
+
+        std::size_t alloc = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
+        for (const auto& entry : entries)
+            alloc += sizeof(uint16_t) + entry.m_key.size() + sizeof(uint16_t) + sizeof(uint32_t) * 4;
+        BinaryWriter buffer{ alloc };
+        buffer.write<uint32_t>(ATLAS_INDEX_MAGIC);
+        buffer.write<uint16_t>(ATLAS_INDEX_VERSION);
+        buffer.write<uint64_t>(hash);
+        buffer.write<uint32_t>(m_page_size);
+        buffer.write<uint16_t>(static_cast<uint16_t>(pages.size()));
+        buffer.write<uint32_t>(static_cast<uint32_t>(entries.size()));
+        for (const auto& entry : entries) {
+            buffer.write(entry.m_key);
+            buffer.write<uint16_t>(entry.m_page);
+            buffer.write<uint32_t>(entry.m_x);
+            buffer.write<uint32_t>(entry.m_y);
+            buffer.write<uint32_t>(entry.m_width);
+            buffer.write<uint32_t>(entry.m_height);
+        }
+        return FileManager::write_all_bytes(this->get_index_path(), reinterpret_cast<char*>(buffer.get()), buffer.get_pos());
+    }
+
+    void SpriteAtlas::finalize(const std::vector<Entry>& entries) {
+        m_sprites.clear();
+        m_sprite_ids.clear();
+        m_sprites.reserve(entries.size());
+        for (const auto& entry : entries) {
+            m_sprite_ids.insert_or_assign(entry.m_key, static_cast<uint32_t>(m_sprites.size()));
+            m_sprites.push_back(Sprite{
+                .m_texture = m_pages[entry.m_page],
+                .m_origin = sf::Vector2f(static_cast<float>(entry.m_x), static_cast<float>(entry.m_y)),
+                .m_size = sf::Vector2u(entry.m_width, entry.m_height)
+            });
+        }
+    }
+
+    std::size_t SpriteAtlas::get_memory_usage() const {
+        // pages are kept as RGBA textures, count them as if they were resident
+        std::size_t ret{ MemoryUsage::of(m_sprites) + MemoryUsage::of(m_sprite_ids) };
+        for (const auto& page : m_pages)
+            ret += static_cast<std::size_t>(page->getSize().x) * page->getSize().y * 4;
+        for (const auto& [key, id] : m_sprite_ids)
+            ret += MemoryUsage::of(key);
+        return ret;
+    }
+}
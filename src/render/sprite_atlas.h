@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <SFML/Graphics.hpp>
+
+namespace GTServer {
+    class SpriteAtlas {
+    public:
+        struct Sprite {
+            sf::Texture* m_texture = nullptr;
+            sf::Vector2f m_origin{};
+            sf::Vector2u m_size{};
+        };
+        static constexpr uint32_t INVALID_SPRITE = UINT32_MAX;
+
+    public:
+        SpriteAtlas(const std::string& name, const uint32_t& page_size) : m_name{ name }, m_page_size{ page_size } {}
+        ~SpriteAtlas();
+
+        // files are (key, path) pairs, the first key wins when duplicated
+        bool build(const std::vector<std::pair<std::string, std::string>>& files);
+
+        [[nodiscard]] uint32_t get_sprite_id(const std::string& key) const {
+            if (auto it = m_sprite_ids.find(key); it != m_sprite_ids.end())
+                return it->second;
+            return INVALID_SPRITE;
+        }
+        [[nodiscard]] const Sprite* get_sprite(const uint32_t& id) const {
+            if (id >= m_sprites.size())
+                return nullptr;
+            return &m_sprites[id];
+        }
+
+        [[nodiscard]] std::size_t get_sprites_count() const { return m_sprites.size(); }
+        [[nodiscard]] std::size_t get_pages_count() const { return m_pages.size(); }
+        [[nodiscard]] bool is_from_disk() const { return m_from_disk; }
+        [[nodiscard]] std::size_t get_memory_usage() const;
+
+    private:
+        struct Entry {
+            std::string m_key;
+            uint16_t m_page;
+            uint32_t m_x, m_y;
+            uint32_t m_width, m_height;
+        };
+
+        uint64_t hash_inputs(const std::vector<std::pair<std::string, std::string>>& files) const;
+        bool load_from_disk(const uint64_t& hash);
+        bool save_to_disk(const uint64_t& hash, const std::vector<sf::Image>& pages, const std::vector<Entry>& entries) const;
+        void finalize(const std::vector<Entry>& entries);
+
+        [[nodiscard]] std::string get_index_path() const { return "cache/atlas/" + m_name + ".idx"; }
+        [[nodiscard]] std::string get_page_path(const std::size_t& page) const { return "cache/atlas/" + m_name + "_" + std::to_string(page) + ".png"; }
+
+    private:
+        std::string m_name;
+        uint32_t m_page_size;
+        bool m_from_disk{ false };
+
+        std::vector<sf::Texture*> m_pages{};
+        std::vector<Sprite> m_sprites{};
+        std::unordered_map<std::string, uint32_t> m_sprite_ids{};
+    };
+}
@@ -1,4 +1,5 @@
 #include <render/world_render.h>
+#include <algorithm>
 #include <filesystem>
 #include <vector>
 #include <fmt/core.h>
@@ -8,6 +9,7 @@
 #include <SFML/Graphics/Text.hpp>
 #include <extra_dependencies/FText.h>
 #include <utils/text.h>
+#include <utils/memory_usage.h>
 #include <world/tile.h>
 #include <world/world.h>
 #include <server/server_pool.h>
@@ -24,87 +26,104 @@ namespace GTServer {
             fmt::print(" |-> currently maximum size for rendering is {}px.\n", sf::Texture::getMaximumSize());
             return;
         }
-        std::vector<std::string> textures_to_cache;
-        std::vector<std::string> borders_to_cache;
-        std::vector<std::string> weathers_to_cache;
+        std::vector<std::pair<std::string, std::string>> textures_to_cache;
+        std::vector<std::pair<std::string, std::string>> borders_to_cache;
+        std::vector<std::pair<std::string, std::string>> weathers_to_cache;
 
         for (const auto& entry : std::filesystem::directory_iterator("cache/sprites")) {
             if (entry.path().extension() != ".png")
                 continue;
-            textures_to_cache.push_back(entry.path().string());
+            textures_to_cache.emplace_back(utils::replace_text(entry.path().filename().string(), ".png", ".rttex"), entry.path().string());
         }
         for (const auto& entry : std::filesystem::directory_iterator("cache/locale")) {
             if (entry.path().extension() != ".png")
                 continue;
-            textures_to_cache.push_back(entry.path().string());
+            textures_to_cache.emplace_back(utils::replace_text(entry.path().filename().string(), ".png", ".rttex"), entry.path().string());
         }
         for (const auto& entry : std::filesystem::directory_iterator("cache/borders")) {
             if (entry.path().extension() != ".png")
                 continue;
-            borders_to_cache.push_back(entry.path().string());
+            borders_to_cache.emplace_back(entry.path().filename().string(), entry.path().string());
         }
-
-        weathers_to_cache.push_back("cache/weathers/Apocalypse.png");
-        weathers_to_cache.push_back("cache/weathers/Arid.png");
-        weathers_to_cache.push_back("cache/weathers/Ascended Ship.png");
-        weathers_to_cache.push_back("cache/weathers/Autumn.png");
-        weathers_to_cache.push_back("cache/weathers/Balloon.png");
-        weathers_to_cache.push_back("cache/weathers/Beach.png");
-        weathers_to_cache.push_back("cache/weathers/Bountiful.png");
-        weathers_to_cache.push_back("cache/weathers/Celebrity Hills.png");
-        weathers_to_cache.push_back("cache/weathers/Comet.png");
-        weathers_to_cache.push_back("cache/weathers/Descended Ship.png");
-        weathers_to_cache.push_back("cache/weathers/Digital Rain.png");
-        weathers_to_cache.push_back("cache/weathers/Epoch - Iceberg.png");
-        weathers_to_cache.push_back("cache/weathers/Epoch - Lava.png");
-        weathers_to_cache.push_back("cache/weathers/Epoch - Skylands.png");
-        weathers_to_cache.push_back("cache/weathers/Frozen Cliffs.png");
-        weathers_to_cache.push_back("cache/weathers/Harvest.png");
-        weathers_to_cache.push_back("cache/weathers/Hospital.png");
-        weathers_to_cache.push_back("cache/weathers/Howling Sky.png");
-        weathers_to_cache.push_back("cache/weathers/Jungle.png");
-        weathers_to_cache.push_back("cache/weathers/Legendary City.png");
-        weathers_to_cache.push_back("cache/weathers/Mars.png");
-        weathers_to_cache.push_back("cache/weathers/Meteor Shower.png");
-        weathers_to_cache.push_back("cache/weathers/Monochrome.png");
-        weathers_to_cache.push_back("cache/weathers/Night.png");
-        weathers_to_cache.push_back("cache/weathers/Nothing.png");
-        weathers_to_cache.push_back("cache/weathers/Pagoda.png");
-        weathers_to_cache.push_back("cache/weathers/Party.png");
-        weathers_to_cache.push_back("cache/weathers/Pineapples.png");
-        weathers_to_cache.push_back("cache/weathers/Rainy.png");
-        weathers_to_cache.push_back("cache/weathers/Snowy Night.png");
-        weathers_to_cache.push_back("cache/weathers/Snowy.png");
-        weathers_to_cache.push_back("cache/weathers/Spooky.png");
-        weathers_to_cache.push_back("cache/weathers/Spring.png");
-        weathers_to_cache.push_back("cache/weathers/St Patricks.png");
-        weathers_to_cache.push_back("cache/weathers/Sunny.png");
-        weathers_to_cache.push_back("cache/weathers/Undersea.png");
-        weathers_to_cache.push_back("cache/weathers/Valentines.png");
-        weathers_to_cache.push_back("cache/weathers/Warp.png");
-        weathers_to_cache.push_back("cache/weathers/princepersia.png");
-        weathers_to_cache.push_back("cache/weathers/vapor.png");
-
-        for (const auto& texture_path : textures_to_cache) {
-            if (!std::filesystem::exists(texture_path))
-                continue;
-            sf::Texture* draw = new sf::Texture();
-            draw->loadFromFile(texture_path);
-            t_cache.insert_or_assign(utils::replace_text(texture_path, ".png", ".rttex"), std::move(draw));
-        }
-        for (const auto& texture_path : weathers_to_cache) {
-            if (!std::filesystem::exists(texture_path))
-                continue;
-            sf::Texture* draw = new sf::Texture();
-            draw->loadFromFile(texture_path);
-            t_weather_cache.insert_or_assign(texture_path, std::move(draw));
-        }
-        for (const auto& texture_path : borders_to_cache) {
-            if (!std::filesystem::exists(texture_path))
-                continue;
-            sf::Texture* draw = new sf::Texture();
-            draw->loadFromFile(texture_path);
-            t_border_cache.insert_or_assign(texture_path, std::move(draw));
+        // directory order isn't stable across filesystems, sort so the atlas hash only changes with the content
+        std::stable_sort(textures_to_cache.begin(), textures_to_cache.end(), [](const auto& a, const auto& b) {
+            return a.second.starts_with("cache/sprites") != b.second.starts_with("cache/sprites") ? a.second.starts_with("cache/sprites") : a.first < b.first;
+        });
+        std::sort(borders_to_cache.begin(), borders_to_cache.end());
+
+        weathers_to_cache.emplace_back("Apocalypse.png", "cache/weathers/Apocalypse.png");
+        weathers_to_cache.emplace_back("Arid.png", "cache/weathers/Arid.png");
+        weathers_to_cache.emplace_back("Ascended Ship.png", "cache/weathers/Ascended Ship.png");
+        weathers_to_cache.emplace_back("Autumn.png", "cache/weathers/Autumn.png");
+        weathers_to_cache.emplace_back("Balloon.png", "cache/weathers/Balloon.png");
+        weathers_to_cache.emplace_back("Beach.png", "cache/weathers/Beach.png");
+        weathers_to_cache.emplace_back("Bountiful.png", "cache/weathers/Bountiful.png");
+        weathers_to_cache.emplace_back("Celebrity Hills.png", "cache/weathers/Celebrity Hills.png");
+        weathers_to_cache.emplace_back("Comet.png", "cache/weathers/Comet.png");
+        weathers_to_cache.emplace_back("Descended Ship.png", "cache/weathers/Descended Ship.png");
+        weathers_to_cache.emplace_back("Digital Rain.png", "cache/weathers/Digital Rain.png");
+        weathers_to_cache.emplace_back("Epoch - Iceberg.png", "cache/weathers/Epoch - Iceberg.png");
+        weathers_to_cache.emplace_back("Epoch - Lava.png", "cache/weathers/Epoch - Lava.png");
+        weathers_to_cache.emplace_back("Epoch - Skylands.png", "cache/weathers/Epoch - Skylands.png");
+        weathers_to_cache.emplace_back("Frozen Cliffs.png", "cache/weathers/Frozen Cliffs.png");
+        weathers_to_cache.emplace_back("Harvest.png", "cache/weathers/Harvest.png");
+        weathers_to_cache.emplace_back("Hospital.png", "cache/weathers/Hospital.png");
+        weathers_to_cache.emplace_back("Howling Sky.png", "cache/weathers/Howling Sky.png");
+        weathers_to_cache.emplace_back("Jungle.png", "cache/weathers/Jungle.png");
+        weathers_to_cache.emplace_back("Legendary City.png", "cache/weathers/Legendary City.png");
+        weathers_to_cache.emplace_back("Mars.png", "cache/weathers/Mars.png");
+        weathers_to_cache.emplace_back("Meteor Shower.png", "cache/weathers/Meteor Shower.png");
+        weathers_to_cache.emplace_back("Monochrome.png", "cache/weathers/Monochrome.png");
+        weathers_to_cache.emplace_back("Night.png", "cache/weathers/Night.png");
+        weathers_to_cache.emplace_back("Nothing.png", "cache/weathers/Nothing.png");
+        weathers_to_cache.emplace_back("Pagoda.png", "cache/weathers/Pagoda.png");
+        weathers_to_cache.emplace_back("Party.png", "cache/weathers/Party.png");
+        weathers_to_cache.emplace_back("Pineapples.png", "cache/weathers/Pineapples.png");
+        weathers_to_cache.emplace_back("Rainy.png", "cache/weathers/Rainy.png");
+        weathers_to_cache.emplace_back("Snowy Night.png", "cache/weathers/Snowy Night.png");
+        weathers_to_cache.emplace_back("Snowy.png", "cache/weathers/Snowy.png");
+        weathers_to_cache.emplace_back("Spooky.png", "cache/weathers/Spooky.png");
+        weathers_to_cache.emplace_back("Spring.png", "cache/weathers/Spring.png");
+        weathers_to_cache.emplace_back("St Patricks.png", "cache/weathers/St Patricks.png");
+        weathers_to_cache.emplace_back("Sunny.png", "cache/weathers/Sunny.png");
+        weathers_to_cache.emplace_back("Undersea.png", "cache/weathers/Undersea.png");
+        weathers_to_cache.emplace_back("Valentines.png", "cache/weathers/Valentines.png");
+        weathers_to_cache.emplace_back("Warp.png", "cache/weathers/Warp.png");
+        weathers_to_cache.emplace_back("princepersia.png", "cache/weathers/princepersia.png");
+        weathers_to_cache.emplace_back("vapor.png", "cache/weathers/vapor.png");
+
+        t_sprites.build(textures_to_cache);
+        t_weathers.build(weathers_to_cache);
+        t_borders.build(borders_to_cache);
+
+        const std::pair<eRenderSprite, std::string> render_sprites[] = {
+            { RENDER_SPRITE_TILES_PAGE1, "tiles_page1.rttex" },
+            { RENDER_SPRITE_TILES_PAGE5, "tiles_page5.rttex" },
+            { RENDER_SPRITE_SEED, "seed.rttex" },
+            { RENDER_SPRITE_PICKUP_BOX, "pickup_box.rttex" },
+            { RENDER_SPRITE_LOCK_OUTLINE, "lock_outline.rttex" },
+            { RENDER_SPRITE_WATER, "water.rttex" },
+            { RENDER_SPRITE_FIRE, "fire.rttex" },
+            { RENDER_SPRITE_GAME_ICONS, "game_icons.rttex" },
+            { RENDER_SPRITE_SERVER_LOGO, "server_logo.rttex" },
+            { RENDER_SPRITE_PLAYER_ARM, "player_arm.rttex" },
+            { RENDER_SPRITE_PLAYER_HEAD, "player_head.rttex" },
+            { RENDER_SPRITE_PLAYER_EXTRALEG, "player_extraleg.rttex" },
+            { RENDER_SPRITE_PLAYER_FEET, "player_feet.rttex" },
+            { RENDER_SPRITE_PLAYER_EYES, "player_eyes.rttex" },
+            { RENDER_SPRITE_PLAYER_EYES2, "player_eyes2.rttex" },
+            { RENDER_SPRITE_DEVELOPER_FLAG, "zz.rttex" }
+        };
+        for (const auto& [sprite, file] : render_sprites)
+            m_render_sprites[sprite] = t_sprites.get_sprite_id(file);
+        for (std::size_t weather = 0; weather < m_weather_sprites.size(); ++weather)
+            m_weather_sprites[weather] = t_weathers.get_sprite_id(v_background_path[weather]);
+
+        m_item_sprites.clear();
+        for (const auto& item : ItemDatabase::GetItems()) {
+            if (item.m_id >= m_item_sprites.size())
+                m_item_sprites.resize(item.m_id + 1, SpriteAtlas::INVALID_SPRITE);
+            m_item_sprites[item.m_id] = t_sprites.get_sprite_id(std::string{ item.m_texture });
         }
 
         sf_century = new sf::Font();
@@ -162,17 +181,68 @@ namespace GTServer {
         lut_8bit[0] = 12;
 
         fmt::print("WorldRender initialized,\n"
-            " |-> {} sprite caches, {} weather caches and {} border caches are loaded.\n", t_cache.size(), t_weather_cache.size(), t_border_cache.size());
+            " |-> {} sprite caches, {} weather caches and {} border caches are loaded.\n", t_sprites.get_sprites_count(), t_weathers.get_sprites_count(), t_borders.get_sprites_count());
+        fmt::print(" |-> packed into {} atlas pages ({}).\n", t_sprites.get_pages_count() + t_weathers.get_pages_count() + t_borders.get_pages_count(),
+            t_sprites.is_from_disk() && t_weathers.is_from_disk() && t_borders.is_from_disk() ? "cached" : "rebuilt");
+        m_loaded.store(true);
     }
 
-    sf::Texture* WorldRender::get_texture_from_cache__interface(const std::string& file) {
-        if (auto it = t_cache.find(fmt::format("cache/sprites/{}", file)); it != t_cache.end())
-            return it->second;
-        if (auto it = t_cache.find(fmt::format("cache/locale/{}", file)); it != t_cache.end())
-            return it->second;
-        return nullptr;
+    const SpriteAtlas::Sprite* WorldRender::get_texture_from_cache__interface(const std::string& file) {
+        return t_sprites.get_sprite(t_sprites.get_sprite_id(file));
+    }
+    const SpriteAtlas::Sprite* WorldRender::get_item_sprite(const ItemInfo* item) const {
+        if (item->m_id >= m_item_sprites.size())
+            return nullptr;
+        return t_sprites.get_sprite(m_item_sprites[item->m_id]);
+    }
+    void WorldRender::draw_sprite(sf::RenderTarget& target, sf::VertexArray& vertices, const SpriteAtlas::Sprite* sprite) const {
+        for (std::size_t i = 0; i < vertices.getVertexCount(); ++i)
+            vertices[i].texCoords += sprite->m_origin;
+        target.draw(vertices, sprite->m_texture);
     }
-    WorldRender::eRenderResult WorldRender::render__interface(ServerPool* server_pool, const std::shared_ptr<World>& world) {
+    void WorldRender::bind_sprite(sf::Sprite& target, const SpriteAtlas::Sprite* sprite, const sf::IntRect& rect) const {
+        target.setTexture(*sprite->m_texture);
+        target.setTextureRect(sf::IntRect(rect.left + static_cast<int>(sprite->m_origin.x), rect.top + static_cast<int>(sprite->m_origin.y), rect.width, rect.height));
+    }
+    WorldRender::eRenderResult WorldRender::render__interface(ServerPool* server_pool, const std::shared_ptr<const WorldSnapshot>& world) {
+        if (!m_loaded.load())
+            return RENDER_RESULT_FAILED;
+        std::scoped_lock lock{ m_render_mutex };
+        RenderCache& cache = m_render_cache[world->GetName()];
+        cache.m_used_at = ++m_render_tick;
+        if (cache.m_snapshot && cache.m_snapshot->GetContentVersion() == world->GetContentVersion() && std::filesystem::exists(fmt::format("renders/{}.png", world->GetName())))
+            return RENDER_RESULT_SUCCESS;
+
+        std::vector<bool> dirty_chunks{};
+        if (cache.m_snapshot && cache.m_tiles.getSize() == sf::Vector2u(world->GetSize().m_x * 32, world->GetSize().m_y * 32))
+            dirty_chunks = world->GetChangedChunks(*cache.m_snapshot);
+        cache.m_snapshot.reset();
+
+        eRenderResult result = this->render_world(server_pool, world, dirty_chunks, cache.m_tiles);
+        if (result != RENDER_RESULT_SUCCESS) {
+            m_render_cache.erase(world->GetName());
+            return result;
+        }
+        cache.m_snapshot = world;
+
+        if (m_render_cache.size() > MAX_RENDER_CACHES) {
+            auto oldest = std::min_element(m_render_cache.begin(), m_render_cache.end(), [](const auto& a, const auto& b) {
+                return a.second.m_used_at < b.second.m_used_at;
+            });
+            m_render_cache.erase(oldest);
+        }
+
+        std::size_t cache_memory{ MemoryUsage::of(m_render_cache) };
+        for (const auto& [name, entry] : m_render_cache)
+            cache_memory += MemoryUsage::of(name) + static_cast<std::size_t>(entry.m_tiles.getSize().x) * entry.m_tiles.getSize().y * 4;
+        m_cache_memory.store(cache_memory);
+        return result;
+    }
+    std::size_t WorldRender::get_atlas_memory_usage__interface() const {
+        return t_sprites.get_memory_usage() + t_weathers.get_memory_usage() + t_borders.get_memory_usage()
+            + MemoryUsage::of(m_item_sprites);
+    }
+    WorldRender::eRenderResult WorldRender::render_world(ServerPool* server_pool, const std::shared_ptr<const WorldSnapshot>& world, const std::vector<bool>& dirty_chunks, sf::Image& tile_layer) {
         auto remove_gt_color = [&]( std::string str, std::string from) {
             std::size_t start_pos = 0;
             bool found = false;
@@ -182,6 +252,23 @@ namespace GTServer {
         };
         try {
         PlayerTable* player_db = (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE);
+        std::vector<bool> tile_filter{};
+        if (!dirty_chunks.empty()) {
+            // two rings of tiles around a dirty chunk are redrawn as well. The inner ring's connected textures and
+            // shadows depend on the chunk and it's copied back with it, the outer one only casts onto the inner one
+            const CL_Vec2i chunks = world->GetChunkCount();
+            const int chunk_size = static_cast<int>(World::RENDER_CHUNK_SIZE);
+            tile_filter.assign(world->GetTileCount(), false);
+            for (std::size_t chunk = 0; chunk < dirty_chunks.size(); ++chunk) {
+                if (!dirty_chunks[chunk])
+                    continue;
+                const int chunk_x = static_cast<int>(chunk) % chunks.m_x, chunk_y = static_cast<int>(chunk) / chunks.m_x;
+                for (int y = std::max(chunk_y * chunk_size - 2, 0); y < std::min((chunk_y + 1) * chunk_size + 2, world->GetSize().m_y); ++y) {
+                    for (int x = std::max(chunk_x * chunk_size - 2, 0); x < std::min((chunk_x + 1) * chunk_size + 2, world->GetSize().m_x); ++x)
+                        tile_filter[y * world->GetSize().m_x + x] = true;
+                }
+            }
+        }
         int lut_4bit[] = { 12, 11, 15, 8, 14, 7, 13, 2, 10, 9, 6, 4, 5, 3, 1, 0 };
         sf::RenderTexture r_render_texture;
         sf::VertexArray v_background_array;
@@ -191,9 +278,9 @@ namespace GTServer {
         v_background_array.setPrimitiveType(sf::Quads);
 
         size_t size = 0;     
-        sf::Texture* world_background = nullptr;
-        if (auto it = t_weather_cache.find(fmt::format("cache/weathers/{}", v_background_path[world->GetWeatherId()])); it != t_weather_cache.end())
-            world_background = it->second;
+        const SpriteAtlas::Sprite* world_background = nullptr;
+        if (world->GetWeatherId() < m_weather_sprites.size())
+            world_background = t_weathers.get_sprite(m_weather_sprites[world->GetWeatherId()]);
 
         if (!world_background)
             return RENDER_RESULT_FAILED;
@@ -223,18 +310,20 @@ namespace GTServer {
         bg_vertex[2].texCoords = sf::Vector2f(texture_right, texture_top);
         bg_vertex[3].texCoords = sf::Vector2f(texture_right, texture_bottom);
 
-        r_render_texture.draw(v_background_array, world_background);
+        draw_sprite(r_render_texture, v_background_array, world_background);
         v_background_array.clear();
         size = 0;
 
-        for (std::size_t index = 0; index < world->GetTiles().size(); ++index)
+        for (std::size_t index = 0; index < world->GetTileCount(); ++index)
         {
             int x = static_cast<int>(index) % world->GetSize().m_x, y = static_cast<int>(index) / world->GetSize().m_x;
+            if (!tile_filter.empty() && !tile_filter[index])
+                continue;
             ItemInfo* background = ItemDatabase::GetItem(world->GetTile(index)->GetBackground());
             ItemInfo* foreground = ItemDatabase::GetItem(world->GetTile(index)->GetForeground());
 
             if (world->IsOwned() && background->m_item_type == ITEMTYPE_MUSIC_NOTE) {
-                Tile* main = world->GetTile(world->GetMainLock());
+                const Tile* main = world->GetTile(static_cast<std::size_t>(world->GetMainLock()));
                 if (!main)
                     continue;
                 if (main->IsLockFlagOn(LOCKFLAG_INVISIBLE_MUSIC_NOTE))
@@ -248,7 +337,7 @@ namespace GTServer {
             if (background->m_id != ITEM_BLANK) {
                 int offset_x = 0;
                 int offset_y = 0;
-                sf::Texture* bg_texture = get_texture_from_cache(background->m_texture);
+                const SpriteAtlas::Sprite* bg_texture = get_item_sprite(background);
                 if (!bg_texture)
                     continue;
                 switch (background->m_spread_type) {
@@ -368,7 +457,7 @@ namespace GTServer {
                 quad[2].texCoords = sf::Vector2f(_right, _top);
                 quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
@@ -382,6 +471,10 @@ namespace GTServer {
         for (auto it = world->GetObjects().cbegin(); it != world->GetObjects().cend();)
         {
             int x = static_cast<int>(it->second.m_pos.m_x), y = static_cast<int>(it->second.m_pos.m_y);
+            if (!tile_filter.empty() && !tile_filter[std::min<std::size_t>((y / 32) * world->GetSize().m_x + (x / 32), tile_filter.size() - 1)]) {
+                ++it;
+                continue;
+            }
             ItemInfo* object = ItemDatabase::GetItem(it->second.m_item_id);
 
             if (object->m_item_type != ITEMTYPE_SEED) {
@@ -412,7 +505,7 @@ namespace GTServer {
                 float _top = (offset_y + object->m_default_texture_y) * 32;
                 float _bottom = ((offset_y + object->m_default_texture_y) * 32) + 32;
 
-                sf::Texture* object_texture = get_texture_from_cache(object->m_texture);
+                const SpriteAtlas::Sprite* object_texture = get_item_sprite(object);
                 if (!object_texture)
                     continue;
                 size += 4;
@@ -434,7 +527,7 @@ namespace GTServer {
                 quad[2].color = sf::Color(0, 0, 0, 0xFF);
                 quad[3].color = sf::Color(0, 0, 0, 0xFF); // 145
 
-                r_block_shadows.draw(v_block_shadows, object_texture);
+                draw_sprite(r_block_shadows, v_block_shadows, object_texture);
                 v_block_shadows.clear();
                 size = 0;
             } else {
@@ -446,7 +539,7 @@ namespace GTServer {
                 int offset_x = object->m_seed_base;
                 int offset_y = 0;          
 
-                sf::Texture* seed_background = get_texture_from_cache("seed.rttex");
+                const SpriteAtlas::Sprite* seed_background = get_sprite(RENDER_SPRITE_SEED);
                 if (!seed_background)
                     continue;
                 float _left = offset_x * 16;
@@ -473,7 +566,7 @@ namespace GTServer {
                 quad[2].color = sf::Color(0, 0, 0, 0xFF);
                 quad[3].color = sf::Color(0, 0, 0, 0xFF); // 145
 
-                r_block_shadows.draw(v_block_shadows, seed_background);
+                draw_sprite(r_block_shadows, v_block_shadows, seed_background);
                 v_block_shadows.clear();
                 size = 0;
             }
@@ -499,7 +592,7 @@ namespace GTServer {
                 float _top2 = offset_y2 * 32;
                 float _bottom2 = (offset_y2 * 20) + 20;
 
-                sf::Texture* frame_texture = get_texture_from_cache("pickup_box.rttex");
+                const SpriteAtlas::Sprite* frame_texture = get_sprite(RENDER_SPRITE_PICKUP_BOX);
                 if (!frame_texture)
                     continue;
                 size += 4;
@@ -521,15 +614,17 @@ namespace GTServer {
                 quad[2].color = sf::Color(0, 0, 0, 0xFF);
                 quad[3].color = sf::Color(0, 0, 0, 0xFF); // 145
 
-                r_block_shadows.draw(v_block_shadows, frame_texture);
+                draw_sprite(r_block_shadows, v_block_shadows, frame_texture);
                 v_block_shadows.clear();
                 size = 0;
             }
             ++it;
         }
 
-        for (std::size_t index = 0; index < world->GetTiles().size(); ++index) {
+        for (std::size_t index = 0; index < world->GetTileCount(); ++index) {
             int x = static_cast<int>(index) % world->GetSize().m_x, y = static_cast<int>(index) / world->GetSize().m_x;
+            if (!tile_filter.empty() && !tile_filter[index])
+                continue;
             ItemInfo* foreground = ItemDatabase::GetItem(world->GetTile(index)->GetForeground());
             int scalePX = 0;                        
 
@@ -561,7 +656,7 @@ namespace GTServer {
                 continue;
 
             if (foreground->m_item_type != ITEMTYPE_SEED) {
-                sf::Texture* fg_texture = get_texture_from_cache(foreground->m_texture);
+                const SpriteAtlas::Sprite* fg_texture = get_item_sprite(foreground);
                 if (!fg_texture)
                     continue;
                 switch (foreground->m_spread_type) {
@@ -661,13 +756,13 @@ namespace GTServer {
                 quad[2].color = sf::Color(0, 0, 0, 0xFF);
                 quad[3].color = sf::Color(0, 0, 0, 0xFF);
 
-                r_block_shadows.draw(v_block_shadows, fg_texture);
+                draw_sprite(r_block_shadows, v_block_shadows, fg_texture);
                 v_block_shadows.clear();
                 size = 0;
 
                 switch(foreground->m_item_type) {
                     case ITEMTYPE_STEAMPUNK: {
-                        sf::Texture* steam_outline = get_texture_from_cache("tiles_page5.rttex");
+                        const SpriteAtlas::Sprite* steam_outline = get_sprite(RENDER_SPRITE_TILES_PAGE5);
                         if (!steam_outline)
                             continue;
                         int offset_x = 0;
@@ -731,7 +826,7 @@ namespace GTServer {
                         quad[2].color = sf::Color(0, 0, 0, 0xFF);
                         quad[3].color = sf::Color(0, 0, 0, 0xFF);
 
-                        r_block_shadows.draw(v_block_shadows, fg_texture);
+                        draw_sprite(r_block_shadows, v_block_shadows, fg_texture);
                         v_block_shadows.clear();
                         size = 0;
 
@@ -740,7 +835,7 @@ namespace GTServer {
                     } break;
                 }
             } else {
-                sf::Texture* tree_base = get_texture_from_cache("tiles_page1.rttex"); {
+                const SpriteAtlas::Sprite* tree_base = get_sprite(RENDER_SPRITE_TILES_PAGE1); {
                     if (!tree_base)
                         continue;
                     int off_seed_x = foreground->m_tree_base;
@@ -770,14 +865,14 @@ namespace GTServer {
                     quad[2].color = sf::Color(0, 0, 0, 0xFF);
                     quad[3].color = sf::Color(0, 0, 0, 0xFF);
 
-                    r_block_shadows.draw(v_block_shadows, tree_base);
+                    draw_sprite(r_block_shadows, v_block_shadows, tree_base);
                     v_block_shadows.clear();
                     size = 0;
 
                     offset_x = 0;
                     offset_y = 0;
                 }
-                sf::Texture* tree_leaves = get_texture_from_cache("tiles_page1.rttex"); {
+                const SpriteAtlas::Sprite* tree_leaves = get_sprite(RENDER_SPRITE_TILES_PAGE1); {
                     if (!tree_leaves)
                         continue;
 
@@ -808,7 +903,7 @@ namespace GTServer {
                     quad[2].color = sf::Color(0, 0, 0, 0xFF);
                     quad[3].color = sf::Color(0, 0, 0, 0xFF);
 
-                    r_block_shadows.draw(v_block_shadows, tree_leaves);
+                    draw_sprite(r_block_shadows, v_block_shadows, tree_leaves);
                     v_block_shadows.clear();
                     size = 0;
 
@@ -855,8 +950,10 @@ namespace GTServer {
             size = 0;
         }
 
-        for (std::size_t index = 0; index < world->GetTiles().size(); ++index) {
+        for (std::size_t index = 0; index < world->GetTileCount(); ++index) {
             int x = static_cast<int>(index) % world->GetSize().m_x, y = static_cast<int>(index) / world->GetSize().m_x;
+            if (!tile_filter.empty() && !tile_filter[index])
+                continue;
             ItemInfo* background = ItemDatabase::GetItem(world->GetTile(index)->GetBackground());
             ItemInfo* foreground = ItemDatabase::GetItem(world->GetTile(index)->GetForeground());
 
@@ -891,7 +988,7 @@ namespace GTServer {
                 int offset_y = 0;
                      
                 if (foreground->m_item_type != ITEMTYPE_SEED) {
-                    sf::Texture* fg_texture = get_texture_from_cache(foreground->m_texture);
+                    const SpriteAtlas::Sprite* fg_texture = get_item_sprite(foreground);
                     if (!fg_texture)
                         continue;
                     switch (foreground->m_spread_type) {
@@ -1129,14 +1226,14 @@ namespace GTServer {
 
                     // TODO: IsHasDisplayItem && FG == ITEM_TYPE_DISPLAYBLOCK
                     
-                    r_render_texture.draw(v_background_array, fg_texture);
+                    draw_sprite(r_render_texture, v_background_array, fg_texture);
                     v_background_array.clear();
                     size = 0;
 
                     offset_x = 0;
                     offset_y = 0;
                 } else {
-                    sf::Texture* tree_base = get_texture_from_cache("tiles_page1.rttex"); {
+                    const SpriteAtlas::Sprite* tree_base = get_sprite(RENDER_SPRITE_TILES_PAGE1); {
                         if (!tree_base)
                             continue;
                         int off_seed_x = foreground->m_tree_base;
@@ -1181,14 +1278,14 @@ namespace GTServer {
                         quad[2].texCoords = sf::Vector2f(_right, _top);
                         quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                        r_render_texture.draw(v_background_array, tree_base);
+                        draw_sprite(r_render_texture, v_background_array, tree_base);
                         v_background_array.clear();
                         size = 0;
 
                         offset_x = 0;
                         offset_y = 0;
                     }
-                    sf::Texture* tree_leaves = get_texture_from_cache("tiles_page1.rttex"); {
+                    const SpriteAtlas::Sprite* tree_leaves = get_sprite(RENDER_SPRITE_TILES_PAGE1); {
                         if (!tree_leaves)
                             continue;
 
@@ -1235,7 +1332,7 @@ namespace GTServer {
                         quad[2].texCoords = sf::Vector2f(_right, _top);
                         quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                        r_render_texture.draw(v_background_array, tree_leaves);
+                        draw_sprite(r_render_texture, v_background_array, tree_leaves);
                         v_background_array.clear();
                         size = 0;
 
@@ -1252,7 +1349,7 @@ namespace GTServer {
                                 break;
                             fruits -= 1;
 
-                            sf::Texture* tree_fruit = get_texture_from_cache(fruit->m_texture);
+                            const SpriteAtlas::Sprite* tree_fruit = get_item_sprite(fruit);
                             if (!tree_fruit)
                                 break;
                             int scalePX = -11;                        
@@ -1296,7 +1393,7 @@ namespace GTServer {
                             quad[2].texCoords = sf::Vector2f(_right, _top);
                             quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                            r_render_texture.draw(v_background_array, tree_fruit);
+                            draw_sprite(r_render_texture, v_background_array, tree_fruit);
                             v_background_array.clear();
                             size = 0;
 
@@ -1310,7 +1407,7 @@ namespace GTServer {
                 case ITEMTYPE_GAME_RESOURCES: {
                     if (!(foreground->m_id == ITEM_GAME_BLOCK || foreground->m_id == ITEM_GAME_GRAVE || foreground->m_id == ITEM_GAME_GOAL))
                         break;
-                    sf::Texture* icon_texture = this->get_texture_from_cache("game_icons.rttex");
+                    const SpriteAtlas::Sprite* icon_texture = get_sprite(RENDER_SPRITE_GAME_ICONS);
                     if (!icon_texture)
                         break;
                     auto* tile = world->GetTile(index);
@@ -1344,7 +1441,7 @@ namespace GTServer {
                         quad[2].color = sf::Color(0, 0, 0, 0xFF);
                         quad[3].color = sf::Color(0, 0, 0, 0xFF);
 
-                        r_render_texture.draw(v_background_array, icon_texture);
+                        draw_sprite(r_render_texture, v_background_array, icon_texture);
                         v_background_array.clear();
                         size = 0;
                     } {
@@ -1369,20 +1466,19 @@ namespace GTServer {
                         quad[2].texCoords = sf::Vector2f(_right, _top);
                         quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                        r_render_texture.draw(v_background_array, icon_texture);
+                        draw_sprite(r_render_texture, v_background_array, icon_texture);
                         v_background_array.clear();
                         size = 0;
                     }
                 } break;
                 case ITEMTYPE_FLAG: {
-                    sf::Texture* icon_texture = this->get_texture_from_cache(fmt::format("{}.rttex", world->GetTile(index)->GetLabel()));
+                    const SpriteAtlas::Sprite* icon_texture = get_texture_from_cache(fmt::format("{}.rttex", world->GetTile(index)->GetLabel()));
                     if (!icon_texture)
                         break;
                     auto* tile = world->GetTile(index);
                   
                     sf::Sprite p_flag;
-                    p_flag.setTexture(*icon_texture);
-                    p_flag.setTextureRect(sf::IntRect(0, 0, 15, 10));
+                    bind_sprite(p_flag, icon_texture, sf::IntRect(0, 0, 15, 10));
                     p_flag.setScale(1, 1.3);
                     if (tile->IsFlagOn(TILEFLAG_FLIPPED)) {
                         p_flag.setPosition((x * 32) - 1, ((world->GetSize().m_y - y) * 32) - 2);
@@ -1398,7 +1494,7 @@ namespace GTServer {
 
             switch(foreground->m_item_type) {
             case ITEMTYPE_STEAMPUNK: {
-                sf::Texture* steam_outline = get_texture_from_cache("tiles_page5.rttex");
+                const SpriteAtlas::Sprite* steam_outline = get_sprite(RENDER_SPRITE_TILES_PAGE5);
                 if (!steam_outline)
                     break;
                 int offset_x = 0;
@@ -1472,7 +1568,7 @@ namespace GTServer {
                 quad[2].texCoords = sf::Vector2f(_right, _top);
                 quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                r_render_texture.draw(v_background_array, steam_outline);
+                draw_sprite(r_render_texture, v_background_array, steam_outline);
                 v_background_array.clear();
                 size = 0;
 
@@ -1484,6 +1580,10 @@ namespace GTServer {
 
         for (auto it = world->GetObjects().cbegin(); it != world->GetObjects().cend();) {
             int x = static_cast<int>(it->second.m_pos.m_x), y = static_cast<int>(it->second.m_pos.m_y);
+            if (!tile_filter.empty() && !tile_filter[std::min<std::size_t>((y / 32) * world->GetSize().m_x + (x / 32), tile_filter.size() - 1)]) {
+                ++it;
+                continue;
+            }
             ItemInfo* object = ItemDatabase::GetItem(it->second.m_item_id);
             const uint8_t object_count = it->second.m_item_amount;
 
@@ -1508,7 +1608,7 @@ namespace GTServer {
                 float _top2 = offset_y2 * 32;
                 float _bottom2 = (offset_y2 * 20) + 20;
 
-                sf::Texture* frame_texture = get_texture_from_cache("pickup_box.rttex");
+                const SpriteAtlas::Sprite* frame_texture = get_sprite(RENDER_SPRITE_PICKUP_BOX);
                 if (!frame_texture)
                     continue;
                 size += 4;
@@ -1530,7 +1630,7 @@ namespace GTServer {
                 quad[2].color = sf::Color(0xFF, 0xFF, 0xFF, 145);
                 quad[3].color = sf::Color(0xFF, 0xFF, 0xFF, 145);
 
-                r_render_texture.draw(v_background_array, frame_texture);
+                draw_sprite(r_render_texture, v_background_array, frame_texture);
                 v_background_array.clear();
                 size = 0;
             }
@@ -1560,7 +1660,7 @@ namespace GTServer {
                 float _top = (offset_y + object->m_default_texture_y) * 32;
                 float _bottom = ((offset_y + object->m_default_texture_y) * 32) + 32;
 
-                sf::Texture* object_texture = get_texture_from_cache(object->m_texture);
+                const SpriteAtlas::Sprite* object_texture = get_item_sprite(object);
                 if (!object_texture)
                     continue;
                 size += 4;
@@ -1577,7 +1677,7 @@ namespace GTServer {
                 quad[2].texCoords = sf::Vector2f(_right, _top);
                 quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                r_render_texture.draw(v_background_array, object_texture);
+                draw_sprite(r_render_texture, v_background_array, object_texture);
                 v_background_array.clear();
                 size = 0;
             } else {
@@ -1586,7 +1686,7 @@ namespace GTServer {
                 float top = (world->GetSize().m_y * 32) - (y + 2);
                 float bottom = ((world->GetSize().m_y * 32) - y) - 18;
 
-                sf::Texture* seed_background = get_texture_from_cache("seed.rttex"); {
+                const SpriteAtlas::Sprite* seed_background = get_sprite(RENDER_SPRITE_SEED); {
                     if (!seed_background)
                         continue;
                     int offset_x = object->m_seed_base;
@@ -1624,12 +1724,12 @@ namespace GTServer {
                     quad[2].texCoords = sf::Vector2f(_right, _top);
                     quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                    r_render_texture.draw(v_background_array, seed_background);
+                    draw_sprite(r_render_texture, v_background_array, seed_background);
                     v_background_array.clear();
                     size = 0;
                 }
 
-                sf::Texture* seed_foreground = get_texture_from_cache("seed.rttex"); {
+                const SpriteAtlas::Sprite* seed_foreground = get_sprite(RENDER_SPRITE_SEED); {
                     if (!seed_foreground)
                         continue;
                     int offset_x = object->m_seed_overlay;
@@ -1667,7 +1767,7 @@ namespace GTServer {
                     quad[2].texCoords = sf::Vector2f(_right, _top);
                     quad[3].texCoords = sf::Vector2f(_right, _bottom);
 
-                    r_render_texture.draw(v_background_array, seed_foreground);
+                    draw_sprite(r_render_texture, v_background_array, seed_foreground);
                     v_background_array.clear();
                     size = 0;
                 }
@@ -1694,7 +1794,7 @@ namespace GTServer {
                 float _top2 = offset_y2 * 32;
                 float _bottom2 = (offset_y2 * 20) + 20;
 
-                sf::Texture* frame_texture = get_texture_from_cache("pickup_box.rttex"); {
+                const SpriteAtlas::Sprite* frame_texture = get_sprite(RENDER_SPRITE_PICKUP_BOX); {
                     if (!frame_texture)
                         continue;
                     size += 4;
@@ -1716,7 +1816,7 @@ namespace GTServer {
                     quad[2].color = sf::Color(0xFF, 0xFF, 0xFF, 110);
                     quad[3].color = sf::Color(0xFF, 0xFF, 0xFF, 110);
 
-                    r_render_texture.draw(v_background_array, frame_texture);
+                    draw_sprite(r_render_texture, v_background_array, frame_texture);
                     v_background_array.clear();
                     size = 0;
                 }
@@ -1735,8 +1835,10 @@ namespace GTServer {
             ++it;
         }
 
-        for (std::size_t index = 0; index < world->GetTiles().size(); ++index) {
+        for (std::size_t index = 0; index < world->GetTileCount(); ++index) {
             int x = static_cast<int>(index) % world->GetSize().m_x, y = static_cast<int>(index) / world->GetSize().m_x;
+            if (!tile_filter.empty() && !tile_filter[index])
+                continue;
             ItemInfo* background = ItemDatabase::GetItem(world->GetTile(index)->GetBackground());
             ItemInfo* foreground = ItemDatabase::GetItem(world->GetTile(index)->GetForeground());
 
@@ -1746,7 +1848,7 @@ namespace GTServer {
             float bottom = ((world->GetSize().m_y - y) * 32) - 32;
 
             /*if (world->GetTile(index)->IsFlagOn(TILEFLAG_WATER)) {
-                sf::Texture* bg_texture = get_texture_from_cache("water.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_WATER);
                 if (!bg_texture)
                     continue;
                 
@@ -1808,11 +1910,11 @@ namespace GTServer {
                 quad[2].color = sf::Color(0xFF, 0xFF, 0xFF, 160);
                 quad[3].color = sf::Color(0xFF, 0xFF, 0xFF, 160);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             } else */if (world->GetTile(index)->IsFlagOn(TILEFLAG_FIRE)) {
-                sf::Texture* bg_texture = get_texture_from_cache("fire.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_FIRE);
                 if (!bg_texture)
                     continue;
                 int offset_x = 0;
@@ -1873,7 +1975,7 @@ namespace GTServer {
                 quad[2].color = sf::Color(0xFF, 0xFF, 0xFF, 150);
                 quad[3].color = sf::Color(0xFF, 0xFF, 0xFF, 150);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
@@ -1888,7 +1990,7 @@ namespace GTServer {
 
             if ((center_pos_locked || (world->GetTile(index)->GetBaseItem()->m_item_type == ITEMTYPE_LOCK && !world->GetTile(index)->GetBaseItem()->IsWorldLock()))
             && (!top_pos_locked && world->GetTile(index - world->GetSize().m_x)->GetParent() != world->GetTile(index)->GetParent())) {
-                sf::Texture* bg_texture = get_texture_from_cache("lock_outline.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_LOCK_OUTLINE);
                 if (!bg_texture)
                     continue;
                 int offset_x = 3;
@@ -1918,14 +2020,14 @@ namespace GTServer {
                 quad[2].color = sf::Color(172, 0, 0, 0xFF);
                 quad[3].color = sf::Color(172, 0, 0, 0xFF);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
 
             if ((center_pos_locked || (world->GetTile(index)->GetBaseItem()->m_item_type == ITEMTYPE_LOCK && !world->GetTile(index)->GetBaseItem()->IsWorldLock()))
             && (!left_pos_locked && world->GetTile(index - 1)->GetParent() != world->GetTile(index)->GetParent())) {
-                sf::Texture* bg_texture = get_texture_from_cache("lock_outline.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_LOCK_OUTLINE);
                 if (!bg_texture)
                     continue;
                 int offset_x = 2;
@@ -1955,14 +2057,14 @@ namespace GTServer {
                 quad[2].color = sf::Color(172, 0, 0, 0xFF);
                 quad[3].color = sf::Color(172, 0, 0, 0xFF);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
 
             if ((center_pos_locked || (world->GetTile(index)->GetBaseItem()->m_item_type == ITEMTYPE_LOCK && !world->GetTile(index)->GetBaseItem()->IsWorldLock()))
             && (!bottom_pos_locked && world->GetTile(index + world->GetSize().m_x)->GetParent() != world->GetTile(index)->GetParent())) {
-                sf::Texture* bg_texture = get_texture_from_cache("lock_outline.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_LOCK_OUTLINE);
                 if (!bg_texture)
                     continue;
                 int offset_x = 1;
@@ -1992,14 +2094,14 @@ namespace GTServer {
                 quad[2].color = sf::Color(172, 0, 0, 0xFF);
                 quad[3].color = sf::Color(172, 0, 0, 0xFF);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
  
             if ((center_pos_locked || (world->GetTile(index)->GetBaseItem()->m_item_type == ITEMTYPE_LOCK && !world->GetTile(index)->GetBaseItem()->IsWorldLock()))
             && (!right_pos_locked && world->GetTile(index + 1)->GetParent() != world->GetTile(index)->GetParent())) {
-                sf::Texture* bg_texture = get_texture_from_cache("lock_outline.rttex");
+                const SpriteAtlas::Sprite* bg_texture = get_sprite(RENDER_SPRITE_LOCK_OUTLINE);
                 if (!bg_texture)
                     continue;
                 int offset_x = 0;
@@ -2029,11 +2131,56 @@ namespace GTServer {
                 quad[2].color = sf::Color(172, 0, 0, 0xFF);
                 quad[3].color = sf::Color(172, 0, 0, 0xFF);
 
-                r_render_texture.draw(v_background_array, bg_texture);
+                draw_sprite(r_render_texture, v_background_array, bg_texture);
                 v_background_array.clear();
                 size = 0;
             }
         }
+        if (tile_filter.empty()) {
+            tile_layer = r_render_texture.getTexture().copyToImage();
+        } else {
+            // copy the redrawn chunks over the previous tile layer, then put the result back as the base for the overlays
+            const CL_Vec2i chunks = world->GetChunkCount();
+            const int chunk_pixels = static_cast<int>(World::RENDER_CHUNK_SIZE) * 32;
+            sf::Image patch = r_render_texture.getTexture().copyToImage();
+            const int image_width = static_cast<int>(patch.getSize().x), image_height = static_cast<int>(patch.getSize().y);
+            for (std::size_t chunk = 0; chunk < dirty_chunks.size(); ++chunk) {
+                if (!dirty_chunks[chunk])
+                    continue;
+                // the chunk and the inner ring around it
+                const int chunk_x = (static_cast<int>(chunk) % chunks.m_x) * chunk_pixels, chunk_y = (static_cast<int>(chunk) / chunks.m_x) * chunk_pixels;
+                const int left = std::max(chunk_x - 32, 0), top = std::max(chunk_y - 32, 0);
+                const int right = std::min(chunk_x + chunk_pixels + 32, image_width), bottom = std::min(chunk_y + chunk_pixels + 32, image_height);
+                if (right <= left || bottom <= top)
+                    continue;
+                tile_layer.copy(patch, left, top, sf::IntRect(left, top, right - left, bottom - top));
+            }
+
+            sf::Texture tile_texture;
+            tile_texture.loadFromImage(tile_layer);
+            size += 4;
+            v_background_array.resize(size);
+            sf::Vertex* base = &v_background_array[size - 4];
+
+            float base_right = static_cast<float>(tile_layer.getSize().x);
+            float base_bottom = static_cast<float>(tile_layer.getSize().y);
+
+            base[0].position = sf::Vector2f(0, base_bottom);
+            base[1].position = sf::Vector2f(0, 0);
+            base[2].position = sf::Vector2f(base_right, 0);
+            base[3].position = sf::Vector2f(base_right, base_bottom);
+
+            base[0].texCoords = sf::Vector2f(0, 0);
+            base[1].texCoords = sf::Vector2f(0, base_bottom);
+            base[2].texCoords = sf::Vector2f(base_right, base_bottom);
+            base[3].texCoords = sf::Vector2f(base_right, 0);
+
+            r_render_texture.clear();
+            r_render_texture.draw(v_background_array, &tile_texture);
+            v_background_array.clear();
+            size = 0;
+        }
+
         float left2 = 0;
         float right2 = 3200;
         float top2 = 192;
@@ -2089,7 +2236,7 @@ namespace GTServer {
         footer_01.setPosition(sf::Vector2f(2956 - (footer_03.getGlobalBounds().width + 3) - x_text_offset, 190 - y_text_offset));
         r_render_texture.draw(footer_01);
 
-        sf::Texture* server_logo = get_texture_from_cache("server_logo.rttex");
+        const SpriteAtlas::Sprite* server_logo = get_sprite(RENDER_SPRITE_SERVER_LOGO);
         if (!server_logo)
             return RENDER_RESULT_FAILED;
         size += 4;
@@ -2119,7 +2266,7 @@ namespace GTServer {
         main_logo[2].texCoords = sf::Vector2f(_right, _top);
         main_logo[3].texCoords = sf::Vector2f(_right, _bottom);
 
-        r_render_texture.draw(v_background_array, server_logo);
+        draw_sprite(r_render_texture, v_background_array, server_logo);
         v_background_array.clear();
         size = 0;
         
@@ -2149,60 +2296,55 @@ namespace GTServer {
                     int x = 56;
                     int y = 125;
 
-                    sf::Texture* player_back = get_texture_from_cache(item[CLOTHTYPE_BACK]->m_texture);
+                    const SpriteAtlas::Sprite* player_back = get_item_sprite(item[CLOTHTYPE_BACK]);
                     if (player_back && item[CLOTHTYPE_BACK]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_BACK]->m_texture_x;
                         int y_off = item[CLOTHTYPE_BACK]->m_texture_y;
 
                         sf::Sprite p_back;
-                        p_back.setTexture(*player_back);
-                        p_back.setTextureRect(sf::IntRect(x_off * 32, (y_off * 2) * 32, 32, 32));
+                        bind_sprite(p_back, player_back, sf::IntRect(x_off * 32, (y_off * 2) * 32, 32, 32));
                         p_back.setPosition(x, y);
                         p_back.setScale(3, -3);
                         r_render_texture.draw(p_back);
                     }
 
-                    sf::Texture* player_arm_right = get_texture_from_cache("player_arm.rttex");
+                    const SpriteAtlas::Sprite* player_arm_right = get_sprite(RENDER_SPRITE_PLAYER_ARM);
                     if (player_arm_right) {
                         sf::Sprite p_arm_right;
-                        p_arm_right.setTexture(*player_arm_right);
-                        p_arm_right.setTextureRect(sf::IntRect(0, 0, 32, 32));
+                        bind_sprite(p_arm_right, player_arm_right, sf::IntRect(0, 0, 32, 32));
                         p_arm_right.setPosition(x + 63, y - 54);
                         p_arm_right.setScale(3, -3);
                         p_arm_right.setColor(sf::Color(skin_color.GetRed(), skin_color.GetGreen(), skin_color.GetBlue(), skin_color.GetAlpha()));
                         r_render_texture.draw(p_arm_right);
                     }
 
-                    sf::Texture* player_body = get_texture_from_cache("player_head.rttex");
+                    const SpriteAtlas::Sprite* player_body = get_sprite(RENDER_SPRITE_PLAYER_HEAD);
                     if (player_body) {
                         sf::Sprite p_body;
-                        p_body.setTexture(*player_body);
-                        p_body.setTextureRect(sf::IntRect(0, 0, 32, 32));
+                        bind_sprite(p_body, player_body, sf::IntRect(0, 0, 32, 32));
                         p_body.setPosition(x, y);
                         p_body.setScale(3, -3);
                         p_body.setColor(sf::Color(skin_color.GetRed(), skin_color.GetGreen(), skin_color.GetBlue(), skin_color.GetAlpha()));
                         r_render_texture.draw(p_body);
                     }
 
-                    sf::Texture* player_extraleg = get_texture_from_cache("player_extraleg.rttex");
+                    const SpriteAtlas::Sprite* player_extraleg = get_sprite(RENDER_SPRITE_PLAYER_EXTRALEG);
                     if (player_extraleg) { // TODO
                         sf::Sprite p_extraleg;
-                        p_extraleg.setTexture(*player_extraleg);
-                        p_extraleg.setTextureRect(sf::IntRect(0, 0, 16, 16));
+                        bind_sprite(p_extraleg, player_extraleg, sf::IntRect(0, 0, 16, 16));
                         p_extraleg.setPosition(x + 24, y - 84);
                         p_extraleg.setScale(3, -3);
                         p_extraleg.setColor(sf::Color(skin_color.GetRed(), skin_color.GetGreen(), skin_color.GetBlue(), skin_color.GetAlpha()));
                         r_render_texture.draw(p_extraleg);
                     }
                 
-                    sf::Texture* player_feet = get_texture_from_cache(item[CLOTHTYPE_FEET]->m_id == ITEM_BLANK ? "player_feet.rttex" : item[CLOTHTYPE_FEET]->m_texture);
+                    const SpriteAtlas::Sprite* player_feet = item[CLOTHTYPE_FEET]->m_id == ITEM_BLANK ? get_sprite(RENDER_SPRITE_PLAYER_FEET) : get_item_sprite(item[CLOTHTYPE_FEET]);
                     if (player_feet) {
                         int x_off = item[CLOTHTYPE_FEET]->m_texture_x,
                             y_off = item[CLOTHTYPE_FEET]->m_texture_y;
 
                         sf::Sprite p_feet_left;
-                        p_feet_left.setTexture(*player_feet);
-                        p_feet_left.setTextureRect(sf::IntRect(x_off * 32, (y_off * 2) * 32, 32, 32));
+                        bind_sprite(p_feet_left, player_feet, sf::IntRect(x_off * 32, (y_off * 2) * 32, 32, 32));
                         p_feet_left.setPosition(x, y);
                         p_feet_left.setScale(3, -3);
                         if (item[CLOTHTYPE_FEET]->m_id == ITEM_BLANK)
@@ -2210,8 +2352,7 @@ namespace GTServer {
                         r_render_texture.draw(p_feet_left);
 
                         sf::Sprite p_feet_right;
-                        p_feet_right.setTexture(*player_feet);
-                        p_feet_right.setTextureRect(sf::IntRect(x_off * 32, ((y_off * 2) * 32) + 32, 32, 32));
+                        bind_sprite(p_feet_right, player_feet, sf::IntRect(x_off * 32, ((y_off * 2) * 32) + 32, 32, 32));
                         p_feet_right.setPosition(x, y);
                         p_feet_right.setScale(3, -3);
                         if (item[CLOTHTYPE_FEET]->m_id == ITEM_BLANK)
@@ -2219,74 +2360,69 @@ namespace GTServer {
                         r_render_texture.draw(p_feet_right);
                     }
 
-                    sf::Texture* player_eyes_default = get_texture_from_cache("player_eyes.rttex");
+                    const SpriteAtlas::Sprite* player_eyes_default = get_sprite(RENDER_SPRITE_PLAYER_EYES);
                     if (player_eyes_default) {
                         int x_off = 0;
                         int y_off = 0;
 
                         sf::Sprite p_eyes;
-                        p_eyes.setTexture(*player_eyes_default);
-                        p_eyes.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_eyes, player_eyes_default, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_eyes.setPosition(x, y);
                         p_eyes.setScale(3, -3);
                         r_render_texture.draw(p_eyes);
                     }
 
-                    sf::Texture* player_eyes_default_2 = get_texture_from_cache("player_eyes.rttex");
+                    const SpriteAtlas::Sprite* player_eyes_default_2 = get_sprite(RENDER_SPRITE_PLAYER_EYES);
                     if (player_eyes_default_2) {
                         int x_off = 0;
                         int y_off = 4;
 
                         sf::Sprite p_eyes;
-                        p_eyes.setTexture(*player_eyes_default_2);
-                        p_eyes.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_eyes, player_eyes_default_2, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_eyes.setPosition(x, y);
                         p_eyes.setScale(3, -3);
                         p_eyes.setColor(sf::Color(skin_color.GetRed(), skin_color.GetGreen(), skin_color.GetBlue(), skin_color.GetAlpha()));
                         r_render_texture.draw(p_eyes);
                     }
 
-                    sf::Texture* player_eyes_default_3 = get_texture_from_cache("player_eyes2.rttex");
+                    const SpriteAtlas::Sprite* player_eyes_default_3 = get_sprite(RENDER_SPRITE_PLAYER_EYES2);
                     if (player_eyes_default_3) {
                         int x_off = 0;
                         int y_off = 0;
 
                         sf::Sprite p_eyes;
-                        p_eyes.setTexture(*player_eyes_default_3);
-                        p_eyes.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_eyes, player_eyes_default_3, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_eyes.setPosition(x, y);
                         p_eyes.setScale(3, -3);
                         p_eyes.setColor(sf::Color(0, 0, 0, 225));
                         r_render_texture.draw(p_eyes);
                     }
 
-                    sf::Texture* player_neck = get_texture_from_cache(item[CLOTHTYPE_NECKLACE]->m_texture);
+                    const SpriteAtlas::Sprite* player_neck = get_item_sprite(item[CLOTHTYPE_NECKLACE]);
                     if (player_neck && item[CLOTHTYPE_NECKLACE]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_NECKLACE]->m_texture_x,
                             y_off = item[CLOTHTYPE_NECKLACE]->m_texture_y;
 
                         sf::Sprite p_neck;
-                        p_neck.setTexture(*player_neck);
-                        p_neck.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_neck, player_neck, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_neck.setPosition(x, y);
                         p_neck.setScale(3, -3);
                         r_render_texture.draw(p_neck);
                     }
 
-                    sf::Texture* player_eyes = get_texture_from_cache(item[CLOTHTYPE_FACE]->m_texture);
+                    const SpriteAtlas::Sprite* player_eyes = get_item_sprite(item[CLOTHTYPE_FACE]);
                     if (player_eyes && item[CLOTHTYPE_FACE]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_FACE]->m_texture_x,
                             y_off = item[CLOTHTYPE_FACE]->m_texture_y;
 
                         sf::Sprite p_eyes;
-                        p_eyes.setTexture(*player_eyes);
-                        p_eyes.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_eyes, player_eyes, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_eyes.setPosition(x, y);
                         p_eyes.setScale(3, -3);
                         r_render_texture.draw(p_eyes);
                     }
 
-                    sf::Texture* player_hair = get_texture_from_cache(item[CLOTHTYPE_MASK]->m_texture);
+                    const SpriteAtlas::Sprite* player_hair = get_item_sprite(item[CLOTHTYPE_MASK]);
                     if (player_hair && item[CLOTHTYPE_MASK]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_MASK]->m_texture_x,
                             y_off = item[CLOTHTYPE_MASK]->m_texture_y;
@@ -2307,44 +2443,40 @@ namespace GTServer {
                         }
 
                         sf::Sprite p_mask;
-                        p_mask.setTexture(*player_hair);
-                        p_mask.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_mask, player_hair, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_mask.setPosition(actual_x, actual_y);
                         p_mask.setScale(3, -3);
                         r_render_texture.draw(p_mask);
                     }
 
-                    sf::Texture* player_hat = get_texture_from_cache(item[CLOTHTYPE_HAIR]->m_texture);
+                    const SpriteAtlas::Sprite* player_hat = get_item_sprite(item[CLOTHTYPE_HAIR]);
                     if (player_hat && item[CLOTHTYPE_HAIR]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_HAIR]->m_texture_x,
                             y_off = item[CLOTHTYPE_HAIR]->m_texture_y;
 
                         sf::Sprite p_hat;
-                        p_hat.setTexture(*player_hat);
-                        p_hat.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_hat, player_hat, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_hat.setPosition(x, y + 45);
                         p_hat.setScale(3, -3);
                         r_render_texture.draw(p_hat);
                     }
 
-                    sf::Texture* player_hand = get_texture_from_cache(item[CLOTHTYPE_HAND]->m_texture);
+                    const SpriteAtlas::Sprite* player_hand = get_item_sprite(item[CLOTHTYPE_HAND]);
                     if (player_hand && item[CLOTHTYPE_HAND]->m_id != ITEM_BLANK) {
                         int x_off = item[CLOTHTYPE_HAND]->m_texture_x,
                             y_off = item[CLOTHTYPE_HAND]->m_texture_y;
 
                         sf::Sprite p_hand;
-                        p_hand.setTexture(*player_hand);
-                        p_hand.setTextureRect(sf::IntRect(x_off * 32, y_off * 32, 32, 32));
+                        bind_sprite(p_hand, player_hand, sf::IntRect(x_off * 32, y_off * 32, 32, 32));
                         p_hand.setPosition(x - 21, y - 54);
                         p_hand.setScale(3, -3);
                         r_render_texture.draw(p_hand);
                     }
 
-                    sf::Texture* player_arm_left = get_texture_from_cache("player_arm.rttex");
+                    const SpriteAtlas::Sprite* player_arm_left = get_sprite(RENDER_SPRITE_PLAYER_ARM);
                     if (player_arm_left) {
                         sf::Sprite p_arm_left;
-                        p_arm_left.setTexture(*player_arm_left);
-                        p_arm_left.setTextureRect(sf::IntRect(0, 0, 32, 32));
+                        bind_sprite(p_arm_left, player_arm_left, sf::IntRect(0, 0, 32, 32));
                         p_arm_left.setPosition(x + 18, y - 54);
                         p_arm_left.setScale(3, -3);
                         p_arm_left.setColor(sf::Color(skin_color.GetRed(), skin_color.GetGreen(), skin_color.GetBlue(), skin_color.GetAlpha()));
@@ -2373,22 +2505,20 @@ namespace GTServer {
                     r_render_texture.draw(player_name);
 
                     if (target->GetRole() == PLAYER_ROLE_DEVELOPER) {
-                        sf::Texture* player_flag = get_texture_from_cache("zz.rttex");
+                        const SpriteAtlas::Sprite* player_flag = get_sprite(RENDER_SPRITE_DEVELOPER_FLAG);
                         if (player_flag) {
                             sf::Sprite p_flag;
-                            p_flag.setTexture(*player_flag);
-                            p_flag.setTextureRect(sf::IntRect(0, 0, 15, 10));
+                            bind_sprite(p_flag, player_flag, sf::IntRect(0, 0, 15, 10));
                             p_flag.setPosition((x - player_name.getLocalBounds().width / 2) + 29, y + 32);
                             p_flag.setScale(2, -2);
                             r_render_texture.draw(p_flag);
                         }
                     }
                     else {
-                        sf::Texture* player_flag = get_texture_from_cache(fmt::format("{}.rttex", target->GetLoginDetail()->m_country));
+                        const SpriteAtlas::Sprite* player_flag = get_texture_from_cache(fmt::format("{}.rttex", target->GetLoginDetail()->m_country));
                         if (player_flag) {
                             sf::Sprite p_flag;
-                            p_flag.setTexture(*player_flag);
-                            p_flag.setTextureRect(sf::IntRect(0, 0, 15, 10));
+                            bind_sprite(p_flag, player_flag, sf::IntRect(0, 0, 15, 10));
                             p_flag.setPosition((x - player_name.getLocalBounds().width / 2) + 29, y + 32);
                             p_flag.setScale(2, -2);
                             r_render_texture.draw(p_flag);
@@ -2412,6 +2542,7 @@ namespace GTServer {
         }
         catch(std::exception& e) {
             fmt::print("error: {}\n", e.what());
+            return RENDER_RESULT_FAILED;
         }
         return RENDER_RESULT_SUCCESS;
     }
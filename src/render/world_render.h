@@ -1,35 +1,89 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <SFML/Graphics.hpp>
+#include <render/sprite_atlas.h>
 
 namespace GTServer {
     class World;
+    class WorldSnapshot;
     class ServerPool;
+    struct ItemInfo;
     class WorldRender {
     public:
         enum eRenderResult {
             RENDER_RESULT_SUCCESS,
             RENDER_RESULT_FAILED
         };
+        enum eRenderSprite {
+            RENDER_SPRITE_TILES_PAGE1,
+            RENDER_SPRITE_TILES_PAGE5,
+            RENDER_SPRITE_SEED,
+            RENDER_SPRITE_PICKUP_BOX,
+            RENDER_SPRITE_LOCK_OUTLINE,
+            RENDER_SPRITE_WATER,
+            RENDER_SPRITE_FIRE,
+            RENDER_SPRITE_GAME_ICONS,
+            RENDER_SPRITE_SERVER_LOGO,
+            RENDER_SPRITE_PLAYER_ARM,
+            RENDER_SPRITE_PLAYER_HEAD,
+            RENDER_SPRITE_PLAYER_EXTRALEG,
+            RENDER_SPRITE_PLAYER_FEET,
+            RENDER_SPRITE_PLAYER_EYES,
+            RENDER_SPRITE_PLAYER_EYES2,
+            RENDER_SPRITE_DEVELOPER_FLAG,
+            NUM_RENDER_SPRITES
+        };
 
     public:
         WorldRender() = default;
         ~WorldRender();
 
         void load_caches();
-        static sf::Texture* get_texture_from_cache(const std::string& file) { return get().get_texture_from_cache__interface(file); }
-        static eRenderResult render(ServerPool* server_pool, const std::shared_ptr<World>& world) { return get().render__interface(server_pool, world); }
+        static const SpriteAtlas::Sprite* get_texture_from_cache(const std::string& file) { return get().get_texture_from_cache__interface(file); }
+        static eRenderResult render(ServerPool* server_pool, const std::shared_ptr<const WorldSnapshot>& world) { return get().render__interface(server_pool, world); }
+        static bool is_loaded() { return get().m_loaded.load(); }
+        static std::size_t get_cache_memory_usage() { return get().get_cache_memory_usage__interface(); }
+        static std::size_t get_atlas_memory_usage() { return get().get_atlas_memory_usage__interface(); }
     public:
         static WorldRender& get() { static WorldRender ret; return ret; }
 
     private:
-        sf::Texture* get_texture_from_cache__interface(const std::string& file);
-        eRenderResult render__interface(ServerPool* server_pool, const std::shared_ptr<World>& world);
+        const SpriteAtlas::Sprite* get_texture_from_cache__interface(const std::string& file);
+        eRenderResult render__interface(ServerPool* server_pool, const std::shared_ptr<const WorldSnapshot>& world);
+        std::size_t get_cache_memory_usage__interface() const { return m_cache_memory.load(); }
+        std::size_t get_atlas_memory_usage__interface() const;
+        eRenderResult render_world(ServerPool* server_pool, const std::shared_ptr<const WorldSnapshot>& world, const std::vector<bool>& dirty_chunks, sf::Image& tile_layer);
+
+        const SpriteAtlas::Sprite* get_sprite(const eRenderSprite& sprite) const { return t_sprites.get_sprite(m_render_sprites[sprite]); }
+        const SpriteAtlas::Sprite* get_item_sprite(const ItemInfo* item) const;
+        void draw_sprite(sf::RenderTarget& target, sf::VertexArray& vertices, const SpriteAtlas::Sprite* sprite) const;
+        void bind_sprite(sf::Sprite& target, const SpriteAtlas::Sprite* sprite, const sf::IntRect& rect) const;
     private: 
-        std::unordered_map<std::string, sf::Texture*> t_cache;
-        std::unordered_map<std::string, sf::Texture*> t_weather_cache;
-        std::unordered_map<std::string, sf::Texture*> t_border_cache;
+        struct RenderCache {
+            // the last rendered snapshot, its pages tell which chunks changed since
+            std::shared_ptr<const WorldSnapshot> m_snapshot{};
+            uint64_t m_used_at{ 0 };
+            sf::Image m_tiles{};
+        };
+        static constexpr std::size_t MAX_RENDER_CACHES = 8;
+
+        std::mutex m_render_mutex{};
+        std::unordered_map<std::string, RenderCache> m_render_cache{};
+        uint64_t m_render_tick{ 0 };
+        std::atomic<bool> m_loaded{ false }; // caches are loaded in the background while players already join
+        std::atomic<std::size_t> m_cache_memory{ 0 }; // refreshed after every render, renders hold m_render_mutex for seconds
+
+        SpriteAtlas t_sprites{ "sprites", 4096 };
+        SpriteAtlas t_weathers{ "weathers", 4096 };
+        SpriteAtlas t_borders{ "borders", 4096 };
+
+        std::vector<uint32_t> m_item_sprites{};
+        std::array<uint32_t, NUM_RENDER_SPRITES> m_render_sprites{};
+        std::array<uint32_t, 65> m_weather_sprites{};
 
         sf::Font* sf_century;
         sf::Font* sf_gothic_regular;
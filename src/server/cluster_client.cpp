@@ -0,0 +1,330 @@
+#include <server/cluster_client.h>
+#include <fmt/core.h>
+#include <database/database.h>
+#include <database/kv_store.h>
+#include <player/player.h>
+#include <server/server_pool.h>
+#include <utils/binary_reader.h>
+#include <utils/binary_writer.h>
+#include <world/world_pool.h>
+
+namespace GTServer {
+    bool ClusterClient::Start(const int32_t& worker_id, const uint16_t& port) {
+#ifdef _WIN32
+        fmt::print("ClusterClient -> worker processes are only supported on POSIX systems\n");
+        return false;
+#else
+        m_worker_id = worker_id;
+        m_port = port;
+        m_reconnect_at = steady_clock::now();
+        m_active.store(true);
+        return true;
+#endif
+    }
+    void ClusterClient::Stop() {
+        if (!m_active.exchange(false))
+            return;
+        // the gateway releases our worlds and stops sending players here as soon as the connection is gone
+        std::scoped_lock lock{ m_mutex };
+        // the last store changes are still buffered, the socket is non-blocking so one Flush can leave them behind
+        if (m_connection.IsOpen() && !m_connection.Drain(config::shutdown::disconnect_timeout))
+            fmt::print("ClusterClient -> couldn't hand everything to the gateway before closing\n");
+        m_connection.Close();
+    }
+
+    void ClusterClient::Poll(ServerPool* servers) {
+        if (!m_active.load())
+            return;
+        std::vector<IpcMessage> messages{};
+        bool connected{ false };
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (!m_connection.IsOpen()) {
+                if (steady_clock::now() < m_reconnect_at)
+                    return;
+                m_reconnect_at = steady_clock::now() + std::chrono::seconds(1);
+                if (!m_connection.Connect(config::cluster::socket_path))
+                    return;
+                fmt::print("ClusterClient -> connected to the gateway as worker {}\n", m_worker_id);
+                // ownership is rebuilt from what the gateway sends back
+                m_world_owners.clear();
+                m_worker_ports.clear();
+
+                std::vector<uint8_t> data(sizeof(int32_t) + sizeof(uint16_t));
+                BinaryWriter writer{ data.data() };
+                writer.write<int32_t>(m_worker_id);
+                writer.write<uint16_t>(m_port);
+                m_connection.Send(IPC_MESSAGE_HELLO, data);
+                for (const auto& [key, value] : m_store_backlog)
+                    this->SendStoreChange(key, value);
+                m_store_backlog.clear();
+                connected = true;
+            }
+            if (!m_connection.Receive(messages))
+                fmt::print("ClusterClient -> lost the connection to the gateway\n");
+        }
+
+        if (connected) {
+            for (auto& server : servers->GetServers()) {
+                for (auto& [name, world] : server->GetWorldPool()->GetWorlds())
+                    this->ClaimWorld(name);
+            }
+            // anything asked for before the connection dropped may never have arrived
+            std::vector<std::string> claims{};
+            {
+                std::scoped_lock lock{ m_mutex };
+                for (auto& [world, claim] : m_claims)
+                    claims.push_back(world);
+            }
+            for (const auto& world : claims)
+                this->ClaimWorld(world);
+        }
+        for (const auto& message : messages)
+            this->HandleMessage(servers, message);
+
+        if (connected || m_report.GetPassedTime() >= m_report.GetTimeout()) {
+            std::vector<uint8_t> data(sizeof(uint32_t) * 2);
+            BinaryWriter writer{ data.data() };
+            writer.write<uint32_t>(static_cast<uint32_t>(servers->GetActivePlayers()));
+            writer.write<uint32_t>(static_cast<uint32_t>(servers->GetActiveWorlds()));
+            this->Send(IPC_MESSAGE_LOAD, data);
+            m_report.UpdateTime();
+
+            std::vector<std::string> expired{};
+            {
+                std::scoped_lock lock{ m_mutex };
+                std::erase_if(m_transfers, [](const auto& transfer) {
+                    return steady_clock::now() - transfer.second.second > config::cluster::transfer_timeout;
+                });
+                for (auto& [world, claim] : m_claims) {
+                    if (steady_clock::now() - claim.m_sent_at > config::cluster::claim_timeout)
+                        expired.push_back(world);
+                }
+            }
+            for (const auto& world : expired)
+                this->ResolveClaims(world, -1);
+        }
+        std::scoped_lock lock{ m_mutex };
+        m_connection.Flush();
+    }
+
+    int32_t ClusterClient::GetRemoteOwner(const std::string& world) {
+        if (!m_active.load())
+            return -1;
+        std::scoped_lock lock{ m_mutex };
+        auto it{ m_world_owners.find(world) };
+        if (it == m_world_owners.end() || it->second == m_worker_id)
+            return -1;
+        return it->second;
+    }
+    bool ClusterClient::NeedsClaim(const std::string& world) {
+        if (!m_active.load() || world.empty())
+            return false;
+        std::scoped_lock lock{ m_mutex };
+        auto it{ m_world_owners.find(world) };
+        return it == m_world_owners.end() || it->second != m_worker_id;
+    }
+    void ClusterClient::ClaimWorld(const std::string& world) {
+        if (!m_active.load())
+            return;
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (auto it = m_world_owners.find(world); it != m_world_owners.end() && it->second == m_worker_id)
+                return;
+        }
+        std::vector<uint8_t> data(sizeof(uint16_t) + world.size());
+        BinaryWriter writer{ data.data() };
+        writer.write(world);
+        this->Send(IPC_MESSAGE_CLAIM_WORLD, data);
+    }
+    void ClusterClient::ClaimWorld(const std::string& world, std::function<void(const int32_t&)> on_owner) {
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto [it, inserted]{ m_claims.try_emplace(world, Claim{ steady_clock::now() }) };
+            it->second.m_callbacks.push_back(std::move(on_owner));
+            // one request per world, everyone waiting on it gets the same answer
+            if (!inserted)
+                return;
+        }
+        std::vector<uint8_t> data(sizeof(uint16_t) + world.size());
+        BinaryWriter writer{ data.data() };
+        writer.write(world);
+        this->Send(IPC_MESSAGE_CLAIM_WORLD, data);
+    }
+    void ClusterClient::SetPresence(const uint32_t& user_id, const bool& online) {
+        if (!m_active.load() || user_id == 0)
+            return;
+        std::vector<uint8_t> data(sizeof(uint32_t) + sizeof(uint8_t));
+        BinaryWriter writer{ data.data() };
+        writer.write<uint32_t>(user_id);
+        writer.write<uint8_t>(online ? 1 : 0);
+        this->Send(IPC_MESSAGE_PRESENCE, data);
+    }
+    bool ClusterClient::Transfer(std::shared_ptr<Player> player, const std::string& world, const int32_t& worker) {
+        if (!m_active.load() || !player)
+            return false;
+        uint16_t port{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto it{ m_worker_ports.find(worker) };
+            if (!m_connection.IsOpen() || it == m_worker_ports.end())
+                return false;
+            port = it->second;
+
+            std::vector<uint8_t> data(sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint16_t) + world.size());
+            BinaryWriter writer{ data.data() };
+            writer.write<int32_t>(worker);
+            writer.write<uint32_t>(player->GetUserId());
+            writer.write(world);
+            m_connection.Send(IPC_MESSAGE_TRANSFER, data);
+        }
+        // the other worker loads the player from the database as soon as they reconnect
+        PlayerTable* db{ (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE) };
+        if (!db->Save(player))
+            fmt::print("PlayerTable::save, Failed to save {} before moving them to worker {}\n", player->GetRawName(), worker);
+        player->v_sender.OnSendToServer(port, 0, static_cast<int32_t>(player->GetUserId()), std::string{ config::server_default::address });
+        player->Disconnect(0U);
+        return true;
+    }
+    std::optional<std::string> ClusterClient::TakeTransfer(const uint32_t& user_id) {
+        std::scoped_lock lock{ m_mutex };
+        auto it{ m_transfers.find(user_id) };
+        if (it == m_transfers.end())
+            return std::nullopt;
+        std::string ret{ std::move(it->second.first) };
+        m_transfers.erase(it);
+        return ret;
+    }
+    void ClusterClient::Broadcast(const std::string& message) {
+        if (!m_active.load())
+            return;
+        const std::string_view text{ message.data(), std::min<std::size_t>(message.size(), UINT16_MAX) };
+        std::vector<uint8_t> data(sizeof(uint16_t) + text.size());
+        BinaryWriter writer{ data.data() };
+        writer.write(text);
+        this->Send(IPC_MESSAGE_BROADCAST, data);
+    }
+
+    void ClusterClient::StoreChanged(const std::string& key, const std::optional<std::string>& value) {
+        if (!m_active.load())
+            return;
+        std::scoped_lock lock{ m_mutex };
+        if (!m_connection.IsOpen()) {
+            m_store_backlog.insert_or_assign(key, value);
+            return;
+        }
+        this->SendStoreChange(key, value);
+    }
+
+    void ClusterClient::Send(const uint16_t& type, const std::vector<uint8_t>& data) {
+        std::scoped_lock lock{ m_mutex };
+        m_connection.Send(type, data);
+    }
+    void ClusterClient::SendStoreChange(const std::string& key, const std::optional<std::string>& value) {
+        std::vector<uint8_t> data(sizeof(uint16_t) + key.size() + (value ? sizeof(uint32_t) + value->size() : 0));
+        BinaryWriter writer{ data.data() };
+        writer.write(key);
+        if (!value) {
+            m_connection.Send(IPC_MESSAGE_STORE_REMOVE, data);
+            return;
+        }
+        writer.write<uint32_t>(static_cast<uint32_t>(value->size()));
+        writer.write(value->data(), value->size());
+        m_connection.Send(IPC_MESSAGE_STORE_PUT, data);
+    }
+    void ClusterClient::HandleMessage(ServerPool* servers, const IpcMessage& message) {
+        BinaryReader reader{ message.m_data };
+        switch (message.m_type) {
+        case IPC_MESSAGE_KICK: {
+            const uint32_t user_id{ reader.read<uint32_t>() };
+            if (auto player = servers->GetSession(user_id); player) {
+                player->v_sender.OnConsoleMessage("`4OOPS, `oSomeone else logged into this account!``");
+                player->Disconnect(0U);
+            }
+        } break;
+        case IPC_MESSAGE_WORKER_STATE: {
+            const int32_t worker{ reader.read<int32_t>() };
+            const uint16_t port{ reader.read<uint16_t>() };
+            const bool alive{ reader.read<uint8_t>() != 0 };
+            std::scoped_lock lock{ m_mutex };
+            if (alive)
+                m_worker_ports.insert_or_assign(worker, port);
+            else
+                m_worker_ports.erase(worker);
+        } break;
+        case IPC_MESSAGE_WORLD_OWNER: {
+            const std::string world{ reader.read_string() };
+            const int32_t owner{ reader.read<int32_t>() };
+            {
+                std::scoped_lock lock{ m_mutex };
+                if (owner == -1)
+                    m_world_owners.erase(world);
+                else
+                    m_world_owners.insert_or_assign(world, owner);
+            }
+            if (owner != -1 && owner != m_worker_id)
+                this->MoveWorld(servers, world, owner);
+            if (owner != -1)
+                this->ResolveClaims(world, owner);
+        } break;
+        case IPC_MESSAGE_TRANSFER: {
+            reader.read<int32_t>();
+            const uint32_t user_id{ reader.read<uint32_t>() };
+            std::string world{ reader.read_string() };
+            std::scoped_lock lock{ m_mutex };
+            m_transfers.insert_or_assign(user_id, std::make_pair(std::move(world), steady_clock::now()));
+        } break;
+        case IPC_MESSAGE_STORE_PUT: {
+            const std::string key{ reader.read_string() };
+            const uint32_t size{ reader.read<uint32_t>() };
+            KeyValueStore::Get().Apply(key, std::string{ reinterpret_cast<const char*>(reader.get() + reader.get_pos()), size });
+        } break;
+        case IPC_MESSAGE_STORE_REMOVE: {
+            KeyValueStore::Get().Apply(reader.read_string(), std::nullopt);
+        } break;
+        case IPC_MESSAGE_BROADCAST: {
+            const std::string text{ reader.read_string() };
+            for (auto& player : servers->GetPlayers()) {
+                if (player->IsFlagOn(PLAYERFLAG_LOGGED_ON))
+                    player->SendLog("{}", text);
+            }
+        } break;
+        default:
+            break;
+        }
+    }
+    void ClusterClient::MoveWorld(ServerPool* servers, const std::string& world, const int32_t& owner) {
+        // another worker claimed the world first, its copy wins and ours is dropped with whatever changed here
+        for (auto& server : servers->GetServers()) {
+            std::shared_ptr<WorldPool> world_pool{ server->GetWorldPool() };
+            auto worlds{ world_pool->GetWorlds() };
+            auto it{ worlds.find(world) };
+            if (it == worlds.end() || !it->second)
+                continue;
+            std::shared_ptr<World> local{ it->second };
+            const auto players{ local->GetPlayers(true) };
+            fmt::print("ClusterClient -> worker {} owns {}, moving {} players there\n", owner, world, players.size());
+
+            // dropped before anyone leaves, so the last one out doesn't save our copy over the owner's
+            world_pool->DiscardWorld(world);
+            for (auto& player : players) {
+                world_pool->OnPlayerLeave(local, player, false);
+                if (!this->Transfer(player, world, owner))
+                    world_pool->SendDefaultOffers(player);
+            }
+        }
+    }
+    void ClusterClient::ResolveClaims(const std::string& world, const int32_t& owner) {
+        std::vector<std::function<void(const int32_t&)>> callbacks{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            auto it{ m_claims.find(world) };
+            if (it == m_claims.end())
+                return;
+            callbacks = std::move(it->second.m_callbacks);
+            m_claims.erase(it);
+        }
+        for (auto& callback : callbacks)
+            callback(owner);
+    }
+}
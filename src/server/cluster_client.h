@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <config.h>
+#include <server/ipc.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    class Player;
+    class ServerPool;
+    // worker side of the cluster, keeps the gateway up to date with this process's load, sessions and worlds
+    // and moves players to the worker that owns the world they want to join
+    class ClusterClient {
+    public:
+        ClusterClient() = default;
+        ~ClusterClient() = default;
+
+        static ClusterClient& Get() {
+            static ClusterClient instance{};
+            return instance;
+        }
+
+        bool Start(const int32_t& worker_id, const uint16_t& port);
+        void Stop();
+        [[nodiscard]] bool IsActive() const { return m_active.load(); }
+        [[nodiscard]] int32_t GetWorkerId() const { return m_worker_id; }
+
+        // called by the service loop, handles the gateway's messages and sends the load report
+        void Poll(ServerPool* servers);
+
+        // the worker that has the world loaded if it isn't this one, -1 otherwise
+        [[nodiscard]] int32_t GetRemoteOwner(const std::string& world);
+        // true if the gateway hasn't given the world to this worker yet, it mustn't be loaded here before it did
+        [[nodiscard]] bool NeedsClaim(const std::string& world);
+        void ClaimWorld(const std::string& world);
+        // asks the gateway for the world, the callback runs on the service loop with the owner it picked or -1 if it didn't answer
+        void ClaimWorld(const std::string& world, std::function<void(const int32_t&)> on_owner);
+        void SetPresence(const uint32_t& user_id, const bool& online);
+        // redirects the player to the worker, who sends them into the world once they logged in there
+        bool Transfer(std::shared_ptr<Player> player, const std::string& world, const int32_t& worker);
+        std::optional<std::string> TakeTransfer(const uint32_t& user_id);
+        void Broadcast(const std::string& message);
+        // a change to this worker's KeyValueStore, the gateway writes it and passes it on to every worker
+        void StoreChanged(const std::string& key, const std::optional<std::string>& value);
+
+    private:
+        void Send(const uint16_t& type, const std::vector<uint8_t>& data);
+        void SendStoreChange(const std::string& key, const std::optional<std::string>& value);
+        void HandleMessage(ServerPool* servers, const IpcMessage& message);
+        void MoveWorld(ServerPool* servers, const std::string& world, const int32_t& owner);
+        void ResolveClaims(const std::string& world, const int32_t& owner);
+
+    private:
+        std::atomic<bool> m_active{ false };
+        int32_t m_worker_id{ -1 };
+        uint16_t m_port{ 0 };
+
+        std::mutex m_mutex{};
+        IpcConnection m_connection{};
+        steady_clock::time_point m_reconnect_at{};
+        TimingClock m_report{ config::cluster::report_interval };
+
+        std::unordered_map<std::string, int32_t> m_world_owners{};
+        std::unordered_map<int32_t, uint16_t> m_worker_ports{};
+        // players sent here by another worker, with the world they were on their way to
+        std::unordered_map<uint32_t, std::pair<std::string, steady_clock::time_point>> m_transfers{};
+        struct Claim {
+            steady_clock::time_point m_sent_at;
+            std::vector<std::function<void(const int32_t&)>> m_callbacks;
+        };
+        // claims waiting for the gateway's answer
+        std::unordered_map<std::string, Claim> m_claims{};
+        // store changes made while the gateway was away, sent once it's back
+        std::unordered_map<std::string, std::optional<std::string>> m_store_backlog{};
+    };
+}
@@ -3,16 +3,31 @@
 #include <fmt/color.h>
 #include <config.h>
 #include <server/http.h>
+#include <server/metrics.h>
 #include <proton/utils/text_scanner.h>
 
 namespace GTServer {
     HTTPServer::HTTPServer(const std::string& host, const uint16_t& port)
-        : m_config{ std::make_pair(host, port) }
+        : m_config{ std::make_pair(host, port) },
+        m_server_address{ std::string{ config::http::gt::address } },
+        m_server_port{ config::server_default::port }
     {
-        m_server = std::make_unique<httplib::SSLServer>("./cache/cert.pem", "./cache/key.pem"); 
+        m_server = std::make_unique<httplib::SSLServer>("./cache/cert.pem", "./cache/key.pem");
+        // over max_queued_requests the pool refuses the connection and httplib closes it right away
+        m_server->new_task_queue = [] { return new httplib::ThreadPool(config::http::worker_threads, config::http::max_queued_requests); };
+        m_server->set_keep_alive_max_count(config::http::keep_alive_max_count);
+        m_server->set_keep_alive_timeout(config::http::keep_alive_timeout);
+
+        if (SSL_CTX* ctx = m_server->ssl_context()) {
+            static const unsigned char session_id_context[] = "gtserver";
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_set_session_id_context(ctx, session_id_context, sizeof(session_id_context) - 1);
+            SSL_CTX_set_timeout(ctx, config::http::tls_session_timeout);
+        }
+        this->build_server_data();
     }
-    HTTPServer::~HTTPServer() { 
-        this->stop(); 
+    HTTPServer::~HTTPServer() {
+        this->stop();
     }
 
     bool HTTPServer::listen() {
@@ -22,30 +37,86 @@ namespace GTServer {
             return false;
         }
         fmt::print("HTTPServer Initialized, Listening to https://{}:{}\n", m_config.first, m_config.second);
-        std::thread(&HTTPServer::thread, this).detach();
-        return true; 
+        m_thread = std::thread(&HTTPServer::thread, this);
+        return true;
     }
-    void HTTPServer::stop() { 
-        m_server->stop();
-        m_server.release();
+    void HTTPServer::stop() {
+        if (m_server)
+            m_server->stop();
+        if (m_thread.joinable())
+            m_thread.join();
     }
 
     void HTTPServer::thread() {
+        m_server->set_pre_routing_handler([&](const httplib::Request& req, httplib::Response& res) {
+            if (this->accept_client(req.remote_addr))
+                return httplib::Server::HandlerResponse::Unhandled;
+            res.status = 429;
+            return httplib::Server::HandlerResponse::Handled;
+        });
+        // the logger runs once every request is answered, including the ones rejected above
+        m_server->set_logger([&](const httplib::Request& req, const httplib::Response&) {
+            this->release_client(req.remote_addr);
+        });
+
         m_server->Post("/growtopia/server_data.php", [&](const httplib::Request& req, httplib::Response& res) {
             if (req.params.empty() || req.get_header_value("User-Agent").find("UbiServices_SDK") == std::string::npos) {
                 res.status = 403;
                 return;
             }
-            TextScanner parser{};
-            parser.add("server", std::string{ config::http::gt::address });
-            parser.add<uint16_t>("port", 17091);
-            parser.add<int>("type", 1);
-            parser.add("#maint", "Server is under maintenance. We will be back online shortly. Thank you for your patience!");
-            parser.add("meta", "DIKHEAD");
-            res.set_content(std::string{ fmt::format("{}\nRTENDMARKERBS1001\n\n", parser.get_all_raw()) }, "text/html");
+            std::shared_ptr<const std::string> server_data = m_server_data.load();
+            res.set_content(server_data->data(), server_data->size(), "text/html");
+        });
+
+        m_server->Get("/metrics", [&](const httplib::Request& req, httplib::Response& res) {
+            if (config::http::metrics_local_only && req.remote_addr != "127.0.0.1" && req.remote_addr != "::1") {
+                res.status = 403;
+                return;
+            }
+            res.set_content(Metrics::Get().Collect(), "text/plain; version=0.0.4");
         });
-        
+
         m_server->listen_after_bind();
-        while(true);
+        fmt::print("HTTPServer stopped listening.\n");
+    }
+
+    void HTTPServer::set_server_data(const std::string& address, const uint16_t& port) {
+        {
+            std::scoped_lock lock{ m_server_data_mutex };
+            m_server_address = address;
+            m_server_port = port;
+        }
+        this->build_server_data();
+    }
+    void HTTPServer::set_maintenance(const bool& maintenance) {
+        {
+            std::scoped_lock lock{ m_server_data_mutex };
+            m_maintenance = maintenance;
+        }
+        this->build_server_data();
+    }
+    void HTTPServer::build_server_data() {
+        std::scoped_lock lock{ m_server_data_mutex };
+        TextScanner parser{};
+        parser.add("server", m_server_address);
+        parser.add<uint16_t>("port", m_server_port);
+        parser.add<int>("type", 1);
+        parser.add(m_maintenance ? "maint" : "#maint", "Server is under maintenance. We will be back online shortly. Thank you for your patience!");
+        parser.add("meta", "DIKHEAD");
+        m_server_data.store(std::make_shared<const std::string>(fmt::format("{}\nRTENDMARKERBS1001\n\n", parser.get_all_raw())));
+    }
+
+    bool HTTPServer::accept_client(const std::string& address) {
+        std::scoped_lock lock{ m_clients_mutex };
+        std::size_t& requests = m_clients[address];
+        return ++requests <= config::http::max_connections_per_ip;
+    }
+    void HTTPServer::release_client(const std::string& address) {
+        std::scoped_lock lock{ m_clients_mutex };
+        auto it = m_clients.find(address);
+        if (it == m_clients.end())
+            return;
+        if (--it->second == 0)
+            m_clients.erase(it);
     }
-}
\ No newline at end of file
+}
@@ -1,8 +1,13 @@
 #ifndef SERVER__HTTP_H
 #define SERVER__HTTP_H
+#include <atomic>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <iostream>
+#include <unordered_map>
 #include <httplib.h>
 
 namespace GTServer {
@@ -18,12 +23,32 @@ namespace GTServer {
         bool bind_to_port(const std::pair<std::string, uint16_t>& val) {
             return m_server->bind_to_port(val.first.c_str(), val.second);
         }
-        
+
+        void set_server_data(const std::string& address, const uint16_t& port);
+        void set_maintenance(const bool& maintenance);
+        [[nodiscard]] std::shared_ptr<const std::string> get_server_data() const { return m_server_data.load(); }
+
+    private:
+        void build_server_data();
+
+        bool accept_client(const std::string& address);
+        void release_client(const std::string& address);
+
     private:
         std::unique_ptr<httplib::SSLServer> m_server{};
-        
+        std::thread m_thread{};
+
         std::pair<std::string, uint16_t> m_config{};
+
+        std::mutex m_server_data_mutex{};
+        std::string m_server_address{};
+        uint16_t m_server_port{ 17091 };
+        bool m_maintenance{ false };
+        std::atomic<std::shared_ptr<const std::string>> m_server_data{};
+
+        std::mutex m_clients_mutex{};
+        std::unordered_map<std::string, std::size_t> m_clients{};
     };
 }
 
-#endif // SERVER__HTTP_H
\ No newline at end of file
+#endif // SERVER__HTTP_H
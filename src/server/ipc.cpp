@@ -0,0 +1,214 @@
+#include <server/ipc.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+#include <config.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace GTServer {
+#ifndef _WIN32
+    static bool set_non_blocking(const int& fd) {
+        const int flags{ fcntl(fd, F_GETFL, 0) };
+        return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+    static bool make_address(const std::string& path, sockaddr_un& address) {
+        if (path.size() >= sizeof(address.sun_path))
+            return false;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+    }
+#endif
+
+    IpcConnection::~IpcConnection() {
+        this->Close();
+    }
+
+    bool IpcConnection::Connect(const std::string& path) {
+        this->Close();
+#ifdef _WIN32
+        return false;
+#else
+        sockaddr_un address{};
+        if (!make_address(path, address))
+            return false;
+        const int fd{ socket(AF_UNIX, SOCK_STREAM, 0) };
+        if (fd == -1)
+            return false;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || !set_non_blocking(fd)) {
+            close(fd);
+            return false;
+        }
+        m_fd = fd;
+        return true;
+#endif
+    }
+    void IpcConnection::Close() {
+        if (m_fd == -1)
+            return;
+#ifndef _WIN32
+        close(m_fd);
+#endif
+        m_fd = -1;
+        m_send_buffer.clear();
+        m_receive_buffer.clear();
+    }
+
+    void IpcConnection::Send(const uint16_t& type, const std::vector<uint8_t>& data) {
+        if (m_fd == -1)
+            return;
+        const uint32_t size{ static_cast<uint32_t>(data.size()) };
+        const std::size_t offset{ m_send_buffer.size() };
+        m_send_buffer.resize(offset + HEADER_SIZE + data.size());
+        std::memcpy(m_send_buffer.data() + offset, &size, sizeof(uint32_t));
+        std::memcpy(m_send_buffer.data() + offset + sizeof(uint32_t), &type, sizeof(uint16_t));
+        if (!data.empty())
+            std::memcpy(m_send_buffer.data() + offset + HEADER_SIZE, data.data(), data.size());
+    }
+    bool IpcConnection::Flush() {
+#ifdef _WIN32
+        return false;
+#else
+        std::size_t sent{ 0 };
+        while (m_fd != -1 && sent < m_send_buffer.size()) {
+            const ssize_t result{ send(m_fd, m_send_buffer.data() + sent, m_send_buffer.size() - sent, MSG_NOSIGNAL) };
+            if (result > 0) {
+                sent += static_cast<std::size_t>(result);
+                continue;
+            }
+            if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (result == -1 && errno == EINTR)
+                continue;
+            this->Close();
+            return false;
+        }
+        m_send_buffer.erase(m_send_buffer.begin(), m_send_buffer.begin() + sent);
+        return m_fd != -1;
+#endif
+    }
+    bool IpcConnection::Drain(const std::chrono::milliseconds& timeout) {
+#ifdef _WIN32
+        return false;
+#else
+        const auto deadline{ std::chrono::steady_clock::now() + timeout };
+        while (this->Flush() && !m_send_buffer.empty()) {
+            const auto left{ std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()) };
+            if (left.count() <= 0)
+                return false;
+            pollfd descriptor{ m_fd, POLLOUT, 0 };
+            if (poll(&descriptor, 1, static_cast<int>(left.count())) == -1 && errno != EINTR)
+                return false;
+        }
+        return m_fd != -1;
+#endif
+    }
+    bool IpcConnection::Receive(std::vector<IpcMessage>& messages) {
+#ifdef _WIN32
+        return false;
+#else
+        uint8_t buffer[16 * 1024];
+        // what arrived before the peer went away is still handed out, it's only closed once that's parsed
+        bool open{ m_fd != -1 };
+        while (open) {
+            const ssize_t result{ recv(m_fd, buffer, sizeof(buffer), 0) };
+            if (result > 0) {
+                m_receive_buffer.insert(m_receive_buffer.end(), buffer, buffer + result);
+                continue;
+            }
+            if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (result == -1 && errno == EINTR)
+                continue;
+            open = false;
+        }
+
+        std::size_t pos{ 0 };
+        while (m_receive_buffer.size() - pos >= HEADER_SIZE) {
+            uint32_t size{};
+            uint16_t type{};
+            std::memcpy(&size, m_receive_buffer.data() + pos, sizeof(uint32_t));
+            std::memcpy(&type, m_receive_buffer.data() + pos + sizeof(uint32_t), sizeof(uint16_t));
+            if (size > config::cluster::max_message_size) {
+                fmt::print("IpcConnection -> dropping connection after a {} byte message\n", size);
+                this->Close();
+                return false;
+            }
+            if (m_receive_buffer.size() - pos - HEADER_SIZE < size)
+                break;
+            const auto begin{ m_receive_buffer.begin() + pos + HEADER_SIZE };
+            messages.push_back(IpcMessage{ type, std::vector<uint8_t>{ begin, begin + size } });
+            pos += HEADER_SIZE + size;
+        }
+        m_receive_buffer.erase(m_receive_buffer.begin(), m_receive_buffer.begin() + pos);
+        if (!open)
+            this->Close();
+        return open;
+#endif
+    }
+
+    IpcListener::~IpcListener() {
+        this->Close();
+    }
+
+    bool IpcListener::Listen(const std::string& path) {
+        this->Close();
+#ifdef _WIN32
+        fmt::print("IpcListener -> unix sockets are not supported on this platform\n");
+        return false;
+#else
+        sockaddr_un address{};
+        if (!make_address(path, address))
+            return false;
+        // left behind by a gateway that didn't shut down cleanly
+        std::error_code ec{};
+        std::filesystem::remove(path, ec);
+
+        const int fd{ socket(AF_UNIX, SOCK_STREAM, 0) };
+        if (fd == -1)
+            return false;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0 || !set_non_blocking(fd)) {
+            fmt::print("IpcListener -> unable to listen on {}, {}\n", path, std::strerror(errno));
+            close(fd);
+            return false;
+        }
+        m_fd = fd;
+        m_path = path;
+        return true;
+#endif
+    }
+    void IpcListener::Close() {
+        if (m_fd == -1)
+            return;
+#ifndef _WIN32
+        close(m_fd);
+        std::error_code ec{};
+        std::filesystem::remove(m_path, ec);
+#endif
+        m_fd = -1;
+    }
+    std::unique_ptr<IpcConnection> IpcListener::Accept() {
+#ifdef _WIN32
+        return nullptr;
+#else
+        if (m_fd == -1)
+            return nullptr;
+        const int fd{ accept(m_fd, nullptr, nullptr) };
+        if (fd == -1)
+            return nullptr;
+        if (!set_non_blocking(fd)) {
+            close(fd);
+            return nullptr;
+        }
+        return std::make_unique<IpcConnection>(fd);
+#endif
+    }
+}
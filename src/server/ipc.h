@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GTServer {
+    enum eIpcMessageType : uint16_t {
+        IPC_MESSAGE_HELLO = 1,      // worker -> gateway: worker id, port
+        IPC_MESSAGE_LOAD,           // worker -> gateway: players, worlds
+        IPC_MESSAGE_PRESENCE,       // worker -> gateway: user id, online
+        IPC_MESSAGE_KICK,           // gateway -> worker: user id logged in on another worker
+        IPC_MESSAGE_CLAIM_WORLD,    // worker -> gateway: world name
+        IPC_MESSAGE_WORLD_OWNER,    // gateway -> workers: world name, worker id or -1 once it is free again
+        IPC_MESSAGE_WORKER_STATE,   // gateway -> workers: worker id, port, alive
+        IPC_MESSAGE_TRANSFER,       // worker -> gateway -> worker: target worker id, user id, world name
+        IPC_MESSAGE_BROADCAST,      // worker -> gateway -> every other worker: console message
+        IPC_MESSAGE_STORE_PUT,      // worker -> gateway -> every worker: key, u32 size + value
+        IPC_MESSAGE_STORE_REMOVE    // worker -> gateway -> every worker: key
+    };
+    struct IpcMessage {
+        uint16_t m_type;
+        std::vector<uint8_t> m_data;
+    };
+
+    // length prefixed messages (u32 size, u16 type, payload) over a non-blocking unix stream socket,
+    // sends are buffered and written by Flush() so a slow peer never blocks the game thread
+    class IpcConnection {
+    public:
+        IpcConnection() = default;
+        explicit IpcConnection(const int& fd) : m_fd{ fd } {}
+        ~IpcConnection();
+        IpcConnection(const IpcConnection&) = delete;
+        IpcConnection& operator=(const IpcConnection&) = delete;
+
+        bool Connect(const std::string& path);
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return m_fd != -1; }
+
+        void Send(const uint16_t& type, const std::vector<uint8_t>& data);
+        bool Flush();
+        // waits for the peer to take everything that's buffered, used right before closing
+        bool Drain(const std::chrono::milliseconds& timeout);
+        // false once the peer has gone away or sent something unreadable
+        bool Receive(std::vector<IpcMessage>& messages);
+
+    private:
+        static constexpr std::size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(uint16_t);
+
+        int m_fd{ -1 };
+        std::vector<uint8_t> m_send_buffer{};
+        std::vector<uint8_t> m_receive_buffer{};
+    };
+
+    class IpcListener {
+    public:
+        IpcListener() = default;
+        ~IpcListener();
+        IpcListener(const IpcListener&) = delete;
+        IpcListener& operator=(const IpcListener&) = delete;
+
+        bool Listen(const std::string& path);
+        void Close();
+        // nullptr if nobody is waiting
+        std::unique_ptr<IpcConnection> Accept();
+
+    private:
+        int m_fd{ -1 };
+        std::string m_path{};
+    };
+}
@@ -0,0 +1,77 @@
+#include <server/item_data_stream.h>
+#include <algorithm>
+#include <config.h>
+#include <database/item/item_database.h>
+#include <player/player.h>
+#include <server/metrics.h>
+
+namespace GTServer {
+    bool ItemDataStream::Request(const std::shared_ptr<Player>& player) {
+        static Counter& throttled{ Metrics::Get().GetCounter("gtserver_item_data_requests_total", "Item data requests by result", "result=\"throttled\"") };
+        static Counter& queued{ Metrics::Get().GetCounter("gtserver_item_data_requests_total", "Item data requests by result", "result=\"queued\"") };
+        const steady_clock::time_point now{ steady_clock::now() };
+        const uint32_t connect_id{ player->GetConnectID() };
+
+        auto it{ m_requested.find(connect_id) };
+        if (m_pending.contains(connect_id) || (it != m_requested.end() && now - it->second < config::item_data::refresh_interval)) {
+            throttled.Increase();
+            return false;
+        }
+        m_requested.insert_or_assign(connect_id, now);
+        m_pending.insert(connect_id);
+        m_queue.push_back(Stream{ player, connect_id, now });
+        queued.Increase();
+        return true;
+    }
+
+    void ItemDataStream::Poll() {
+        static Counter& sent{ Metrics::Get().GetCounter("gtserver_item_data_streams_total", "Item data streams by result", "result=\"sent\"") };
+        static Counter& timed_out{ Metrics::Get().GetCounter("gtserver_item_data_streams_total", "Item data streams by result", "result=\"timed_out\"") };
+        const steady_clock::time_point now{ steady_clock::now() };
+
+        std::erase_if(m_active, [&](const Stream& stream) {
+            std::shared_ptr<Player> player{ stream.m_player.lock() };
+            bool done{ !player || !player->GetPeer() || player->GetPeer()->state != ENET_PEER_STATE_CONNECTED };
+            if (!done && player->GetOutboundBacklog().m_bytes <= config::item_data::drained_bytes) {
+                sent.Increase();
+                done = true;
+            }
+            else if (!done && now - stream.m_started_at >= config::item_data::stream_timeout) {
+                timed_out.Increase();
+                done = true;
+            }
+            if (done)
+                m_pending.erase(stream.m_connect_id);
+            return done;
+        });
+        std::erase_if(m_requested, [&](const auto& pair) {
+            return !m_pending.contains(pair.first) && now - pair.second >= config::item_data::refresh_interval;
+        });
+
+        GamePacket* packet{ ItemDatabase::GetPacket() };
+        if (!packet || !packet->IsValid())
+            return;
+        // a congested peer goes to the back of the line, its queues have to drain before it gets megabytes more
+        for (std::size_t pass = m_queue.size(); pass > 0 && !m_queue.empty() && m_active.size() < config::item_data::max_streams; --pass) {
+            Stream stream{ std::move(m_queue.front()) };
+            m_queue.pop_front();
+
+            std::shared_ptr<Player> player{ stream.m_player.lock() };
+            if (!player || !player->GetPeer() || player->GetPeer()->state != ENET_PEER_STATE_CONNECTED) {
+                m_pending.erase(stream.m_connect_id);
+                continue;
+            }
+            if (player->IsCongested()) {
+                m_queue.push_back(std::move(stream));
+                continue;
+            }
+            player->SendPacket(*packet);
+            stream.m_started_at = now;
+            m_active.push_back(std::move(stream));
+        }
+    }
+
+    bool ItemDataStream::IsStreaming(const uint32_t& connect_id) const {
+        return std::any_of(m_active.begin(), m_active.end(), [&](const Stream& stream) { return stream.m_connect_id == connect_id; });
+    }
+}
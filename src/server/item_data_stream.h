@@ -0,0 +1,46 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    class Player;
+    // serves the items.dat packet to a few peers at a time. A peer keeps its slot until it has drained the
+    // packet, so a slow link takes longer to get it without holding the uplink for everyone else.
+    // Only used from the service thread.
+    class ItemDataStream {
+    public:
+        ItemDataStream() = default;
+        ~ItemDataStream() = default;
+
+        static ItemDataStream& Get() {
+            static ItemDataStream instance{};
+            return instance;
+        }
+
+        // false if the connection already has one queued or streaming, or got one within the refresh interval
+        bool Request(const std::shared_ptr<Player>& player);
+        // frees the slots of peers that are done and starts the next ones in line
+        void Poll();
+
+        // the packet alone is bigger than the outbound budget, so a streaming peer is let off until it's done
+        [[nodiscard]] bool IsStreaming(const uint32_t& connect_id) const;
+
+    private:
+        struct Stream {
+            std::weak_ptr<Player> m_player;
+            uint32_t m_connect_id;
+            steady_clock::time_point m_started_at;
+        };
+
+        std::deque<Stream> m_queue{};
+        std::vector<Stream> m_active{};
+        // queued or active
+        std::unordered_set<uint32_t> m_pending{};
+        // connect id -> last accepted request, for the refresh interval
+        std::unordered_map<uint32_t, steady_clock::time_point> m_requested{};
+    };
+}
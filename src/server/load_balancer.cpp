@@ -0,0 +1,80 @@
+#include <server/load_balancer.h>
+#include <config.h>
+
+namespace GTServer {
+    void LoadBalancer::AddWorker(const int32_t& id, const uint16_t& port) {
+        m_workers.insert_or_assign(id, Worker{ id, port, 0, 0, 0, steady_clock::now() });
+    }
+    std::vector<std::string> LoadBalancer::RemoveWorker(const int32_t& id) {
+        m_workers.erase(id);
+
+        std::vector<std::string> ret{};
+        for (auto it = m_worlds.begin(); it != m_worlds.end();) {
+            if (it->second != id) {
+                ++it;
+                continue;
+            }
+            ret.push_back(it->first);
+            it = m_worlds.erase(it);
+        }
+        std::erase_if(m_presence, [&](const auto& presence) { return presence.second == id; });
+        return ret;
+    }
+    void LoadBalancer::OnReport(const int32_t& id, const uint32_t& players, const uint32_t& worlds) {
+        auto it{ m_workers.find(id) };
+        if (it == m_workers.end())
+            return;
+        it->second.m_players = players;
+        it->second.m_worlds = worlds;
+        it->second.m_pending = 0;
+        it->second.m_reported_at = steady_clock::now();
+    }
+
+    std::optional<LoadBalancer::Worker> LoadBalancer::PickWorker() {
+        Worker* ret{ nullptr };
+        for (auto& [id, worker] : m_workers) {
+            if (!ret || worker.m_players + worker.m_pending < ret->m_players + ret->m_pending)
+                ret = &worker;
+        }
+        if (!ret)
+            return std::nullopt;
+        ret->m_pending++;
+        return *ret;
+    }
+    const LoadBalancer::Worker* LoadBalancer::GetWorker(const int32_t& id) const {
+        auto it{ m_workers.find(id) };
+        return it == m_workers.end() ? nullptr : &it->second;
+    }
+    std::vector<int32_t> LoadBalancer::GetExpiredWorkers(const steady_clock::time_point& now) const {
+        std::vector<int32_t> ret{};
+        for (const auto& [id, worker] : m_workers) {
+            if (now - worker.m_reported_at > config::cluster::worker_timeout)
+                ret.push_back(id);
+        }
+        return ret;
+    }
+
+    int32_t LoadBalancer::GetWorldOwner(const std::string& world) const {
+        auto it{ m_worlds.find(world) };
+        return it == m_worlds.end() ? -1 : it->second;
+    }
+    int32_t LoadBalancer::ClaimWorld(const std::string& world, const int32_t& worker) {
+        if (!m_workers.contains(worker))
+            return this->GetWorldOwner(world);
+        return m_worlds.try_emplace(world, worker).first->second;
+    }
+
+    int32_t LoadBalancer::SetPresence(const uint32_t& user_id, const int32_t& worker) {
+        auto [it, inserted]{ m_presence.try_emplace(user_id, worker) };
+        if (inserted)
+            return -1;
+        const int32_t previous{ it->second };
+        it->second = worker;
+        return previous == worker ? -1 : previous;
+    }
+    void LoadBalancer::ClearPresence(const uint32_t& user_id, const int32_t& worker) {
+        auto it{ m_presence.find(user_id) };
+        if (it != m_presence.end() && it->second == worker)
+            m_presence.erase(it);
+    }
+}
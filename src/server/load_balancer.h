@@ -1,7 +1,54 @@
 #pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <utils/timing_clock.h>
 
 namespace GTServer {
+    // gateway side bookkeeping of the worker processes: their reported load, which worker owns which world
+    // and where every player is logged in. Players go to the least loaded worker, worlds to whoever claims them first.
     class LoadBalancer {
+    public:
+        struct Worker {
+            int32_t m_id;
+            uint16_t m_port;
+            uint32_t m_players{ 0 };
+            uint32_t m_worlds{ 0 };
+            // sent to the worker since its last report, counted so a burst of logins doesn't pile onto one worker
+            uint32_t m_pending{ 0 };
+            steady_clock::time_point m_reported_at{};
+        };
 
+    public:
+        LoadBalancer() = default;
+        ~LoadBalancer() = default;
+
+        void AddWorker(const int32_t& id, const uint16_t& port);
+        // worlds the worker owned, they are free to be claimed by someone else again
+        std::vector<std::string> RemoveWorker(const int32_t& id);
+        void OnReport(const int32_t& id, const uint32_t& players, const uint32_t& worlds);
+
+        std::optional<Worker> PickWorker();
+        [[nodiscard]] const Worker* GetWorker(const int32_t& id) const;
+        [[nodiscard]] const std::unordered_map<int32_t, Worker>& GetWorkers() const { return m_workers; }
+        // workers that haven't reported within the timeout
+        [[nodiscard]] std::vector<int32_t> GetExpiredWorkers(const steady_clock::time_point& now) const;
+
+        [[nodiscard]] int32_t GetWorldOwner(const std::string& world) const;
+        // returns the owner after the claim, which is not the claimer if another worker was first.
+        // workers never unload a world, so a claim only ends when its worker goes away
+        int32_t ClaimWorld(const std::string& world, const int32_t& worker);
+        [[nodiscard]] const std::unordered_map<std::string, int32_t>& GetWorlds() const { return m_worlds; }
+
+        // returns the worker the user was logged in on before, -1 if none
+        int32_t SetPresence(const uint32_t& user_id, const int32_t& worker);
+        void ClearPresence(const uint32_t& user_id, const int32_t& worker);
+
+    private:
+        std::unordered_map<int32_t, Worker> m_workers{};
+        std::unordered_map<std::string, int32_t> m_worlds{};
+        std::unordered_map<uint32_t, int32_t> m_presence{};
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,261 @@
+#include <server/login_pipeline.h>
+#include <fmt/chrono.h>
+#include <magic_enum.hpp>
+#include <config.h>
+#include <database/database.h>
+#include <database/item/item_database.h>
+#include <server/server_pool.h>
+
+namespace GTServer {
+    LoginPipeline::LoginPipeline(ServerPool* servers) : m_servers{ servers } {
+        for (std::size_t stage = 0; stage < NUM_LOGIN_STAGES; ++stage)
+            m_stage_latency[stage] = &Metrics::Get().GetHistogram("gtserver_login_stage_duration_seconds", "Time spent in each login stage",
+                fmt::format("stage=\"{}\"", magic_enum::enum_name(static_cast<eLoginStage>(stage))));
+        for (std::size_t result = 0; result < NUM_LOGIN_RESULTS; ++result)
+            m_results[result] = &Metrics::Get().GetCounter("gtserver_logins_total", "Finished login attempts by result",
+                fmt::format("result=\"{}\"", magic_enum::enum_name(static_cast<eLoginResult>(result))));
+    }
+    LoginPipeline::~LoginPipeline() {
+        this->Stop();
+    }
+
+    bool LoginPipeline::Start(const std::size_t& workers) {
+        if (m_running.load())
+            return true;
+        std::vector<std::unique_ptr<sqlpp::mysql::connection>> connections{};
+        for (std::size_t i = 0; i < workers; ++i) {
+            auto connection{ Database::CreateConnection() };
+            if (!connection)
+                break;
+            connections.push_back(std::move(connection));
+        }
+        if (connections.empty()) {
+            fmt::print("LoginPipeline -> unable to open any database connection\n");
+            return false;
+        }
+        m_workers = connections.size();
+        m_running.store(true);
+        for (auto& connection : connections) {
+            m_threads.push_back(std::thread{ [this, connection = std::move(connection)]() {
+                PlayerTable table{ connection.get() };
+                this->WorkerThread(table);
+            } });
+        }
+        fmt::print(" - LoginPipeline started with {} workers\n", m_workers);
+        return true;
+    }
+    void LoginPipeline::Stop() {
+        if (!m_running.exchange(false))
+            return;
+        m_condition.notify_all();
+        for (auto& thread : m_threads) {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_threads.clear();
+    }
+
+    bool LoginPipeline::Submit(std::shared_ptr<Player> player) {
+        std::size_t position{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (m_jobs.size() >= config::login::max_pending) {
+                position = 0;
+            }
+            else {
+                m_jobs.push_back(Job{ player, steady_clock::now() });
+                position = m_jobs.size();
+            }
+        }
+        if (position == 0) {
+            this->Reject(player, LOGIN_RESULT_REJECTED);
+            return false;
+        }
+        m_condition.notify_one();
+        if (position > m_workers)
+            player->SendLog("`oThe server is busy, you are `w#{}`` in the login queue. Please wait...", position);
+        return true;
+    }
+    std::size_t LoginPipeline::GetPendingCount() const {
+        std::scoped_lock lock{ m_mutex };
+        return m_jobs.size();
+    }
+
+    void LoginPipeline::WorkerThread(PlayerTable& table) {
+        while (m_running.load()) {
+            Job job{};
+            {
+                std::unique_lock lock{ m_mutex };
+                m_condition.wait(lock, [&] { return !m_running.load() || !m_jobs.empty(); });
+                if (!m_running.load())
+                    break;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            this->QueuePositions();
+            if (!job.m_player)
+                continue;
+
+            const auto result{ this->Process(table, job) };
+            // a checked login is only counted once its profile is loaded
+            if (result != LOGIN_RESULT_SUCCESS || job.m_stage == LOGIN_STAGE_PROFILE)
+                m_results[result]->Increase();
+            Outcome outcome{ job.m_player, job.m_stage, result, job.m_user_id };
+
+            std::scoped_lock lock{ m_outcome_mutex };
+            m_outcomes.push_back(std::move(outcome));
+        }
+    }
+
+    void LoginPipeline::Poll() {
+        std::deque<Outcome> outcomes{};
+        std::vector<std::pair<std::shared_ptr<Player>, std::size_t>> positions{};
+        {
+            std::scoped_lock lock{ m_outcome_mutex };
+            outcomes.swap(m_outcomes);
+            positions.swap(m_positions);
+        }
+        for (auto& [player, position] : positions) {
+            if (this->IsConnected(player))
+                player->SendLog("`oYou are `w#{}`` in the login queue.", position);
+        }
+        for (auto& outcome : outcomes)
+            this->Finish(outcome);
+    }
+
+    LoginPipeline::eLoginResult LoginPipeline::Process(PlayerTable& table, Job& job) {
+        auto& player{ job.m_player };
+        steady_clock::time_point stage_start{ job.m_queued_at };
+        // a stage can't be interrupted once it's running, but there's no point continuing a login the client gave up on
+        auto finish_stage = [&](const eLoginStage& stage) {
+            const auto now{ steady_clock::now() };
+            const auto elapsed{ now - stage_start };
+            m_stage_latency[stage]->Record(elapsed);
+            stage_start = now;
+            if (stage == LOGIN_STAGE_QUEUED)
+                return elapsed <= config::login::queue_timeout;
+            return elapsed <= config::login::stage_timeout;
+        };
+
+        if (job.m_stage == LOGIN_STAGE_PROFILE) {
+            stage_start = steady_clock::now();
+            if (!table.LoadProfile(player, job.m_user_id))
+                return LOGIN_RESULT_ERROR;
+            if (!finish_stage(LOGIN_STAGE_PROFILE))
+                return LOGIN_RESULT_TIMEOUT;
+            return LOGIN_RESULT_SUCCESS;
+        }
+
+        if (!finish_stage(LOGIN_STAGE_QUEUED))
+            return LOGIN_RESULT_TIMEOUT;
+        const auto& login_info{ player->GetLoginDetail() };
+        const auto& user_id{ table.Authenticate(login_info->m_tank_id_name, login_info->m_tank_id_pass) };
+        if (!user_id)
+            return LOGIN_RESULT_INVALID;
+        if (!finish_stage(LOGIN_STAGE_CREDENTIALS))
+            return LOGIN_RESULT_TIMEOUT;
+        job.m_user_id = user_id.value();
+        return LOGIN_RESULT_SUCCESS;
+    }
+
+    void LoginPipeline::Finish(Outcome& outcome) {
+        auto& player{ outcome.m_player };
+        // the client left while a worker had it, the disconnect event already ran and its peer may belong to someone else now
+        if (!this->IsConnected(player)) {
+            m_servers->UnregisterSession(player);
+            return;
+        }
+        if (outcome.m_result != LOGIN_RESULT_SUCCESS) {
+            if (outcome.m_stage == LOGIN_STAGE_PROFILE)
+                m_servers->UnregisterSession(player);
+            this->Reject(player, outcome.m_result);
+            return;
+        }
+        if (outcome.m_stage == LOGIN_STAGE_CREDENTIALS) {
+            this->StartSession(outcome);
+            return;
+        }
+
+        const steady_clock::time_point started_at{ steady_clock::now() };
+        // the profile was read on a worker, the timer is only touched from here
+        player->SchedulePlaymods();
+        player->SetFlag(PLAYERFLAG_LOGGED_ON);
+        player->v_sender.OnSuperMainStart(
+            ItemDatabase::Get().GetHash(),
+            config::server::cache_server,
+            config::server::cache_path,
+            "cc.cz.madkite.freedom org.aqua.gg idv.aqua.bulldog com.cih.gamecih2 com.cih.gamecih com.cih.game_cih cn.maocai.gamekiller com.gmd.speedtime org.dax.attack com.x0.strai.frep com.x0.strai.free org.cheatengine.cegui org.sbtools.gamehack com.skgames.traffikrider org.sbtoods.gamehaca com.skype.ralder org.cheatengine.cegui.xx.multi1458919170111 com.prohiro.macro me.autotouch.autotouch com.cygery.repetitouch.free com.cygery.repetitouch.pro com.proziro.zacro com.slash.gamebuster",
+            "proto=175|choosemusic=audio/mp3/about_theme.mp3|active_holiday=0|wing_week_day=0|ubi_week_day=0|server_tick=263203319|clash_active=0|drop_lavacheck_faster=1|isPayingUser=0|usingStoreNavigation=1|enableInventoryTab=1|bigBackpack=1|",
+            PlayerTribute::get().get_hash()
+        );
+        m_stage_latency[LOGIN_STAGE_WORLD_MENU]->Record(steady_clock::now() - started_at);
+        fmt::print("[LoginPipeline]: A player {} has logged on, userId: {} - {}\n", player->GetRawName(), player->GetUserId(), system_clock::now());
+    }
+    void LoginPipeline::StartSession(Outcome& outcome) {
+        auto& player{ outcome.m_player };
+        const steady_clock::time_point started_at{ steady_clock::now() };
+        player->SetUserId(outcome.m_user_id);
+        if (auto previous = m_servers->RegisterSession(player); previous) {
+            player->v_sender.OnConsoleMessage("`4OOPS, `oSomeone else was logged into this account! He was kicked out now.``");
+            if (this->IsConnected(previous)) {
+                previous->v_sender.OnConsoleMessage("`4OOPS, `oSomeone else logged into this account!``");
+                previous->Disconnect(0U);
+            }
+            // saved while nothing else can touch it, so the profile loaded next isn't older than what it had
+            if (previous->IsFlagOn(PLAYERFLAG_LOGGED_ON)) {
+                PlayerTable* db{ (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE) };
+                if (!db->Save(previous))
+                    fmt::print("PlayerTable::save, Failed to save {} - {}\n", previous->GetRawName(), system_clock::now());
+            }
+        }
+        m_stage_latency[LOGIN_STAGE_SESSION]->Record(steady_clock::now() - started_at);
+        {
+            // it already waited its turn once, the profile goes ahead of logins that haven't been checked yet
+            std::scoped_lock lock{ m_mutex };
+            m_jobs.push_front(Job{ player, steady_clock::now(), LOGIN_STAGE_PROFILE, outcome.m_user_id });
+        }
+        m_condition.notify_one();
+    }
+    bool LoginPipeline::IsConnected(const std::shared_ptr<Player>& player) const {
+        for (auto& server : m_servers->GetServers()) {
+            if (server->GetPlayerPool()->GetPlayer(player->GetConnectID()) == player)
+                return true;
+        }
+        return false;
+    }
+
+    void LoginPipeline::QueuePositions() {
+        std::vector<std::pair<std::shared_ptr<Player>, std::size_t>> waiting{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (m_jobs.size() <= m_workers || m_position_update.GetPassedTime() < config::login::position_update_interval)
+                return;
+            m_position_update.UpdateTime();
+            waiting.reserve(m_jobs.size() - m_workers);
+            for (std::size_t index = m_workers; index < m_jobs.size(); ++index)
+                waiting.emplace_back(m_jobs[index].m_player, index + 1);
+        }
+        std::scoped_lock lock{ m_outcome_mutex };
+        m_positions = std::move(waiting);
+    }
+
+    void LoginPipeline::Reject(std::shared_ptr<Player> player, const eLoginResult& result) {
+        switch (result) {
+        case LOGIN_RESULT_INVALID: {
+            player->SendLog("`4Unable to log on: `oThat `wGrowID `odoesn't seem valid, or the password is wrong. If you don't have one, press `wCancel`o, un-check `w'I have a GrowID'`o, then click `wConnect`o.``");
+            player->SendSetURL(config::server::discord, "`eBetterGrowtopia Discord``");
+        } break;
+        case LOGIN_RESULT_REJECTED: {
+            m_results[LOGIN_RESULT_REJECTED]->Increase();
+            player->SendLog("`4Unable to log on: `oThe server is too busy right now, please try again in a moment.``");
+        } break;
+        case LOGIN_RESULT_TIMEOUT:
+        case LOGIN_RESULT_ERROR: {
+            player->SendLog("`4Unable to log on: `oSomething went wrong while loading your account, please try again.``");
+        } break;
+        default:
+            break;
+        }
+        player->Disconnect(0U);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <server/metrics.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    class Player;
+    class PlayerTable;
+    class ServerPool;
+
+    // logins are split into stages (credentials -> session -> profile -> world menu) and handled by a
+    // bounded pool of workers, each with its own database connection. the tank_id_name event is the parse stage.
+    // the workers only touch the database, what they find out is sent to the clients from the service loop.
+    // the session stage runs on the service loop too, it kicks and saves a live player.
+    class LoginPipeline {
+    public:
+        enum eLoginStage {
+            LOGIN_STAGE_QUEUED,
+            LOGIN_STAGE_CREDENTIALS,
+            LOGIN_STAGE_SESSION,
+            LOGIN_STAGE_PROFILE,
+            LOGIN_STAGE_WORLD_MENU,
+            NUM_LOGIN_STAGES
+        };
+        enum eLoginResult {
+            LOGIN_RESULT_SUCCESS,
+            LOGIN_RESULT_INVALID,
+            LOGIN_RESULT_TIMEOUT,
+            LOGIN_RESULT_REJECTED,
+            LOGIN_RESULT_ERROR,
+            NUM_LOGIN_RESULTS
+        };
+
+    public:
+        explicit LoginPipeline(ServerPool* servers);
+        ~LoginPipeline();
+
+        bool Start(const std::size_t& workers);
+        void Stop();
+
+        // returns false if the queue is full, the player is told to retry and disconnected
+        bool Submit(std::shared_ptr<Player> player);
+        [[nodiscard]] std::size_t GetPendingCount() const;
+        // service thread, sends the finished logins and queue positions the workers left behind
+        void Poll();
+
+    private:
+        struct Job {
+            std::shared_ptr<Player> m_player;
+            steady_clock::time_point m_queued_at;
+            // LOGIN_STAGE_CREDENTIALS or LOGIN_STAGE_PROFILE
+            eLoginStage m_stage{ LOGIN_STAGE_CREDENTIALS };
+            uint32_t m_user_id{ 0 };
+        };
+        struct Outcome {
+            std::shared_ptr<Player> m_player;
+            eLoginStage m_stage;
+            eLoginResult m_result;
+            uint32_t m_user_id{ 0 };
+        };
+
+        void WorkerThread(PlayerTable& table);
+        eLoginResult Process(PlayerTable& table, Job& job);
+        void QueuePositions();
+        void Finish(Outcome& outcome);
+        void StartSession(Outcome& outcome);
+        void Reject(std::shared_ptr<Player> player, const eLoginResult& result);
+        // ENet hands a freed peer to the next client, so a player that left mustn't be sent anything through it
+        [[nodiscard]] bool IsConnected(const std::shared_ptr<Player>& player) const;
+
+    private:
+        ServerPool* m_servers;
+
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        std::deque<Job> m_jobs{};
+        std::size_t m_workers{ 0 };
+        TimingClock m_position_update{};
+
+        std::mutex m_outcome_mutex{};
+        std::deque<Outcome> m_outcomes{};
+        std::vector<std::pair<std::shared_ptr<Player>, std::size_t>> m_positions{};
+
+        std::atomic<bool> m_running{ false };
+        std::vector<std::thread> m_threads{};
+
+        std::array<LatencyHistogram*, NUM_LOGIN_STAGES> m_stage_latency{};
+        std::array<Counter*, NUM_LOGIN_RESULTS> m_results{};
+    };
+}
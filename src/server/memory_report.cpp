@@ -0,0 +1,88 @@
+#include <server/memory_report.h>
+#include <algorithm>
+#include <fmt/core.h>
+#include <database/item/item_database.h>
+#include <render/world_render.h>
+#include <server/metrics.h>
+#include <server/server_pool.h>
+#include <utils/memory_usage.h>
+
+namespace GTServer {
+    World::MemoryBreakdown MemoryReport::GetWorldsTotal() const {
+        World::MemoryBreakdown ret{};
+        for (const auto& world : m_worlds) {
+            ret.m_tiles += world.m_memory.m_tiles;
+            ret.m_extras += world.m_memory.m_extras;
+            ret.m_objects += world.m_memory.m_objects;
+            ret.m_players += world.m_memory.m_players;
+            ret.m_cached_packets += world.m_memory.m_cached_packets;
+        }
+        return ret;
+    }
+    Player::MemoryBreakdown MemoryReport::GetPlayersTotal() const {
+        Player::MemoryBreakdown ret{};
+        for (const auto& player : m_players) {
+            ret.m_base += player.m_memory.m_base;
+            ret.m_inventory += player.m_memory.m_inventory;
+            ret.m_playmods += player.m_memory.m_playmods;
+            ret.m_packet_queue += player.m_memory.m_packet_queue;
+        }
+        return ret;
+    }
+    std::size_t MemoryReport::GetAccountedTotal() const {
+        return this->GetWorldsTotal().GetTotal() + this->GetPlayersTotal().GetTotal() + m_item_database + m_render_cache + m_render_atlas;
+    }
+
+    std::shared_ptr<const MemoryReport> MemoryAccounting::Collect(ServerPool* servers) {
+        auto report{ std::make_shared<MemoryReport>() };
+        for (auto& server : servers->GetServers()) {
+            for (auto& [name, world] : server->GetWorldPool()->GetWorlds()) {
+                if (world)
+                    report->m_worlds.push_back(MemoryReport::WorldEntry{ name, world->GetMemoryBreakdown() });
+            }
+            for (auto& [connect_id, player] : server->GetPlayerPool()->GetPlayers()) {
+                if (player)
+                    report->m_players.push_back(MemoryReport::PlayerEntry{ player->GetRawName(), player->GetMemoryBreakdown() });
+            }
+        }
+        std::sort(report->m_worlds.begin(), report->m_worlds.end(), [](const auto& a, const auto& b) {
+            return a.m_memory.GetTotal() > b.m_memory.GetTotal();
+        });
+        std::sort(report->m_players.begin(), report->m_players.end(), [](const auto& a, const auto& b) {
+            return a.m_memory.GetTotal() > b.m_memory.GetTotal();
+        });
+        report->m_item_database = ItemDatabase::GetResidentMemoryUsage();
+        report->m_render_cache = WorldRender::get_cache_memory_usage();
+        report->m_render_atlas = WorldRender::get_atlas_memory_usage();
+        report->m_process_rss = MemoryUsage::get_process_rss();
+        report->m_collected_at = steady_clock::now();
+
+        std::shared_ptr<const MemoryReport> ret{ std::move(report) };
+        m_last_report.store(ret);
+        return ret;
+    }
+
+    void MemoryAccounting::RegisterMetrics() {
+        auto add_component = [this](const std::string& component, std::function<std::size_t(const MemoryReport&)> fn) {
+            Metrics::Get().AddGauge("gtserver_memory_bytes", "Accounted memory per component, as of the last memory report", [this, fn] {
+                return static_cast<double>(fn(*this->GetLastReport()));
+            }, fmt::format("component=\"{}\"", component));
+        };
+        add_component("world_tiles", [](const MemoryReport& report) { return report.GetWorldsTotal().m_tiles; });
+        add_component("world_extras", [](const MemoryReport& report) { return report.GetWorldsTotal().m_extras; });
+        add_component("world_objects", [](const MemoryReport& report) { return report.GetWorldsTotal().m_objects; });
+        add_component("world_players", [](const MemoryReport& report) { return report.GetWorldsTotal().m_players; });
+        add_component("world_cached_packets", [](const MemoryReport& report) { return report.GetWorldsTotal().m_cached_packets; });
+        add_component("player_base", [](const MemoryReport& report) { return report.GetPlayersTotal().m_base; });
+        add_component("player_inventory", [](const MemoryReport& report) { return report.GetPlayersTotal().m_inventory; });
+        add_component("player_playmods", [](const MemoryReport& report) { return report.GetPlayersTotal().m_playmods; });
+        add_component("player_packet_queue", [](const MemoryReport& report) { return report.GetPlayersTotal().m_packet_queue; });
+        add_component("item_database", [](const MemoryReport& report) { return report.m_item_database; });
+        add_component("render_cache", [](const MemoryReport& report) { return report.m_render_cache; });
+        add_component("render_atlas", [](const MemoryReport& report) { return report.m_render_atlas; });
+
+        Metrics::Get().AddGauge("gtserver_process_resident_bytes", "Resident set size of the server process", [] {
+            return static_cast<double>(MemoryUsage::get_process_rss());
+        });
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <player/player.h>
+#include <world/world.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    class ServerPool;
+    struct MemoryReport {
+        struct WorldEntry {
+            std::string m_name;
+            World::MemoryBreakdown m_memory;
+        };
+        struct PlayerEntry {
+            std::string m_name;
+            Player::MemoryBreakdown m_memory;
+        };
+
+        std::vector<WorldEntry> m_worlds{};
+        std::vector<PlayerEntry> m_players{};
+        std::size_t m_item_database{ 0 };
+        std::size_t m_render_cache{ 0 };
+        std::size_t m_render_atlas{ 0 };
+        std::size_t m_process_rss{ 0 };
+        steady_clock::time_point m_collected_at{ steady_clock::now() };
+
+        [[nodiscard]] World::MemoryBreakdown GetWorldsTotal() const;
+        [[nodiscard]] Player::MemoryBreakdown GetPlayersTotal() const;
+        [[nodiscard]] std::size_t GetAccountedTotal() const;
+    };
+
+    class MemoryAccounting {
+    public:
+        MemoryAccounting() = default;
+        ~MemoryAccounting() = default;
+
+        // walks every world and peer queue, call it from the service thread
+        std::shared_ptr<const MemoryReport> Collect(ServerPool* servers);
+        [[nodiscard]] std::shared_ptr<const MemoryReport> GetLastReport() const { return m_last_report.load(); }
+
+        void RegisterMetrics();
+
+    public:
+        static MemoryAccounting& Get() { static MemoryAccounting ret; return ret; }
+
+    private:
+        std::atomic<std::shared_ptr<const MemoryReport>> m_last_report{ std::make_shared<const MemoryReport>() };
+    };
+}
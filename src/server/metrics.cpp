@@ -0,0 +1,80 @@
+#include <server/metrics.h>
+#include <fmt/core.h>
+
+namespace GTServer {
+    // prometheus bucket boundaries in microseconds, the finer HDR buckets are folded into these on collect
+    constexpr uint64_t HISTOGRAM_BOUNDARIES[] = {
+        50, 100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000,
+        100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000
+    };
+
+    Counter& Metrics::GetCounter(const std::string& name, const std::string& help, const std::string& labels) {
+        std::scoped_lock lock{ m_mutex };
+        auto& series = this->GetFamily(name, help, METRIC_TYPE_COUNTER).m_counters[labels];
+        if (!series)
+            series = std::make_unique<Counter>();
+        return *series;
+    }
+    LatencyHistogram& Metrics::GetHistogram(const std::string& name, const std::string& help, const std::string& labels) {
+        std::scoped_lock lock{ m_mutex };
+        auto& series = this->GetFamily(name, help, METRIC_TYPE_HISTOGRAM).m_histograms[labels];
+        if (!series)
+            series = std::make_unique<LatencyHistogram>();
+        return *series;
+    }
+    void Metrics::AddGauge(const std::string& name, const std::string& help, std::function<double()> fn, const std::string& labels) {
+        std::scoped_lock lock{ m_mutex };
+        this->GetFamily(name, help, METRIC_TYPE_GAUGE).m_gauges.insert_or_assign(labels, std::move(fn));
+    }
+
+    Metrics::Family& Metrics::GetFamily(const std::string& name, const std::string& help, const eMetricType& type) {
+        auto it = m_families.find(name);
+        if (it == m_families.end())
+            it = m_families.emplace(name, Family{ .m_type = type, .m_help = help }).first;
+        return it->second;
+    }
+
+    std::string Metrics::Collect() {
+        auto with_labels = [](const std::string& labels, const std::string& extra = "") -> std::string {
+            if (labels.empty() && extra.empty())
+                return "";
+            if (labels.empty() || extra.empty())
+                return fmt::format("{{{}}}", labels.empty() ? extra : labels);
+            return fmt::format("{{{},{}}}", labels, extra);
+        };
+
+        std::string ret{};
+        std::scoped_lock lock{ m_mutex };
+        for (const auto& [name, family] : m_families) {
+            switch (family.m_type) {
+            case METRIC_TYPE_COUNTER: {
+                ret.append(fmt::format("# HELP {} {}\n# TYPE {} counter\n", name, family.m_help, name));
+                for (const auto& [labels, counter] : family.m_counters)
+                    ret.append(fmt::format("{}{} {}\n", name, with_labels(labels), counter->Get()));
+            } break;
+            case METRIC_TYPE_GAUGE: {
+                ret.append(fmt::format("# HELP {} {}\n# TYPE {} gauge\n", name, family.m_help, name));
+                for (const auto& [labels, gauge] : family.m_gauges)
+                    ret.append(fmt::format("{}{} {}\n", name, with_labels(labels), gauge()));
+            } break;
+            case METRIC_TYPE_HISTOGRAM: {
+                ret.append(fmt::format("# HELP {} {}\n# TYPE {} histogram\n", name, family.m_help, name));
+                for (const auto& [labels, histogram] : family.m_histograms) {
+                    uint64_t cumulative = 0;
+                    std::size_t bucket = 0;
+                    for (const auto& boundary : HISTOGRAM_BOUNDARIES) {
+                        for (; bucket < LatencyHistogram::NUM_BUCKETS && LatencyHistogram::GetUpperBound(bucket) <= boundary; ++bucket)
+                            cumulative += histogram->GetBucketCount(bucket);
+                        ret.append(fmt::format("{}_bucket{} {}\n", name, with_labels(labels, fmt::format("le=\"{}\"", static_cast<double>(boundary) / 1'000'000.0)), cumulative));
+                    }
+                    const uint64_t count = histogram->GetCount();
+                    ret.append(fmt::format("{}_bucket{} {}\n", name, with_labels(labels, "le=\"+Inf\""), count));
+                    ret.append(fmt::format("{}_sum{} {}\n", name, with_labels(labels), static_cast<double>(histogram->GetSum()) / 1'000'000.0));
+                    ret.append(fmt::format("{}_count{} {}\n", name, with_labels(labels), count));
+                }
+            } break;
+            }
+        }
+        return ret;
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GTServer {
+    class Counter {
+    public:
+        void Increase(const uint64_t& value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> m_value{ 0 };
+    };
+
+    // log-linear buckets in microseconds: 8 linear sub-buckets per power of two, ~12% relative error up to ~268s
+    class LatencyHistogram {
+    public:
+        static constexpr std::size_t SUB_BUCKET_BITS = 3;
+        static constexpr std::size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr std::size_t MAX_SHIFT = 24;
+        static constexpr std::size_t NUM_BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    public:
+        void Record(const std::chrono::nanoseconds& duration) {
+            const uint64_t value = static_cast<uint64_t>(std::max<int64_t>(duration.count() / 1000, 0));
+            m_buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+        }
+
+        [[nodiscard]] uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t GetSum() const { return m_sum.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t GetMax() const { return m_max.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t GetBucketCount(const std::size_t& bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t GetQuantile(const double& quantile) const {
+            const uint64_t count = this->GetCount();
+            if (count == 0)
+                return 0;
+            const uint64_t target = static_cast<uint64_t>(quantile * static_cast<double>(count));
+            uint64_t seen = 0;
+            for (std::size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                seen += this->GetBucketCount(bucket);
+                if (seen > target)
+                    return std::min(GetUpperBound(bucket), this->GetMax());
+            }
+            return this->GetMax();
+        }
+
+        static std::size_t GetBucket(const uint64_t& value) {
+            if (value < SUB_BUCKETS)
+                return static_cast<std::size_t>(value);
+            const std::size_t shift = static_cast<std::size_t>(std::bit_width(value)) - SUB_BUCKET_BITS - 1;
+            if (shift > MAX_SHIFT)
+                return NUM_BUCKETS - 1;
+            return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+        }
+        static uint64_t GetUpperBound(const std::size_t& bucket) {
+            if (bucket < SUB_BUCKETS)
+                return bucket;
+            const std::size_t shift = bucket / SUB_BUCKETS - 1;
+            return ((bucket % SUB_BUCKETS + SUB_BUCKETS + 1) << shift) - 1;
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+        std::atomic<uint64_t> m_count{ 0 };
+        std::atomic<uint64_t> m_sum{ 0 };
+        std::atomic<uint64_t> m_max{ 0 };
+    };
+
+    class ScopedLatency {
+    public:
+        explicit ScopedLatency(LatencyHistogram& histogram) : m_histogram{ histogram }, m_start{ std::chrono::steady_clock::now() } {}
+        ~ScopedLatency() { m_histogram.Record(std::chrono::steady_clock::now() - m_start); }
+
+    private:
+        LatencyHistogram& m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    class Metrics {
+    public:
+        enum eMetricType {
+            METRIC_TYPE_COUNTER,
+            METRIC_TYPE_GAUGE,
+            METRIC_TYPE_HISTOGRAM
+        };
+
+    public:
+        Metrics() = default;
+        ~Metrics() = default;
+
+        // returned references stay valid for the lifetime of the process, hot paths should keep them around
+        Counter& GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+        LatencyHistogram& GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+        void AddGauge(const std::string& name, const std::string& help, std::function<double()> fn, const std::string& labels = "");
+
+        std::string Collect();
+
+    public:
+        static Metrics& Get() { static Metrics ret; return ret; }
+
+    private:
+        struct Family {
+            eMetricType m_type;
+            std::string m_help;
+            std::map<std::string, std::unique_ptr<Counter>> m_counters{};
+            std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms{};
+            std::map<std::string, std::function<double()>> m_gauges{};
+        };
+        Family& GetFamily(const std::string& name, const std::string& help, const eMetricType& type);
+
+    private:
+        std::mutex m_mutex{};
+        std::map<std::string, Family> m_families{};
+    };
+}
@@ -4,6 +4,7 @@
 namespace GTServer {
     class Player;
     class World;
+    class WorldSnapshot;
     enum eQueueType {
         QUEUE_TYPE_NONE,
         QUEUE_TYPE_FINDING_ITEMS,
@@ -11,7 +12,6 @@ namespace GTServer {
         QUEUE_TYPE_FINDING_PLAYERS,
         QUEUE_TYPE_RENDER_WORLD,
         QUEUE_TYPE_ACCOUNT_VERIFICATION,
-        SERVERQUEUE_TYPE_LOGIN,
         NUM_QUEUE_TYPES
     };
     
@@ -21,5 +21,6 @@ namespace GTServer {
         std::string m_keyword{};
         std::shared_ptr<Player> m_player = nullptr;
         std::shared_ptr<World> m_world = nullptr;
+        std::shared_ptr<const WorldSnapshot> m_snapshot = nullptr;
     };
 }
\ No newline at end of file
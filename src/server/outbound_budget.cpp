@@ -0,0 +1,33 @@
+#include <server/outbound_budget.h>
+#include <config.h>
+
+namespace GTServer {
+    eOutboundState OutboundBudget::Update(const OutboundBacklog& backlog, const steady_clock::time_point& now) {
+        static Counter& congested{ Metrics::Get().GetCounter("gtserver_outbound_congested_total", "Peers that went over their soft outbound budget") };
+        m_backlog = backlog;
+
+        if (IsOver(backlog, config::outbound::hard_bytes, config::outbound::hard_packets)) {
+            if (m_over_since == steady_clock::time_point{})
+                m_over_since = now;
+            if (now - m_over_since >= config::outbound::grace_period) {
+                m_state = OUTBOUND_STATE_OVER_BUDGET;
+                return m_state;
+            }
+        }
+        else
+            m_over_since = steady_clock::time_point{};
+
+        // leaving the congested state needs the backlog to be well below the budget, so it doesn't flap every check
+        if (m_state == OUTBOUND_STATE_OK) {
+            if (IsOver(backlog, config::outbound::soft_bytes, config::outbound::soft_packets)) {
+                congested.Increase();
+                m_state = OUTBOUND_STATE_CONGESTED;
+            }
+        }
+        else if (!IsOver(backlog, config::outbound::soft_bytes / 2, config::outbound::soft_packets / 2))
+            m_state = OUTBOUND_STATE_OK;
+        else
+            m_state = OUTBOUND_STATE_CONGESTED;
+        return m_state;
+    }
+}
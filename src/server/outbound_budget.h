@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <server/metrics.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    enum eOutboundState : uint8_t {
+        OUTBOUND_STATE_OK,
+        OUTBOUND_STATE_CONGESTED,
+        OUTBOUND_STATE_OVER_BUDGET
+    };
+    // what is waiting in a peer's enet queues, queued and sent but not yet acknowledged
+    struct OutboundBacklog {
+        std::size_t m_bytes{ 0 };
+        std::size_t m_packets{ 0 };
+    };
+
+    // per peer limits on its outgoing backlog. Over the soft budget the peer is congested and only gets what it
+    // can't do without, staying over the hard budget for the grace period gets it disconnected.
+    class OutboundBudget {
+    public:
+        OutboundBudget() = default;
+        ~OutboundBudget() = default;
+
+        eOutboundState Update(const OutboundBacklog& backlog, const steady_clock::time_point& now);
+
+        [[nodiscard]] eOutboundState GetState() const { return m_state; }
+        [[nodiscard]] const OutboundBacklog& GetBacklog() const { return m_backlog; }
+
+    private:
+        static bool IsOver(const OutboundBacklog& backlog, const std::size_t& bytes, const std::size_t& packets) {
+            return backlog.m_bytes > bytes || backlog.m_packets > packets;
+        }
+
+    private:
+        eOutboundState m_state{ OUTBOUND_STATE_OK };
+        OutboundBacklog m_backlog{};
+        steady_clock::time_point m_over_since{};
+    };
+}
@@ -0,0 +1,129 @@
+#include <server/rate_limiter.h>
+#include <algorithm>
+#include <string>
+#include <fmt/core.h>
+#include <magic_enum.hpp>
+#include <config.h>
+#include <proton/packet.h>
+
+namespace GTServer {
+    struct RateClassLimit {
+        double m_rate;
+        double m_burst;
+        // out of tokens: hold the message back instead of dropping it
+        bool m_delay;
+        // out of tokens: counts towards a kick, movement never does
+        bool m_strike;
+    };
+    static constexpr std::array<RateClassLimit, NUM_RATE_CLASSES> g_limits{ {
+        { config::rate_limit::movement_rate, config::rate_limit::movement_burst, false, false },
+        { config::rate_limit::game_rate, config::rate_limit::game_burst, false, true },
+        { config::rate_limit::chat_rate, config::rate_limit::chat_burst, true, true },
+        { config::rate_limit::dialog_rate, config::rate_limit::dialog_burst, true, true },
+        { config::rate_limit::action_rate, config::rate_limit::action_burst, true, true },
+        { config::rate_limit::drop_rate, config::rate_limit::drop_burst, false, true },
+        { config::rate_limit::join_rate, config::rate_limit::join_burst, true, true },
+        { config::rate_limit::search_rate, config::rate_limit::search_burst, false, false },
+        { config::rate_limit::render_rate, config::rate_limit::render_burst, false, false }
+    } };
+
+    bool TokenBucket::Take(const double& rate, const double& burst, const steady_clock::time_point& now) {
+        const double elapsed{ std::chrono::duration<double>(now - m_updated_at).count() };
+        m_tokens = std::min(burst, m_tokens + elapsed * rate);
+        m_updated_at = now;
+        if (m_tokens < 1.0)
+            return false;
+        m_tokens -= 1.0;
+        return true;
+    }
+    steady_clock::duration TokenBucket::GetWaitTime(const double& rate) const {
+        if (m_tokens >= 1.0 || rate <= 0.0)
+            return steady_clock::duration::zero();
+        return std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>((1.0 - m_tokens) / rate));
+    }
+    bool TokenBucket::IsFull(const double& rate, const double& burst, const steady_clock::time_point& now) const {
+        return m_tokens + std::chrono::duration<double>(now - m_updated_at).count() * rate >= burst;
+    }
+
+    RateLimiter::RateLimiter() {
+        for (std::size_t rate_class = 0; rate_class < NUM_RATE_CLASSES; ++rate_class)
+            m_buckets[rate_class] = TokenBucket{ g_limits[rate_class].m_burst };
+    }
+
+    eRateAction RateLimiter::Check(const eRateClass& rate_class, steady_clock::duration& wait) {
+        const eRateAction action{ this->Decide(rate_class, wait) };
+        GetCounter(rate_class, action).Increase();
+        return action;
+    }
+    eRateAction RateLimiter::Decide(const eRateClass& rate_class, steady_clock::duration& wait) {
+        const RateClassLimit& limit{ g_limits[rate_class] };
+        TokenBucket& bucket{ m_buckets[rate_class] };
+        const auto now{ steady_clock::now() };
+        if (bucket.Take(limit.m_rate, limit.m_burst, now))
+            return RATE_ACTION_ALLOW;
+
+        if (limit.m_strike) {
+            if (m_strikes == 0 || now - m_first_strike > config::rate_limit::strike_window) {
+                m_strikes = 0;
+                m_first_strike = now;
+            }
+            if (++m_strikes >= config::rate_limit::kick_strikes)
+                return RATE_ACTION_KICK;
+        }
+        wait = bucket.GetWaitTime(limit.m_rate);
+        if (limit.m_delay && m_delayed < config::rate_limit::max_delayed && wait <= config::rate_limit::max_delay) {
+            // the token the delayed message will use is taken now, so later messages queue up behind it
+            bucket.Take(limit.m_rate, limit.m_burst, now + wait);
+            ++m_delayed;
+            return RATE_ACTION_DELAY;
+        }
+        return RATE_ACTION_DROP;
+    }
+
+    eRateClass RateLimiter::GetTextClass(const std::string& text) {
+        if (!text.starts_with("action|"))
+            return RATE_CLASS_ACTION;
+        const std::string action{ text.substr(7, text.find_first_of("\n|", 7) - 7) };
+        if (action == "input")
+            return RATE_CLASS_CHAT;
+        if (action == "dialog_return")
+            return RATE_CLASS_DIALOG;
+        if (action == "drop" || action == "trash")
+            return RATE_CLASS_DROP;
+        if (action == "join_request")
+            return RATE_CLASS_JOIN;
+        return RATE_CLASS_ACTION;
+    }
+    eRateClass RateLimiter::GetGameClass(const uint8_t& packet_type) {
+        switch (packet_type) {
+        case NET_GAME_PACKET_STATE:
+        case NET_GAME_PACKET_ITEM_ACTIVATE_OBJECT_REQUEST:
+            return RATE_CLASS_MOVEMENT;
+        default:
+            return RATE_CLASS_GAME;
+        }
+    }
+    Counter& RateLimiter::GetCounter(const eRateClass& rate_class, const eRateAction& action) {
+        static std::array<std::array<Counter*, NUM_RATE_ACTIONS>, NUM_RATE_CLASSES> counters{ [] {
+            std::array<std::array<Counter*, NUM_RATE_ACTIONS>, NUM_RATE_CLASSES> ret{};
+            for (std::size_t rate_class = 0; rate_class < NUM_RATE_CLASSES; ++rate_class) {
+                for (std::size_t action = 0; action < NUM_RATE_ACTIONS; ++action)
+                    ret[rate_class][action] = &Metrics::Get().GetCounter("gtserver_rate_limit_total", "Rate limit decisions by message class and action",
+                        fmt::format("class=\"{}\",action=\"{}\"", magic_enum::enum_name(static_cast<eRateClass>(rate_class)), magic_enum::enum_name(static_cast<eRateAction>(action))));
+            }
+            return ret;
+        }() };
+        return *counters[rate_class][action];
+    }
+
+    bool ConnectionLimiter::Allow(const uint32_t& host) {
+        auto [it, inserted] = m_buckets.try_emplace(host, TokenBucket{ config::rate_limit::connect_burst });
+        return it->second.Take(config::rate_limit::connect_rate, config::rate_limit::connect_burst, steady_clock::now());
+    }
+    void ConnectionLimiter::Cleanup() {
+        const auto now{ steady_clock::now() };
+        std::erase_if(m_buckets, [&](const auto& bucket) {
+            return bucket.second.IsFull(config::rate_limit::connect_rate, config::rate_limit::connect_burst, now);
+        });
+    }
+}
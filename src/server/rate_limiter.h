@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <server/metrics.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    enum eRateClass : uint8_t {
+        RATE_CLASS_MOVEMENT,
+        RATE_CLASS_GAME,
+        RATE_CLASS_CHAT,
+        RATE_CLASS_DIALOG,
+        RATE_CLASS_ACTION,
+        RATE_CLASS_DROP,
+        RATE_CLASS_JOIN,
+        RATE_CLASS_SEARCH,
+        RATE_CLASS_RENDER,
+        NUM_RATE_CLASSES
+    };
+    enum eRateAction : uint8_t {
+        RATE_ACTION_ALLOW,
+        RATE_ACTION_DELAY,
+        RATE_ACTION_DROP,
+        RATE_ACTION_KICK,
+        NUM_RATE_ACTIONS
+    };
+
+    class TokenBucket {
+    public:
+        TokenBucket() = default;
+        TokenBucket(const double& burst) : m_tokens{ burst } {}
+
+        bool Take(const double& rate, const double& burst, const steady_clock::time_point& now);
+        // time until the next token is available
+        [[nodiscard]] steady_clock::duration GetWaitTime(const double& rate) const;
+        [[nodiscard]] bool IsFull(const double& rate, const double& burst, const steady_clock::time_point& now) const;
+
+    private:
+        double m_tokens{ 0.0 };
+        steady_clock::time_point m_updated_at{ steady_clock::now() };
+    };
+
+    // per peer token buckets, one for each message class. running out of tokens in a class escalates from
+    // dropping or delaying the message to kicking the peer once it keeps going for strike_window.
+    class RateLimiter {
+    public:
+        RateLimiter();
+        ~RateLimiter() = default;
+
+        eRateAction Check(const eRateClass& rate_class, steady_clock::duration& wait);
+        // delayed messages still waiting to be handled, capped by config::rate_limit::max_delayed
+        void OnDelayedHandled() { if (m_delayed > 0) --m_delayed; }
+
+    public:
+        static eRateClass GetTextClass(const std::string& text);
+        static eRateClass GetGameClass(const uint8_t& packet_type);
+
+    private:
+        eRateAction Decide(const eRateClass& rate_class, steady_clock::duration& wait);
+        static Counter& GetCounter(const eRateClass& rate_class, const eRateAction& action);
+
+    private:
+        std::array<TokenBucket, NUM_RATE_CLASSES> m_buckets{};
+        uint32_t m_strikes{ 0 };
+        steady_clock::time_point m_first_strike{};
+        uint32_t m_delayed{ 0 };
+    };
+
+    // connection attempts per remote address, checked before a peer gets a Player
+    class ConnectionLimiter {
+    public:
+        bool Allow(const uint32_t& host);
+        void Cleanup();
+
+    private:
+        std::unordered_map<uint32_t, TokenBucket> m_buckets{};
+    };
+}
@@ -9,9 +9,11 @@ namespace GTServer {
         m_world_pool{ std::make_shared<WorldPool>() } {
     }
     Server::~Server() {
+        if (!m_host)
+            return;
         if(!this->Stop())
             return;
-        enet_host_destroy(this->GetHost());
+        this->Close();
     }
 
     bool Server::Start() {
@@ -19,7 +21,7 @@ namespace GTServer {
         enet_address_set_host(&address, m_address.c_str());
         address.port = m_port;
 
-        m_host = enet_host_create(&address, m_max_peers, 2, 0, 0);
+        m_host = enet_host_create(&address, m_max_peers, NUM_CHANNELS, 0, 0);
         if (!m_host)
             return false;
         
@@ -32,4 +34,10 @@ namespace GTServer {
             pair.second->Disconnect(0U);
         return true;
     }
+    void Server::Close() {
+        if (!m_host)
+            return;
+        enet_host_destroy(m_host);
+        m_host = nullptr;
+    }
 }
\ No newline at end of file
@@ -17,6 +17,8 @@ namespace GTServer {
         
         bool Start();
         bool Stop();
+        // destroys the host, peers that didn't finish disconnecting are dropped
+        void Close();
     
         [[nodiscard]] uint8_t GetInstanceId() const { return m_instance_id; }
         [[nodiscard]] std::string GetAddress() const { return m_address; }
@@ -26,19 +28,12 @@ namespace GTServer {
         std::shared_ptr<PlayerPool> GetPlayerPool() { return m_player_pool; }
         std::shared_ptr<WorldPool> GetWorldPool() { return m_world_pool; }
 
-        void AddQueue(const eQueueType& queue_type, ServerQueue data) {
-            data.m_queue_type = queue_type;
-            m_queue_worker.push_back(data);
-        }
-    public:
-        std::deque<ServerQueue> m_queue_worker{};
-
     private:
         uint8_t m_instance_id;
         std::string m_address{ "0.0.0.0" };
         uint16_t m_port;
 
-        ENetHost* m_host;
+        ENetHost* m_host{ nullptr };
         size_t m_max_peers;
 
         std::shared_ptr<PlayerPool> m_player_pool;
@@ -0,0 +1,345 @@
+#include <server/server_gateway.h>
+#include <csignal>
+#include <thread>
+#include <fmt/chrono.h>
+#include <config.h>
+#include <database/kv_store.h>
+#include <player/objects/variantlist_sender.h>
+#include <utils/binary_reader.h>
+#include <utils/binary_writer.h>
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace GTServer {
+    ServerGateway::ServerGateway(const std::string& executable) : m_executable{ executable } {
+        for (std::size_t id = 0; id < config::cluster::workers; ++id)
+            m_processes.push_back(Process{ static_cast<int32_t>(id) });
+    }
+    ServerGateway::~ServerGateway() {
+        this->Stop();
+    }
+
+    bool ServerGateway::Start() {
+#ifdef _WIN32
+        fmt::print("ServerGateway -> worker processes are only supported on POSIX systems\n");
+        return false;
+#else
+        KeyValueStore& store{ KeyValueStore::Get() };
+        if (!store.Open(config::store::path)) {
+            fmt::print("ServerGateway -> failed to open KeyValueStore at {}\n", config::store::path);
+            return false;
+        }
+        if (!store.Migrate())
+            fmt::print("ServerGateway -> failed to migrate legacy player files into KeyValueStore\n");
+        if (!m_listener.Listen(config::cluster::socket_path))
+            return false;
+        m_server = std::make_unique<Server>(0, "0.0.0.0", config::server_default::port, 1024);
+        if (!m_server->Start()) {
+            fmt::print("ServerGateway -> failed to start enet server on port {}\n", config::server_default::port);
+            return false;
+        }
+        m_running = true;
+        for (auto& process : m_processes)
+            this->Spawn(process);
+        fmt::print("ServerGateway -> listening on port {} with {} workers - {}\n", config::server_default::port, m_processes.size(), std::chrono::system_clock::now());
+        return true;
+#endif
+    }
+    void ServerGateway::Stop() {
+        if (!m_running)
+            return;
+        m_running = false;
+#ifndef _WIN32
+        // every worker does its own graceful shutdown, wait for their saves before giving up on them
+        for (auto& process : m_processes) {
+            if (process.m_pid != -1)
+                kill(process.m_pid, SIGTERM);
+        }
+        // they keep sending their store changes while they drain, those are read and written the whole time
+        const steady_clock::time_point deadline{ steady_clock::now() + config::shutdown::drain_timeout + config::shutdown::save_deadline + config::shutdown::disconnect_timeout };
+        while (true) {
+            this->PollConnections();
+            for (auto& [id, connection] : m_connections)
+                connection->Flush();
+            bool alive{ false };
+            for (auto& process : m_processes) {
+                if (process.m_pid == -1)
+                    continue;
+                if (waitpid(process.m_pid, nullptr, WNOHANG) != 0)
+                    process.m_pid = -1;
+                else
+                    alive = true;
+            }
+            if (!alive)
+                break;
+            if (steady_clock::now() >= deadline) {
+                for (auto& process : m_processes) {
+                    if (process.m_pid == -1)
+                        continue;
+                    fmt::print("ServerGateway -> worker {} didn't stop in time, killing it\n", process.m_id);
+                    kill(process.m_pid, SIGKILL);
+                    waitpid(process.m_pid, nullptr, 0);
+                    process.m_pid = -1;
+                }
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        // whatever an exited worker wrote last is still in its socket, read every connection up to its end
+        const steady_clock::time_point eof_deadline{ steady_clock::now() + config::shutdown::disconnect_timeout };
+        while ((!m_connections.empty() || !m_pending.empty()) && steady_clock::now() < eof_deadline) {
+            this->PollConnections();
+            if (!m_connections.empty() || !m_pending.empty())
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+#endif
+        m_pending.clear();
+        m_connections.clear();
+        m_listener.Close();
+        KeyValueStore::Get().Close();
+        if (m_server) {
+            m_server->Close();
+            m_server.reset();
+        }
+    }
+
+    void ServerGateway::Poll() {
+        if (!m_running)
+            return;
+        this->ReapProcesses();
+        this->PollConnections();
+        this->PollHost();
+        for (auto& [id, connection] : m_connections)
+            connection->Flush();
+    }
+
+    bool ServerGateway::Spawn(Process& process) {
+#ifdef _WIN32
+        return false;
+#else
+        const std::string id{ std::to_string(process.m_id) };
+        char* argv[]{ const_cast<char*>(m_executable.c_str()), const_cast<char*>("--worker"), const_cast<char*>(id.c_str()), nullptr };
+        pid_t pid{};
+        if (posix_spawnp(&pid, m_executable.c_str(), nullptr, nullptr, argv, environ) != 0) {
+            fmt::print("ServerGateway -> failed to spawn worker {}\n", process.m_id);
+            process.m_respawn_at = steady_clock::now() + config::cluster::respawn_delay;
+            return false;
+        }
+        process.m_pid = pid;
+        fmt::print("ServerGateway -> spawned worker {} with pid {}\n", process.m_id, pid);
+        return true;
+#endif
+    }
+    void ServerGateway::ReapProcesses() {
+#ifndef _WIN32
+        const steady_clock::time_point now{ steady_clock::now() };
+        // a worker that is alive but stuck doesn't report anymore, it is killed and restarted like a crashed one
+        for (const auto& worker : m_balancer.GetExpiredWorkers(now)) {
+            fmt::print("ServerGateway -> worker {} stopped reporting, killing it\n", worker);
+            for (auto& process : m_processes) {
+                if (process.m_id == worker && process.m_pid != -1)
+                    kill(process.m_pid, SIGKILL);
+            }
+            this->OnWorkerLost(worker);
+        }
+        for (auto& process : m_processes) {
+            if (process.m_pid == -1) {
+                if (now >= process.m_respawn_at)
+                    this->Spawn(process);
+                continue;
+            }
+            int status{};
+            if (waitpid(process.m_pid, &status, WNOHANG) != process.m_pid)
+                continue;
+            fmt::print("ServerGateway -> worker {} exited with {}, restarting it in {}\n", process.m_id,
+                WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status), config::cluster::respawn_delay);
+            process.m_pid = -1;
+            process.m_respawn_at = now + config::cluster::respawn_delay;
+            this->OnWorkerLost(process.m_id);
+        }
+#endif
+    }
+    void ServerGateway::PollConnections() {
+        while (auto connection = m_listener.Accept())
+            m_pending.push_back(std::move(connection));
+
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            std::vector<IpcMessage> messages{};
+            const bool open{ (*it)->Receive(messages) };
+            if (messages.empty() || messages.front().m_type != IPC_MESSAGE_HELLO) {
+                it = open && messages.empty() ? it + 1 : m_pending.erase(it);
+                continue;
+            }
+            std::unique_ptr<IpcConnection> connection{ std::move(*it) };
+            it = m_pending.erase(it);
+            const int32_t worker{ BinaryReader{ messages.front().m_data }.read<int32_t>() };
+            this->OnHello(std::move(connection), messages.front());
+            for (std::size_t index = 1; index < messages.size(); ++index)
+                this->HandleMessage(worker, messages[index]);
+        }
+
+        std::vector<int32_t> lost{};
+        for (auto& [worker, connection] : m_connections) {
+            std::vector<IpcMessage> messages{};
+            if (!connection->Receive(messages))
+                lost.push_back(worker);
+            for (const auto& message : messages)
+                this->HandleMessage(worker, message);
+        }
+        for (const auto& worker : lost) {
+            fmt::print("ServerGateway -> lost the connection to worker {}\n", worker);
+            this->OnWorkerLost(worker);
+        }
+    }
+    void ServerGateway::PollHost() {
+        ENetEvent event{};
+        if (enet_host_service(m_server->GetHost(), &event, 10) <= 0)
+            return;
+        do {
+            switch (event.type) {
+            case ENET_EVENT_TYPE_CONNECT: {
+                VariantListSender{ event.peer }.SendPacket({ NET_MESSAGE_SERVER_HELLO }, sizeof(TankUpdatePacket));
+            } break;
+            case ENET_EVENT_TYPE_RECEIVE: {
+                // the client's login, it is repeated to the worker after the redirect
+                if (event.peer->state == ENET_PEER_STATE_CONNECTED) {
+                    VariantListSender sender{ event.peer };
+                    if (auto worker = m_balancer.PickWorker(); worker) {
+                        sender.OnSendToServer(worker->m_port, 0, 0, std::string{ config::server_default::address });
+                    }
+                    else {
+                        sender.SendLog("`4Sorry``, the server is starting up. Please try again in a minute.");
+                    }
+                    enet_peer_disconnect_later(event.peer, 0);
+                }
+                enet_packet_destroy(event.packet);
+            } break;
+            default:
+                break;
+            }
+        } while (enet_host_check_events(m_server->GetHost(), &event) > 0);
+    }
+
+    void ServerGateway::HandleMessage(const int32_t& worker, const IpcMessage& message) {
+        BinaryReader reader{ message.m_data };
+        switch (message.m_type) {
+        case IPC_MESSAGE_LOAD: {
+            const uint32_t players{ reader.read<uint32_t>() };
+            const uint32_t worlds{ reader.read<uint32_t>() };
+            m_balancer.OnReport(worker, players, worlds);
+        } break;
+        case IPC_MESSAGE_PRESENCE: {
+            const uint32_t user_id{ reader.read<uint32_t>() };
+            if (reader.read<uint8_t>() == 0) {
+                m_balancer.ClearPresence(user_id, worker);
+                break;
+            }
+            // one session per account across the cluster, the newest login wins like it does within a worker
+            if (const int32_t previous{ m_balancer.SetPresence(user_id, worker) }; previous != -1) {
+                std::vector<uint8_t> data(sizeof(uint32_t));
+                BinaryWriter{ data.data() }.write<uint32_t>(user_id);
+                this->Send(previous, IPC_MESSAGE_KICK, data);
+            }
+        } break;
+        case IPC_MESSAGE_CLAIM_WORLD: {
+            const std::string world{ reader.read_string() };
+            const int32_t previous{ m_balancer.GetWorldOwner(world) };
+            const int32_t owner{ m_balancer.ClaimWorld(world, worker) };
+            if (owner == previous)
+                this->Send(worker, IPC_MESSAGE_WORLD_OWNER, WorldOwner(world, owner));
+            else
+                this->SendAll(IPC_MESSAGE_WORLD_OWNER, WorldOwner(world, owner));
+        } break;
+        case IPC_MESSAGE_TRANSFER: {
+            const int32_t target{ reader.read<int32_t>() };
+            this->Send(target, IPC_MESSAGE_TRANSFER, message.m_data);
+        } break;
+        case IPC_MESSAGE_BROADCAST: {
+            this->SendAll(IPC_MESSAGE_BROADCAST, message.m_data, worker);
+        } break;
+        // the sender gets its own change back too, so every copy ends up in the order it was written here
+        case IPC_MESSAGE_STORE_PUT: {
+            const std::string key{ reader.read_string() };
+            const uint32_t size{ reader.read<uint32_t>() };
+            KeyValueStore::Get().Put(key, std::string{ reinterpret_cast<const char*>(reader.get() + reader.get_pos()), size });
+            this->SendAll(IPC_MESSAGE_STORE_PUT, message.m_data);
+        } break;
+        case IPC_MESSAGE_STORE_REMOVE: {
+            KeyValueStore::Get().Remove(reader.read_string());
+            this->SendAll(IPC_MESSAGE_STORE_REMOVE, message.m_data);
+        } break;
+        default:
+            break;
+        }
+    }
+    void ServerGateway::OnHello(std::unique_ptr<IpcConnection> connection, const IpcMessage& message) {
+        BinaryReader reader{ message.m_data };
+        const int32_t worker{ reader.read<int32_t>() };
+        const uint16_t port{ reader.read<uint16_t>() };
+        if (m_connections.contains(worker))
+            this->OnWorkerLost(worker);
+        fmt::print("ServerGateway -> worker {} is ready on port {}\n", worker, port);
+
+        // the newcomer needs the whole picture, everyone else just learns about the newcomer
+        for (const auto& [id, state] : m_balancer.GetWorkers())
+            connection->Send(IPC_MESSAGE_WORKER_STATE, WorkerState(id, state.m_port, true));
+        for (const auto& [world, owner] : m_balancer.GetWorlds())
+            connection->Send(IPC_MESSAGE_WORLD_OWNER, WorldOwner(world, owner));
+        KeyValueStore::Get().ForEach([&](const std::string& key, const std::string& value) {
+            connection->Send(IPC_MESSAGE_STORE_PUT, StorePut(key, value));
+        });
+        m_balancer.AddWorker(worker, port);
+        m_connections.insert_or_assign(worker, std::move(connection));
+        this->SendAll(IPC_MESSAGE_WORKER_STATE, WorkerState(worker, port, true));
+    }
+    void ServerGateway::OnWorkerLost(const int32_t& worker) {
+        const LoadBalancer::Worker* state{ m_balancer.GetWorker(worker) };
+        m_connections.erase(worker);
+        if (!state)
+            return;
+        const uint16_t port{ state->m_port };
+        const std::vector<std::string> worlds{ m_balancer.RemoveWorker(worker) };
+        this->SendAll(IPC_MESSAGE_WORKER_STATE, WorkerState(worker, port, false));
+        for (const auto& world : worlds)
+            this->SendAll(IPC_MESSAGE_WORLD_OWNER, WorldOwner(world, -1));
+        fmt::print("ServerGateway -> worker {} removed, {} worlds released\n", worker, worlds.size());
+    }
+
+    void ServerGateway::Send(const int32_t& worker, const uint16_t& type, const std::vector<uint8_t>& data) {
+        if (auto it = m_connections.find(worker); it != m_connections.end())
+            it->second->Send(type, data);
+    }
+    void ServerGateway::SendAll(const uint16_t& type, const std::vector<uint8_t>& data, const int32_t& except) {
+        for (auto& [worker, connection] : m_connections) {
+            if (worker != except)
+                connection->Send(type, data);
+        }
+    }
+    std::vector<uint8_t> ServerGateway::WorldOwner(const std::string& world, const int32_t& owner) {
+        std::vector<uint8_t> ret(sizeof(uint16_t) + world.size() + sizeof(int32_t));
+        BinaryWriter writer{ ret.data() };
+        writer.write(world);
+        writer.write<int32_t>(owner);
+        return ret;
+    }
+    std::vector<uint8_t> ServerGateway::StorePut(const std::string& key, const std::string& value) {
+        std::vector<uint8_t> ret(sizeof(uint16_t) + key.size() + sizeof(uint32_t) + value.size());
+        BinaryWriter writer{ ret.data() };
+        writer.write(key);
+        writer.write<uint32_t>(static_cast<uint32_t>(value.size()));
+        writer.write(value.data(), value.size());
+        return ret;
+    }
+    std::vector<uint8_t> ServerGateway::WorkerState(const int32_t& worker, const uint16_t& port, const bool& alive) {
+        std::vector<uint8_t> ret(sizeof(int32_t) + sizeof(uint16_t) + sizeof(uint8_t));
+        BinaryWriter writer{ ret.data() };
+        writer.write<int32_t>(worker);
+        writer.write<uint16_t>(port);
+        writer.write<uint8_t>(alive ? 1 : 0);
+        return ret;
+    }
+}
@@ -1,5 +1,63 @@
 #pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <server/ipc.h>
+#include <server/load_balancer.h>
+#include <server/server.h>
+#include <utils/timing_clock.h>
 
 namespace GTServer {
-    class ServerGateway;
-}
\ No newline at end of file
+    // owns the public port, spawns the worker processes and sends every client to the least loaded one.
+    // Workers report to it over a unix socket, it keeps track of world ownership and sessions and relays
+    // transfers and broadcasts between them. A worker that dies or stops reporting is restarted.
+    // It's also the only writer of the KeyValueStore log, the workers send their changes here.
+    class ServerGateway {
+    public:
+        explicit ServerGateway(const std::string& executable);
+        ~ServerGateway();
+
+        bool Start();
+        void Stop();
+        void Poll();
+
+        [[nodiscard]] uint16_t GetPort() const { return m_server ? m_server->GetPort() : 0; }
+        [[nodiscard]] const LoadBalancer& GetLoadBalancer() const { return m_balancer; }
+
+    private:
+        struct Process {
+            int32_t m_id;
+            int m_pid{ -1 };
+            steady_clock::time_point m_respawn_at{};
+        };
+
+        bool Spawn(Process& process);
+        void ReapProcesses();
+        void PollConnections();
+        void PollHost();
+
+        void HandleMessage(const int32_t& worker, const IpcMessage& message);
+        void OnHello(std::unique_ptr<IpcConnection> connection, const IpcMessage& message);
+        void OnWorkerLost(const int32_t& worker);
+
+        void Send(const int32_t& worker, const uint16_t& type, const std::vector<uint8_t>& data);
+        void SendAll(const uint16_t& type, const std::vector<uint8_t>& data, const int32_t& except = -1);
+        static std::vector<uint8_t> WorldOwner(const std::string& world, const int32_t& owner);
+        static std::vector<uint8_t> WorkerState(const int32_t& worker, const uint16_t& port, const bool& alive);
+        static std::vector<uint8_t> StorePut(const std::string& key, const std::string& value);
+
+    private:
+        std::string m_executable;
+        bool m_running{ false };
+
+        std::unique_ptr<Server> m_server{};
+        IpcListener m_listener{};
+        LoadBalancer m_balancer{};
+
+        std::vector<Process> m_processes{};
+        // connections that haven't introduced themselves yet
+        std::vector<std::unique_ptr<IpcConnection>> m_pending{};
+        std::unordered_map<int32_t, std::unique_ptr<IpcConnection>> m_connections{};
+    };
+}
@@ -4,9 +4,17 @@
 #include <enet/enet.h>
 #include <event/event_pool.h>
 #include <player/player_pool.h>
+#include <player/friends_graph.h>
+#include <player/playmod_timer.h>
 #include <world/world_pool.h>
 #include <render/world_render.h>
+#include <server/cluster_client.h>
+#include <server/item_data_stream.h>
+#include <server/login_pipeline.h>
+#include <server/memory_report.h>
 #include <database/database.h>
+#include <database/kv_store.h>
+#include <database/world_journal.h>
 #include <utils/text.h>
 #include <proton/packet.h>
 
@@ -15,9 +23,20 @@ namespace GTServer {
         PacketDecoder{ },
         m_events{ events } {
         fmt::print("Initializing ServerPool\n");
+        m_login_pipeline = std::make_unique<LoginPipeline>(this);
+        for (std::size_t type = 0; type < NUM_QUEUE_TYPES; ++type)
+            m_queue_latency[type] = &Metrics::Get().GetHistogram("gtserver_queue_job_duration_seconds", "Time spent handling a queued job",
+                fmt::format("queue=\"{}\"", magic_enum::enum_name(static_cast<eQueueType>(type))));
+        m_service_latency = &Metrics::Get().GetHistogram("gtserver_enet_service_duration_seconds", "Time spent in a single enet_host_service call");
+        m_connects = &Metrics::Get().GetCounter("gtserver_enet_connects_total", "Accepted ENet connections");
+        m_disconnects = &Metrics::Get().GetCounter("gtserver_enet_disconnects_total", "ENet disconnections");
+        m_received_packets = &Metrics::Get().GetCounter("gtserver_enet_received_packets_total", "Packets received from clients");
+        m_rejected_connects = &Metrics::Get().GetCounter("gtserver_enet_rejected_connects_total", "Connections refused by the per address rate limit");
+        m_slow_disconnects = &Metrics::Get().GetCounter("gtserver_slow_client_disconnects_total", "Peers disconnected for staying over their outbound budget");
     }
     ServerPool::~ServerPool() {
         //TODO: delete servers
+        this->StopService();
         enet_deinitialize();
     }
 
@@ -62,11 +81,13 @@ namespace GTServer {
             return;
         if (m_servers.empty())
             this->StartInstance();
+        if (!m_login_pipeline->Start(config::login::worker_threads))
+            return;
         m_running.store(true);
 
         m_threads.push_back(std::thread{ &ServerPool::ServicePoll, this });
         m_threads.push_back(std::thread{ [&]() {
-            while (true) {
+            while (m_running.load()) {
                 if (this->m_queue_worker.empty())
                     continue;
                 auto now = high_resolution_clock::now();
@@ -76,16 +97,16 @@ namespace GTServer {
                 case QUEUE_TYPE_FINDING_ITEMS: {
                     std::string keyword = ctx.m_keyword;
                     std::transform(keyword.begin(), keyword.end(), keyword.begin(), [](unsigned char c) { return std::tolower(c); });
-                    std::vector<ItemInfo*> items;
+                    std::vector<const ItemInfo*> items;
 
                     for (const auto& item : ItemDatabase::GetItems()) {
-                        std::string item_name = item->m_name;
+                        std::string item_name{ item.m_name };
                         std::transform(item_name.begin(), item_name.end(), item_name.begin(), [](unsigned char c) { return std::tolower(c); });
                         if (item_name.find(keyword) == std::string::npos)
                             continue;
-                        if (item->m_id % 2 == 1)
+                        if (item.m_id % 2 == 1)
                             continue;
-                        items.push_back(item);
+                        items.push_back(&item);
                     }
 
                     if (items.size() < 1) {
@@ -106,7 +127,7 @@ namespace GTServer {
                     for (uint16_t index = 0; index < items.size(); index++) {
                         if (index >= 50)
                             break;
-                        ItemInfo* item = items[index];
+                        const ItemInfo* item = items[index];
                         dialog.text_scaling_string("|")
                             ->add_checkicon(fmt::format("item_{}", item->m_id), fmt::format("`w{}``", item->m_name), item->m_id, fmt::format("{}", item->m_id), false);
                     }
@@ -117,36 +138,23 @@ namespace GTServer {
                     ctx.m_player->v_sender.OnDialogRequest(dialog.get());
                 } break;
                 case QUEUE_TYPE_GET_FRIENDS: {
-                    std::string friends_file_path = std::format("PlayerData/{}/friends.txt", ctx.m_player->GetUserId());
-
-                    // Check if the file exists and create it if it doesn't
-                    std::ifstream friends_file(friends_file_path);
-                    if (!friends_file.good()) {
-                        std::ofstream new_file(friends_file_path);
-                        new_file.close();
-                    }
-
-                    // Re-open the file for reading
-                    friends_file.open(friends_file_path);
+                    const auto& friends{ FriendsGraph::Get().GetFriends(ctx.m_player->GetUserId()) };
 
                     // Create a dialog builder object to build the dialog
                     DialogBuilder dialog;
 
                     // Add a label with the title of the dialog
-                    dialog.add_label_with_icon("`wFriends``", ITEM_FRIENDLY_COCONUT, DialogBuilder::LEFT, DialogBuilder::BIG);
+                    dialog.add_label_with_icon(fmt::format("`wFriends`` ({})", friends.size()), ITEM_FRIENDLY_COCONUT, DialogBuilder::LEFT, DialogBuilder::BIG);
 
                     // Add a spacer between the title and the list of friends
                     dialog.add_spacer();
 
-                    // Create a loop to read each line of the friends.txt file
-                    std::string line;
-                    while (std::getline(friends_file, line)) {
-                        // Trim any whitespace from the beginning and end of the line
-                        line = std::regex_replace(line, std::regex("^\\s+|\\s+$"), "");
-
-                        // Add a button for the user ID on this line
-                        dialog.embed_data<uint32_t>("friend_id", std::stoul(line))
-                            ->add_button("view_friend", line);
+                    // Add a button for each friend, online ones first with their display name
+                    for (const auto& entry : friends) {
+                        dialog.embed_data<uint32_t>("friend_id", entry.m_user_id)
+                            ->add_button("view_friend", entry.m_player ?
+                                fmt::format("`2{}`` (online)", entry.m_player->GetDisplayName()) :
+                                fmt::format("`o{}``", entry.m_user_id));
                     }
 
                     // Add a spacer at the end of the list of friends
@@ -194,9 +202,9 @@ namespace GTServer {
                     ctx.m_player->v_sender.OnDialogRequest(db.get());
                 } break;
                 case QUEUE_TYPE_RENDER_WORLD: {
-                    if (!ctx.m_world)
+                    if (!ctx.m_snapshot)
                         break;
-                    auto result = WorldRender::render(this, ctx.m_world);
+                    auto result = WorldRender::render(this, ctx.m_snapshot);
                     switch (result) {
                     case WorldRender::RENDER_RESULT_SUCCESS: {
                         PlayerTable* database = (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE);
@@ -206,18 +214,18 @@ namespace GTServer {
                         dpp::embed().
                             set_color(0x00FFFF). 
                             add_field(
-                                "World:", ctx.m_world->GetName(), true
+                                "World:", ctx.m_snapshot->GetName(), true
                             ).
-                            set_image(fmt::format("attachment://{}.png", ctx.m_world->GetName())).
+                            set_image(fmt::format("attachment://{}.png", ctx.m_snapshot->GetName())).
                             set_footer(dpp::embed_footer().set_text("BetterGrowtopia")).
                             set_timestamp(std::time(0))
                         );
-                        message.set_file_content(dpp::utility::read_file(fmt::format("renders/{}.png", ctx.m_world->GetName())));
-                        message.set_filename(fmt::format("{}.png", ctx.m_world->GetName()));
+                        message.set_file_content(dpp::utility::read_file(fmt::format("renders/{}.png", ctx.m_snapshot->GetName())));
+                        message.set_filename(fmt::format("{}.png", ctx.m_snapshot->GetName()));
                         vanguard->message_create(message);
                     } break;
                     case WorldRender::RENDER_RESULT_FAILED: {
-                        fmt::print("WorldRender::Render -> failed to render world {}\n", ctx.m_world->GetName());
+                        fmt::print("WorldRender::Render -> failed to render world {}\n", ctx.m_snapshot->GetName());
                     } break;
                     }
                 } break;
@@ -282,79 +290,165 @@ namespace GTServer {
                 }
 
                 auto time_taken = high_resolution_clock::now() - now;
+                m_queue_latency[ctx.m_queue_type]->Record(time_taken);
                 ctx.m_player->SendLog("[DEBUG]: handled {} for `w{}``, took {}ms - {}us", magic_enum::enum_name(ctx.m_queue_type), ctx.m_player->GetDisplayName(ctx.m_world != nullptr ? ctx.m_world : nullptr),
                     std::chrono::duration_cast<std::chrono::milliseconds>(time_taken).count(), std::chrono::duration_cast<std::chrono::microseconds>(time_taken).count());
                 this->m_queue_worker.pop_front();
             }
         }});
-        m_threads.push_back(std::thread{ [&]() {
-            while (m_running.load())  {
-            for (auto& server : m_servers) {
-                auto& queues = server->m_queue_worker;
-                if (queues.empty())
+    }
+    void ServerPool::StopService() {
+        if (!m_running.load())
+            return;
+        m_running.store(false);
+        for (auto& thread : m_threads) {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_threads.clear();
+        m_login_pipeline->Stop();
+        // the service loop is gone, whatever the workers finished last is sent from here
+        m_login_pipeline->Poll();
+    }
+    void ServerPool::Shutdown() {
+        if (!m_running.load())
+            return;
+        const steady_clock::time_point started_at{ steady_clock::now() };
+        fmt::print("ServerPool -> shutting down, {} players online\n", this->GetActivePlayers());
+        m_accepting.store(false);
+        m_shutdown_notice.store(true);
+
+        // the service loop keeps running until the queued jobs and logins are handled
+        const steady_clock::time_point drain_deadline{ started_at + config::shutdown::drain_timeout };
+        while (steady_clock::now() < drain_deadline && (this->GetQueueSize() > 0 || m_login_pipeline->GetPendingCount() > 0))
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (this->GetQueueSize() > 0 || m_login_pipeline->GetPendingCount() > 0)
+            fmt::print("ServerPool -> drain timed out, {} jobs and {} logins dropped\n", this->GetQueueSize(), m_login_pipeline->GetPendingCount());
+        this->StopService();
+
+        this->SaveAll(steady_clock::now() + config::shutdown::save_deadline);
+        this->CloseHosts();
+        // the gateway hands our worlds to whoever asks for them next, so they have to be saved first,
+        // and it's where the last store changes are written
+        ClusterClient::Get().Stop();
+        WorldJournal::Get().Stop();
+        KeyValueStore::Get().Close();
+        fmt::print("ServerPool -> shut down in {}\n", std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now() - started_at));
+    }
+    void ServerPool::SaveAll(const steady_clock::time_point& deadline) {
+        struct SaveJob {
+            std::shared_ptr<Player> m_player{};
+            std::shared_ptr<const WorldSnapshot> m_world{};
+        };
+        std::vector<SaveJob> jobs{};
+        std::size_t players{ 0 }, worlds{ 0 };
+        for (auto& player : this->GetPlayers()) {
+            if (!player->IsFlagOn(PLAYERFLAG_LOGGED_ON))
+                continue;
+            player->set_last_active(system_clock::now());
+            jobs.push_back(SaveJob{ .m_player = player });
+            ++players;
+        }
+        // a world without journal records is identical to what is on disk already
+        for (auto& server : m_servers) {
+            for (auto& [name, world] : server->GetWorldPool()->GetWorlds()) {
+                if (!world || world->GetID() < 1)
                     continue;
-                ServerQueue& ctx = queues.front();
-                if (!ctx.m_player)
+                WorldJournal::Get().Commit(world);
+                if (WorldJournal::Get().GetSize(world->GetID()) == 0)
                     continue;
+                jobs.push_back(SaveJob{ .m_world = world->CreateSnapshot() });
+                ++worlds;
+            }
+        }
+        // one batched fsync, a world that misses the deadline is still recovered from its journal
+        WorldJournal::Get().Flush(-1);
 
-                switch (ctx.m_queue_type) {
-                case SERVERQUEUE_TYPE_LOGIN: {
-                    PlayerTable* table = (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE);
-                    if (!table->Load(ctx.m_player)) {
-                        ctx.m_player->SendLog("`4Unable to log on: `oThat `wGrowID `odoesn't seem valid, or the password is wrong. If you don't have one, press `wCancel`o, un-check `w'I have a GrowID'`o, then click `wConnect`o.``");
-                        ctx.m_player->SendSetURL(config::server::discord, "`eBetterGrowtopia Discord``");
-                        ctx.m_player->Disconnect(0U);
-                        break;
-                    }
-                    bool found_session{ false };
-                    for (auto& player : this->GetPlayers()) {
-                        if (!(ctx.m_player->GetPeer() != player->GetPeer() && ctx.m_player->GetUserId() == player->GetUserId()))
-                            continue;
-                        ctx.m_player->v_sender.OnConsoleMessage("`4OOPS, `oSomeone else was logged into this account! He was kicked out now.``");
-                        player->v_sender.OnConsoleMessage("`4OOPS, `oSomeone else logged into this account!``");
-                        player->Disconnect(0U);
-                        found_session = true;
-                        break;
-                    }
-                    if (found_session) {       
-                        if (!table->Load(ctx.m_player)) {
-                            ctx.m_player->SendLog("`4Unable to log on: `oThat `wGrowID `odoesn't seem valid, or the password is wrong. If you don't have one, press `wCancel`o, un-check `w'I have a GrowID'`o, then click `wConnect`o.``");
-                            ctx.m_player->SendSetURL(config::server::discord, "`eBetterGrowtopia Discord``");
-                            ctx.m_player->Disconnect(0U);
-                            break;
-                        }
-                    }
-                    // TODO: Player::IsPlaymodActive(PLAYMOD_TYPE_BAN)
-
-                    ctx.m_player->SetFlag(PLAYERFLAG_LOGGED_ON);
-                    ctx.m_player->v_sender.OnSuperMainStart(
-                        ItemDatabase::Get().GetHash(),
-                        config::server::cache_server, 
-                        config::server::cache_path, 
-                        "cc.cz.madkite.freedom org.aqua.gg idv.aqua.bulldog com.cih.gamecih2 com.cih.gamecih com.cih.game_cih cn.maocai.gamekiller com.gmd.speedtime org.dax.attack com.x0.strai.frep com.x0.strai.free org.cheatengine.cegui org.sbtools.gamehack com.skgames.traffikrider org.sbtoods.gamehaca com.skype.ralder org.cheatengine.cegui.xx.multi1458919170111 com.prohiro.macro me.autotouch.autotouch com.cygery.repetitouch.free com.cygery.repetitouch.pro com.proziro.zacro com.slash.gamebuster",
-                        "proto=175|choosemusic=audio/mp3/about_theme.mp3|active_holiday=0|wing_week_day=0|ubi_week_day=0|server_tick=263203319|clash_active=0|drop_lavacheck_faster=1|isPayingUser=0|usingStoreNavigation=1|enableInventoryTab=1|bigBackpack=1|",
-                        PlayerTribute::get().get_hash()
-                    );
-                    fmt::print("[LoginQueue]: A player {} has logged on, userId: {} - {}\n", ctx.m_player->GetRawName(), ctx.m_player->GetUserId(), system_clock::now());
-                } break;
-                default:
+        std::atomic<std::size_t> next{ 0 }, saved_players{ 0 }, saved_worlds{ 0 };
+        auto save = [&](PlayerTable& player_table, WorldTable& world_table) {
+            while (steady_clock::now() < deadline) {
+                const std::size_t index{ next.fetch_add(1) };
+                if (index >= jobs.size())
                     break;
+                const SaveJob& job{ jobs[index] };
+                if (job.m_player) {
+                    if (player_table.Save(job.m_player))
+                        saved_players.fetch_add(1);
+                    else
+                        fmt::print("PlayerTable::save, Failed to save {}\n", job.m_player->GetRawName());
+                    continue;
                 }
-                queues.pop_front();
-            }}
-        }});
-        for (auto& thread : m_threads)
-            thread.detach();
+                if (!world_table.save(job.m_world)) {
+                    fmt::print("WorldTable::save, Failed to save {}\n", job.m_world->GetName());
+                    continue;
+                }
+                WorldJournal::Get().Checkpoint(job.m_world->GetID());
+                saved_worlds.fetch_add(1);
+            }
+        };
+        std::vector<std::thread> threads{};
+        for (std::size_t i = 0; i < std::min(config::shutdown::save_workers, jobs.size()); ++i) {
+            auto connection{ Database::CreateConnection() };
+            if (!connection)
+                break;
+            threads.push_back(std::thread{ [&save, connection = std::move(connection)]() {
+                PlayerTable player_table{ connection.get() };
+                WorldTable world_table{ connection.get() };
+                save(player_table, world_table);
+            } });
+        }
+        if (threads.empty() && !jobs.empty())
+            save(*(PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE), *(WorldTable*)Database::GetTable(Database::DATABASE_WORLD_TABLE));
+        for (auto& thread : threads)
+            thread.join();
+        fmt::print("ServerPool -> saved {}/{} players and {}/{} worlds with {} connections\n", saved_players.load(), players, saved_worlds.load(), worlds, threads.size());
     }
-    void ServerPool::StopService() {
-        if (!m_running.load())
-            return;
-        m_running.store(false);
+    void ServerPool::CloseHosts() {
+        for (auto& server : m_servers)
+            server->Stop();
+        // give the disconnects a chance to reach the clients, anything left is dropped with the host
+        const steady_clock::time_point deadline{ steady_clock::now() + config::shutdown::disconnect_timeout };
+        while (steady_clock::now() < deadline) {
+            bool connected{ false };
+            for (auto& server : m_servers) {
+                ENetEvent event{};
+                while (enet_host_service(server->GetHost(), &event, 0) > 0) {
+                    if (event.type == ENET_EVENT_TYPE_RECEIVE)
+                        enet_packet_destroy(event.packet);
+                    else if (event.type == ENET_EVENT_TYPE_DISCONNECT && event.peer->data) {
+                        std::free(event.peer->data);
+                        event.peer->data = NULL;
+                    }
+                }
+                for (std::size_t i = 0; i < server->GetHost()->peerCount; ++i) {
+                    if (server->GetHost()->peers[i].state != ENET_PEER_STATE_DISCONNECTED)
+                        connected = true;
+                }
+            }
+            if (!connected)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        for (auto& server : m_servers)
+            server->Close();
     }
     void ServerPool::ServicePoll() {
         try {
         ENetEvent event{};
+        TimingClock memory_report{ config::server::memory_report_interval };
+        TimingClock stats_publish{ config::server::stats_interval };
+        steady_clock::time_point journal_commit{ steady_clock::now() };
+        steady_clock::time_point outbound_check{ steady_clock::now() };
+        TimingClock connect_cleanup{ config::rate_limit::connect_cleanup_interval };
         while (m_running.load()) {
+            this->HandleDelayedPackets();
+            PlaymodTimer::Get().Poll();
+            ClusterClient::Get().Poll(this);
+            m_login_pipeline->Poll();
+            if (m_shutdown_notice.exchange(false)) {
+                for (auto& player : this->GetPlayers())
+                    player->SendLog("`4The server is restarting``, your progress is being saved. Please reconnect in a minute.");
+            }
             for (auto& server : m_servers) {
                 while (enet_host_check_events(server->GetHost(), &event)) {
                     if (!event.peer)
@@ -362,11 +456,18 @@ namespace GTServer {
 
                     switch(event.type) {
                     case ENET_EVENT_TYPE_CONNECT: {
+                        if (!m_accepting.load() || !m_connection_limiter.Allow(event.peer->address.host)) {
+                            m_rejected_connects->Increase();
+                            enet_peer_disconnect(event.peer, 0);
+                            break;
+                        }
+                        m_connects->Increase();
                         std::shared_ptr<Player> player{ server->GetPlayerPool()->NewPlayer(event.peer) };
                         player->SendPacket({ NET_MESSAGE_SERVER_HELLO }, sizeof(TankUpdatePacket));
                         break;
                     }
                     case ENET_EVENT_TYPE_DISCONNECT: {
+                        m_disconnects->Increase();
                         if (!event.peer->data)
                             break;
                         std::uint32_t connect_id{};
@@ -377,7 +478,9 @@ namespace GTServer {
                         std::shared_ptr<Player> player{ server->GetPlayerPool()->GetPlayer(connect_id) };
                         if (!player)
                             return;
+                        this->UnregisterSession(player);
                         if (player->IsFlagOn(PLAYERFLAG_LOGGED_ON)) {
+                            FriendsGraph::Get().OnLogout(player);
                             player->set_last_active(system_clock::now());
                             PlayerTable* db{ (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE) };
                             if (!db->Save(player))
@@ -393,6 +496,7 @@ namespace GTServer {
                         break;
                     }
                     case ENET_EVENT_TYPE_RECEIVE: {
+                        m_received_packets->Increase();
                         if (event.packet->dataLength < sizeof(TankUpdatePacket::m_type) + 1 || event.packet->dataLength > 0x400) {
                             enet_packet_destroy(event.packet);
                             break;
@@ -402,54 +506,24 @@ namespace GTServer {
                             enet_packet_destroy(event.packet);
                             break;
                         }
-                        switch (*((int32_t*)event.packet->data)) {
-                        case NET_MESSAGE_GENERIC_TEXT:
-                        case NET_MESSAGE_GAME_MESSAGE: {
-                            const auto& str = PacketDecoder::DataToString(event.packet->data + 4, event.packet->dataLength - 4);
-                            EventContext ctx { 
-                                .m_player = player,
-                                .m_events = this->GetEvents(),
-                                .m_server = server,
-                                .m_servers = this,
-                                .m_parser = TextScanner{ str }, 
-                                .m_update_packet = nullptr 
-                            };
-                            std::string event_data = str.substr(0, str.find('|'));
-                            if (!m_events->execute(EVENT_TYPE_GENERIC_TEXT, event_data, ctx))
-                                break;
-                            break;
-                        }
-                        case NET_MESSAGE_GAME_PACKET: {
-                            GameUpdatePacket* update_packet = this->DataToUpdatePacket(event.packet);
-                            if (!update_packet)
-                                break;
-                            if (player->m_packet_sec + 1000 > std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() && update_packet->m_type != NET_GAME_PACKET_STATE && update_packet->m_type != NET_GAME_PACKET_ITEM_ACTIVATE_OBJECT_REQUEST) {
-                                if (player->m_packet_in_sec >= 85) {
-                                    player->SendLog("`4Warning: `oYou are sending too many packets!");
-                                    break;
-                                }
-                                player->m_packet_in_sec++;
-                            } else {
-                                player->m_packet_sec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                                player->m_packet_in_sec = 0;
-                            }
-                    
-                            EventContext ctx { 
-                                .m_player = player,
-                                .m_events = this->GetEvents(),
-                                .m_server = server,
-                                .m_servers = this,
-                                .m_parser = TextScanner{}, 
-                                .m_update_packet = update_packet 
-                            };
-
-                            if (!m_events->execute(EVENT_TYPE_GAME_PACKET, "gup_" + std::to_string(update_packet->m_type), ctx)) {
-                                player->SendLog("unhandled EVENT_TYPE_GAME_PACKET -> `w{}`o", magic_enum::enum_name(static_cast<eNetPacketType>(update_packet->m_type)));
-                                break;
-                            }
+                        const eRateClass rate_class{ this->GetRateClass(event.packet) };
+                        steady_clock::duration wait{};
+                        switch (player->m_rate_limiter.Check(rate_class, wait)) {
+                        case RATE_ACTION_ALLOW: {
+                            this->HandlePacket(server, player, event.packet);
+                        } break;
+                        case RATE_ACTION_DELAY: {
+                            // handled by HandleDelayedPackets, which also destroys it
+                            m_delayed_packets.push_back(DelayedPacket{ server, event.peer->connectID, event.packet, steady_clock::now() + wait });
+                            event.packet = nullptr;
+                        } break;
+                        case RATE_ACTION_KICK: {
+                            player->SendLog("`4Warning: `oYou are sending too many packets!");
+                            player->Disconnect(0U);
+                        } break;
+                        default:
                             break;
                         }
-                        }
                         enet_packet_destroy(event.packet);
                         break;
                     }
@@ -459,29 +533,192 @@ namespace GTServer {
                     }
                 }
 
-                enet_host_service(server->GetHost(), nullptr, 0);
+                server->GetWorldPool()->ProcessInboxes();
+                // one batch per world for everything changed by the events above, flushed by the service call below
+                server->GetWorldPool()->FlushTileUpdates();
+                {
+                    ScopedLatency latency{ *m_service_latency };
+                    enet_host_service(server->GetHost(), nullptr, 0);
+                }
             } 
+            if (memory_report.GetPassedTime() >= memory_report.GetTimeout()) {
+                MemoryAccounting::Get().Collect(this);
+                memory_report.UpdateTime();
+            }
+            if (stats_publish.GetPassedTime() >= stats_publish.GetTimeout()) {
+                this->PublishStats();
+                stats_publish.UpdateTime();
+            }
+            if (connect_cleanup.GetPassedTime() >= connect_cleanup.GetTimeout()) {
+                m_connection_limiter.Cleanup();
+                connect_cleanup.UpdateTime();
+            }
+            if (steady_clock::now() - outbound_check >= config::outbound::check_interval) {
+                this->CheckOutboundBudgets();
+                ItemDataStream::Get().Poll();
+                outbound_check = steady_clock::now();
+            }
+            if (steady_clock::now() - journal_commit >= config::journal::commit_interval) {
+                for (auto& server : m_servers)
+                    server->GetWorldPool()->CommitJournal();
+                journal_commit = steady_clock::now();
+            }
         }
         } catch (std::exception& e) {
             fmt::print("ServerPool >> {}\n", e.what());
         }
     }
 
-    bool ServerPool::HasPlayer(const uint32_t& user_id) const {
+    void ServerPool::HandlePacket(std::shared_ptr<Server> server, std::shared_ptr<Player> player, ENetPacket* packet) {
+        switch (*((int32_t*)packet->data)) {
+        case NET_MESSAGE_GENERIC_TEXT:
+        case NET_MESSAGE_GAME_MESSAGE: {
+            const auto& str = PacketDecoder::DataToString(packet->data + 4, packet->dataLength - 4);
+            EventContext ctx { 
+                .m_player = player,
+                .m_events = this->GetEvents(),
+                .m_server = server,
+                .m_servers = this,
+                .m_parser = TextScanner{ str }, 
+                .m_update_packet = nullptr 
+            };
+            std::string event_data = str.substr(0, str.find('|'));
+            if (!m_events->execute(EVENT_TYPE_GENERIC_TEXT, event_data, ctx))
+                break;
+            break;
+        }
+        case NET_MESSAGE_GAME_PACKET: {
+            GameUpdatePacket* update_packet = this->DataToUpdatePacket(packet);
+            if (!update_packet)
+                break;
+            EventContext ctx { 
+                .m_player = player,
+                .m_events = this->GetEvents(),
+                .m_server = server,
+                .m_servers = this,
+                .m_parser = TextScanner{}, 
+                .m_update_packet = update_packet 
+            };
+
+            if (!m_events->execute(EVENT_TYPE_GAME_PACKET, "gup_" + std::to_string(update_packet->m_type), ctx)) {
+                player->SendLog("unhandled EVENT_TYPE_GAME_PACKET -> `w{}`o", magic_enum::enum_name(static_cast<eNetPacketType>(update_packet->m_type)));
+                break;
+            }
+            break;
+        }
+        }
+    }
+    eRateClass ServerPool::GetRateClass(ENetPacket* packet) {
+        switch (*((int32_t*)packet->data)) {
+        case NET_MESSAGE_GENERIC_TEXT:
+        case NET_MESSAGE_GAME_MESSAGE:
+            return RateLimiter::GetTextClass(PacketDecoder::DataToString(packet->data + 4, packet->dataLength - 4));
+        case NET_MESSAGE_GAME_PACKET: {
+            GameUpdatePacket* update_packet = this->DataToUpdatePacket(packet);
+            if (!update_packet)
+                return RATE_CLASS_GAME;
+            return RateLimiter::GetGameClass(update_packet->m_type);
+        }
+        default:
+            return RATE_CLASS_ACTION;
+        }
+    }
+    void ServerPool::HandleDelayedPackets() {
+        if (m_delayed_packets.empty())
+            return;
+        const auto now{ steady_clock::now() };
+        std::vector<DelayedPacket> ready{};
+        std::erase_if(m_delayed_packets, [&](const DelayedPacket& delayed) {
+            if (delayed.m_ready_at > now)
+                return false;
+            ready.push_back(delayed);
+            return true;
+        });
+        for (auto& delayed : ready) {
+            // the peer may have left while its packet was waiting
+            if (std::shared_ptr<Player> player{ delayed.m_server->GetPlayerPool()->GetPlayer(delayed.m_connect_id) }; player) {
+                player->m_rate_limiter.OnDelayedHandled();
+                this->HandlePacket(delayed.m_server, player, delayed.m_packet);
+            }
+            enet_packet_destroy(delayed.m_packet);
+        }
+    }
+
+    void ServerPool::PublishStats() {
+        std::size_t worlds{ 0 }, worlds_memory{ 0 };
         for (auto& server : m_servers) {
-            auto pool = server->GetPlayerPool();
-            if (pool->HasPlayer(user_id))
-                return true;
+            for (auto& [name, world] : server->GetWorldPool()->GetWorlds()) {
+                ++worlds;
+                worlds_memory += world->GetMemoryUsage();
+            }
         }
-        return false;
+        m_stats.m_players.store(this->GetActivePlayers(), std::memory_order_relaxed);
+        m_stats.m_worlds.store(worlds, std::memory_order_relaxed);
+        m_stats.m_worlds_memory.store(worlds_memory, std::memory_order_relaxed);
+        m_stats.m_queue_depth.store(this->GetQueueSize(), std::memory_order_relaxed);
     }
-    std::shared_ptr<Player> ServerPool::GetPlayerByUserID(const uint32_t& user_id) {
+    void ServerPool::CheckOutboundBudgets() {
+        const steady_clock::time_point now{ steady_clock::now() };
         for (auto& server : m_servers) {
-            auto pool = server->GetPlayerPool();
-            if (!pool->HasPlayer(user_id))
-                continue;
-            return pool->GetPlayerByUserId(user_id);
+            for (auto& [connect_id, player] : server->GetPlayerPool()->GetPlayers()) {
+                if (!player->GetPeer() || player->GetPeer()->state != ENET_PEER_STATE_CONNECTED)
+                    continue;
+                const bool was_congested{ player->IsCongested() };
+                const eOutboundState state{ player->UpdateOutboundBudget(now) };
+                if (was_congested && state == OUTBOUND_STATE_OK) {
+                    // the movement skipped in the meantime left everyone frozen where they were on this peer's screen
+                    if (auto world = this->GetWorld(player->GetWorld()); world) {
+                        world->Post([player](const std::shared_ptr<World>& world) {
+                            if (world->HasPlayer(player))
+                                world->SendPositions(player);
+                        });
+                    }
+                }
+                if (state != OUTBOUND_STATE_OVER_BUDGET)
+                    continue;
+                if (ItemDataStream::Get().IsStreaming(player->GetConnectID()))
+                    continue;
+                const OutboundBacklog& backlog{ player->m_outbound_budget.GetBacklog() };
+                fmt::print("ServerPool -> disconnecting {} ({}), {} bytes in {} packets waiting to be sent\n",
+                    player->GetRawName(), player->GetIPAddress(), backlog.m_bytes, backlog.m_packets);
+                m_slow_disconnects->Increase();
+                // disconnect_later would wait for the backlog to drain, this drops it right away
+                enet_peer_disconnect(player->GetPeer(), 0);
+            }
         }
+    }
+
+    std::shared_ptr<Player> ServerPool::RegisterSession(std::shared_ptr<Player> player) {
+        std::scoped_lock lock{ m_session_mutex };
+        auto& session{ m_sessions[player->GetUserId()] };
+        std::shared_ptr<Player> previous{ session.lock() };
+        session = player;
+        ClusterClient::Get().SetPresence(player->GetUserId(), true);
+        return previous != player ? previous : nullptr;
+    }
+    void ServerPool::UnregisterSession(std::shared_ptr<Player> player) {
+        std::scoped_lock lock{ m_session_mutex };
+        auto it{ m_sessions.find(player->GetUserId()) };
+        if (it == m_sessions.end())
+            return;
+        if (auto current = it->second.lock(); current && current != player)
+            return;
+        m_sessions.erase(it);
+        ClusterClient::Get().SetPresence(player->GetUserId(), false);
+    }
+    std::shared_ptr<Player> ServerPool::GetSession(const uint32_t& user_id) const {
+        std::scoped_lock lock{ m_session_mutex };
+        if (auto it = m_sessions.find(user_id); it != m_sessions.end())
+            return it->second.lock();
+        return nullptr;
+    }
+
+    bool ServerPool::HasPlayer(const uint32_t& user_id) const {
+        return this->GetSession(user_id) != nullptr;
+    }
+    std::shared_ptr<Player> ServerPool::GetPlayerByUserID(const uint32_t& user_id) {
+        if (auto player = this->GetSession(user_id); player)
+            return player;
         PlayerTable* database = (PlayerTable*)Database::GetTable(Database::DATABASE_PLAYER_TABLE);
         std::shared_ptr<Player> ret = std::make_shared<Player>(nullptr);
         if (!database->SerializeByUserID(ret, user_id))
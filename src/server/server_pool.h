@@ -1,11 +1,15 @@
 #pragma once
 #include <atomic>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <magic_enum.hpp>
+#include <server/metrics.h>
 #include <server/objects/queues.h>
+#include <server/rate_limiter.h>
 #include <server/server.h>
 #include <player/player_pool.h>
 #include <world/world_pool.h>
@@ -16,6 +20,7 @@
 
 namespace GTServer {
     class EventPool;
+    class LoginPipeline;
     class ServerPool : PacketDecoder {
     public:
         explicit ServerPool(std::shared_ptr<EventPool> events);
@@ -29,13 +34,32 @@ namespace GTServer {
 
         void StartService();
         void StopService();
+        // stops accepting players, drains the queues and saves every player and changed world before the hosts are closed
+        void Shutdown();
 
         void ServicePoll();
+        // first port StartInstance binds, workers of a cluster each get their own
+        void SetPort(const uint16_t& port) { m_port = port; }
         
+    private:
+        void HandlePacket(std::shared_ptr<Server> server, std::shared_ptr<Player> player, ENetPacket* packet);
+        eRateClass GetRateClass(ENetPacket* packet);
+        void HandleDelayedPackets();
+        // drops peers that stayed over their outbound budget, see OutboundBudget
+        void CheckOutboundBudgets();
+        void PublishStats();
+        void SaveAll(const steady_clock::time_point& deadline);
+        void CloseHosts();
+
     public:
         void SetUserID(const int& uid) { user_id = uid; }
         [[nodiscard]] int GetUserID(bool increase = true) { return increase ? ++user_id : user_id; }
 
+        // online sessions by user id, registering returns the session it replaced
+        std::shared_ptr<Player> RegisterSession(std::shared_ptr<Player> player);
+        void UnregisterSession(std::shared_ptr<Player> player);
+        std::shared_ptr<Player> GetSession(const uint32_t& user_id) const;
+
         bool HasPlayer(const uint32_t& user_id) const;
         std::shared_ptr<Player> GetPlayerByUserID(const uint32_t& user_id);
         std::shared_ptr<Player> GetPlayerByName(const std::string& name);
@@ -66,11 +90,22 @@ namespace GTServer {
             return ret;
         }
         std::shared_ptr<EventPool> GetEvents() const { return m_events; }
+        LoginPipeline* GetLoginPipeline() const { return m_login_pipeline.get(); }
         
         void AddQueue(const eQueueType& queue_type, ServerQueue data) {
             data.m_queue_type = queue_type;
             m_queue_worker.push_back(data);
         }
+        [[nodiscard]] std::size_t GetQueueSize() const { return m_queue_worker.size(); }
+
+        // counts published by the service loop, safe to read from any thread
+        struct Stats {
+            std::atomic<std::size_t> m_players{ 0 };
+            std::atomic<std::size_t> m_worlds{ 0 };
+            std::atomic<std::size_t> m_worlds_memory{ 0 };
+            std::atomic<std::size_t> m_queue_depth{ 0 };
+        };
+        [[nodiscard]] const Stats& GetStats() const { return m_stats; }
         
     public:
         std::shared_ptr<World> GetWorld(const std::string& name) {
@@ -91,6 +126,8 @@ namespace GTServer {
         int user_id{ 0 };
 
         std::atomic<bool> m_running{ false };
+        std::atomic<bool> m_accepting{ true };
+        std::atomic<bool> m_shutdown_notice{ false };
         std::vector<std::thread> m_threads{};
         
     private:
@@ -98,6 +135,31 @@ namespace GTServer {
         std::shared_ptr<EventPool> m_events;
 
         std::deque<ServerQueue> m_queue_worker{};
+        Stats m_stats{};
+
+        // packets held back by a player's rate limiter until their token is available
+        struct DelayedPacket {
+            std::shared_ptr<Server> m_server;
+            uint32_t m_connect_id;
+            ENetPacket* m_packet;
+            steady_clock::time_point m_ready_at;
+        };
+        std::vector<DelayedPacket> m_delayed_packets{};
+        ConnectionLimiter m_connection_limiter{};
+
+        std::unique_ptr<LoginPipeline> m_login_pipeline;
+
+        mutable std::mutex m_session_mutex{};
+        std::unordered_map<uint32_t, std::weak_ptr<Player>> m_sessions{};
+
+    private:
+        std::array<LatencyHistogram*, NUM_QUEUE_TYPES> m_queue_latency{};
+        LatencyHistogram* m_service_latency;
+        Counter* m_connects;
+        Counter* m_disconnects;
+        Counter* m_received_packets;
+        Counter* m_rejected_connects;
+        Counter* m_slow_disconnects;
 
     public:
         std::unordered_map<dpp::snowflake, std::pair<uint32_t, TimingClock>> m_account_verify{};
@@ -0,0 +1,150 @@
+#include <server/startup.h>
+#include <algorithm>
+#include <exception>
+#include <unordered_map>
+#include <fmt/chrono.h>
+
+namespace GTServer {
+    Startup::~Startup() {
+        this->Wait();
+    }
+
+    void Startup::AddStage(const std::string& name, const std::vector<std::string>& dependencies, std::function<bool()> fn, const uint8_t& flags) {
+        m_stages.push_back(Stage{ name, std::move(fn), flags });
+        m_dependency_names.push_back(dependencies);
+    }
+
+    bool Startup::Run(std::size_t workers) {
+        if (!this->Resolve())
+            return false;
+        m_started_at = steady_clock::now();
+        {
+            std::scoped_lock lock{ m_mutex };
+            m_stages_left = m_stages.size();
+            m_blocking_left = static_cast<std::size_t>(std::count_if(m_stages.begin(), m_stages.end(), [this](const Stage& stage) { return this->IsBlocking(stage); }));
+            for (std::size_t index = 0; index < m_stages.size(); ++index) {
+                if (m_stages[index].m_remaining == 0)
+                    m_ready.push_back(index);
+            }
+        }
+        workers = std::clamp<std::size_t>(workers, 1, std::max<std::size_t>(m_stages.size(), 1));
+        for (std::size_t i = 0; i < workers; ++i)
+            m_threads.push_back(std::thread{ &Startup::WorkerThread, this });
+
+        std::unique_lock lock{ m_mutex };
+        m_condition.wait(lock, [this] { return m_blocking_left == 0; });
+        fmt::print(" - startup stages done in {}, {} deferred stages still running\n",
+            std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now() - m_started_at), m_stages_left);
+        return !m_failed;
+    }
+    void Startup::Wait() {
+        {
+            std::unique_lock lock{ m_mutex };
+            m_condition.wait(lock, [this] { return m_stages_left == 0; });
+        }
+        for (auto& thread : m_threads) {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_threads.clear();
+    }
+
+    bool Startup::Resolve() {
+        std::unordered_map<std::string, std::size_t> indices{};
+        for (std::size_t index = 0; index < m_stages.size(); ++index)
+            indices.insert_or_assign(m_stages[index].m_name, index);
+
+        for (std::size_t index = 0; index < m_stages.size(); ++index) {
+            Stage& stage{ m_stages[index] };
+            for (const auto& name : m_dependency_names[index]) {
+                auto it{ indices.find(name) };
+                if (it == indices.end()) {
+                    fmt::print("Startup -> stage {} depends on unknown stage {}\n", stage.m_name, name);
+                    return false;
+                }
+                if (this->IsBlocking(stage) && !this->IsBlocking(m_stages[it->second])) {
+                    fmt::print("Startup -> stage {} can't wait for deferred stage {}\n", stage.m_name, name);
+                    return false;
+                }
+                stage.m_dependencies.push_back(it->second);
+                m_stages[it->second].m_dependents.push_back(index);
+            }
+            stage.m_remaining = stage.m_dependencies.size();
+        }
+
+        // every stage has to be reachable, otherwise there is a cycle and Run() would never return
+        std::vector<std::size_t> remaining{}, queue{};
+        for (const auto& stage : m_stages)
+            remaining.push_back(stage.m_remaining);
+        for (std::size_t index = 0; index < m_stages.size(); ++index) {
+            if (remaining[index] == 0)
+                queue.push_back(index);
+        }
+        for (std::size_t visited = 0; visited < queue.size(); ++visited) {
+            for (const auto& dependent : m_stages[queue[visited]].m_dependents) {
+                if (--remaining[dependent] == 0)
+                    queue.push_back(dependent);
+            }
+        }
+        if (queue.size() != m_stages.size()) {
+            fmt::print("Startup -> dependency cycle between startup stages\n");
+            return false;
+        }
+        return true;
+    }
+    void Startup::Finish(const std::size_t& index, const eStageState& state) {
+        Stage& stage{ m_stages[index] };
+        stage.m_state = state;
+        if (state != STAGE_STATE_DONE && (stage.m_flags & STAGE_FLAG_REQUIRED))
+            m_failed = true;
+        for (const auto& dependent : stage.m_dependents) {
+            if (--m_stages[dependent].m_remaining == 0)
+                m_ready.push_back(dependent);
+        }
+        if (this->IsBlocking(stage))
+            --m_blocking_left;
+        --m_stages_left;
+        m_condition.notify_all();
+    }
+    void Startup::WorkerThread() {
+        while (true) {
+            std::size_t index{};
+            {
+                std::unique_lock lock{ m_mutex };
+                m_condition.wait(lock, [this] { return !m_ready.empty() || m_stages_left == 0; });
+                if (m_ready.empty())
+                    return;
+                index = m_ready.front();
+                m_ready.pop_front();
+
+                Stage& stage{ m_stages[index] };
+                const bool skip{ m_failed || std::any_of(stage.m_dependencies.begin(), stage.m_dependencies.end(),
+                    [this](const std::size_t& dependency) { return m_stages[dependency].m_state != STAGE_STATE_DONE; }) };
+                if (skip) {
+                    fmt::print(" - startup stage {} skipped\n", stage.m_name);
+                    this->Finish(index, STAGE_STATE_SKIPPED);
+                    continue;
+                }
+                stage.m_state = STAGE_STATE_RUNNING;
+            }
+
+            Stage& stage{ m_stages[index] };
+            LatencyHistogram& latency{ Metrics::Get().GetHistogram("gtserver_startup_stage_duration_seconds", "Time spent in each startup stage",
+                fmt::format("stage=\"{}\"", stage.m_name)) };
+            const steady_clock::time_point started_at{ steady_clock::now() };
+            bool result{ false };
+            try {
+                result = stage.m_fn();
+            } catch (const std::exception& e) {
+                fmt::print("Startup -> stage {} threw, {}\n", stage.m_name, e.what());
+            }
+            const auto duration{ steady_clock::now() - started_at };
+            latency.Record(duration);
+            fmt::print(" - startup stage {} {} in {}\n", stage.m_name, result ? "finished" : "failed",
+                std::chrono::duration_cast<std::chrono::milliseconds>(duration));
+
+            std::scoped_lock lock{ m_mutex };
+            this->Finish(index, result ? STAGE_STATE_DONE : STAGE_STATE_FAILED);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <server/metrics.h>
+#include <utils/timing_clock.h>
+
+namespace GTServer {
+    // startup stages with their dependencies, independent stages run in parallel on a small pool of workers.
+    // Run() returns once every blocking stage is done, deferred stages (caches players don't need to log in)
+    // keep running in the background while the ports are already open.
+    class Startup {
+    public:
+        enum eStageFlags {
+            STAGE_FLAG_NONE = 0,
+            STAGE_FLAG_REQUIRED = 1 << 0, // a failure aborts the startup
+            STAGE_FLAG_DEFERRED = 1 << 1  // Run() does not wait for it
+        };
+        enum eStageState {
+            STAGE_STATE_PENDING,
+            STAGE_STATE_RUNNING,
+            STAGE_STATE_DONE,
+            STAGE_STATE_FAILED,
+            STAGE_STATE_SKIPPED
+        };
+
+    public:
+        Startup() = default;
+        ~Startup();
+
+        void AddStage(const std::string& name, const std::vector<std::string>& dependencies, std::function<bool()> fn, const uint8_t& flags = STAGE_FLAG_REQUIRED);
+        // false if a required stage failed or the graph is invalid, nothing that depends on a failed stage is run
+        bool Run(std::size_t workers = std::thread::hardware_concurrency());
+        // blocks until the deferred stages are done as well
+        void Wait();
+
+    private:
+        struct Stage {
+            std::string m_name;
+            std::function<bool()> m_fn;
+            uint8_t m_flags;
+            std::vector<std::size_t> m_dependencies{};
+            std::vector<std::size_t> m_dependents{};
+            std::size_t m_remaining{ 0 };
+            eStageState m_state{ STAGE_STATE_PENDING };
+        };
+
+        bool Resolve();
+        void Finish(const std::size_t& index, const eStageState& state);
+        void WorkerThread();
+
+        [[nodiscard]] bool IsBlocking(const Stage& stage) const { return !(stage.m_flags & STAGE_FLAG_DEFERRED); }
+
+    private:
+        std::vector<Stage> m_stages{};
+        std::vector<std::vector<std::string>> m_dependency_names{};
+
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        std::deque<std::size_t> m_ready{};
+        std::size_t m_blocking_left{ 0 };
+        std::size_t m_stages_left{ 0 };
+        bool m_failed{ false };
+
+        std::vector<std::thread> m_threads{};
+        steady_clock::time_point m_started_at{};
+    };
+}
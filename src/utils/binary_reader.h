@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace GTServer
@@ -39,6 +40,13 @@ namespace GTServer
             std::string val = std::string(reinterpret_cast<char*>(m_data + m_pos), len);
             this->m_pos += len;
             return val;
+        }
+        // view into the reader's buffer, only valid as long as the reader lives
+        std::string_view read_string_view() {
+            const uint16_t len{ this->read<uint16_t>() };
+            std::string_view val{ reinterpret_cast<char*>(m_data + m_pos), len };
+            this->m_pos += len;
+            return val;
         }
 		void read(std::string& val) {
             const uint16_t& len{ this->read<uint16_t>() };
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace GTServer
@@ -34,6 +35,12 @@ namespace GTServer
 			std::memcpy(m_data + m_pos + data_length_size, val.c_str(), len);
 			m_pos += len + data_length_size;
 		}
+        void write(const std::string_view& val, const std::size_t& data_length_size = 2) {
+			std::size_t len{ val.length() };
+			std::memcpy(m_data + m_pos, &len, data_length_size);
+			std::memcpy(m_data + m_pos + data_length_size, val.data(), len);
+			m_pos += len + data_length_size;
+		}
 		void write(const uint8_t* val, const std::size_t& len) {
 			std::memcpy(m_data + m_pos, val, len);
 			m_pos += len;
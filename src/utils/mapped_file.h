@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace GTServer {
+    // private copy-on-write mapping of a whole file, pages are only read from disk when touched
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { this->Close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string& path) {
+            this->Close();
+#ifdef _WIN32
+            HANDLE file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                CloseHandle(file);
+                return false;
+            }
+            HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr) };
+            CloseHandle(file);
+            if (!mapping)
+                return false;
+            void* data{ MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) };
+            CloseHandle(mapping);
+            if (!data)
+                return false;
+            m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+            const int file{ open(path.c_str(), O_RDONLY) };
+            if (file == -1)
+                return false;
+            struct stat info{};
+            if (fstat(file, &info) != 0 || info.st_size == 0) {
+                close(file);
+                return false;
+            }
+            void* data{ mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0) };
+            close(file);
+            if (data == MAP_FAILED)
+                return false;
+            m_size = static_cast<std::size_t>(info.st_size);
+#endif
+            m_data = static_cast<uint8_t*>(data);
+            return true;
+        }
+        void Close() {
+            if (!m_data)
+                return;
+#ifdef _WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(m_data, m_size);
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        [[nodiscard]] bool IsOpen() const { return m_data != nullptr; }
+        [[nodiscard]] uint8_t* GetData() const { return m_data; }
+        [[nodiscard]] std::size_t GetSize() const { return m_size; }
+
+    private:
+        uint8_t* m_data{ nullptr };
+        std::size_t m_size{ 0 };
+    };
+}
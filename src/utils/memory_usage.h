@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+// heap estimates for the standard containers, node based containers are counted as node + bucket pointer
+namespace GTServer::MemoryUsage {
+    inline std::size_t of(const std::string& str) {
+        static const std::size_t sso_capacity{ std::string{}.capacity() };
+        return str.capacity() > sso_capacity ? str.capacity() + 1 : 0;
+    }
+    template <typename T>
+    inline std::size_t of(const std::vector<T>& vec) {
+        return vec.capacity() * sizeof(T);
+    }
+    template <typename K, typename V, typename... Args>
+    inline std::size_t of(const std::unordered_map<K, V, Args...>& map) {
+        return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(std::pair<const K, V>) + sizeof(void*) + sizeof(std::size_t));
+    }
+
+    inline std::size_t get_process_rss() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return static_cast<std::size_t>(counters.WorkingSetSize);
+#else
+        std::ifstream file{ "/proc/self/statm" };
+        std::size_t pages{ 0 }, resident{ 0 };
+        if (!(file >> pages >> resident))
+            return 0;
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+}
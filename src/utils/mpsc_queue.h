@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace GTServer {
+    // unbounded lock-free queue for many producers and a single consumer (Vyukov's node based queue).
+    // Push() is one exchange so producers never wait on each other, Pop() must only be called by the consumer.
+    template <typename T>
+    class MpscQueue {
+    public:
+        MpscQueue() : m_head{ &m_stub }, m_tail{ &m_stub } {}
+        ~MpscQueue() {
+            T value{};
+            while (this->Pop(value)) {}
+        }
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        void Push(T value) {
+            Node* node{ new Node{ std::move(value) } };
+            this->PushNode(node);
+            m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        // false if the queue is empty or a producer is halfway through a push, that item shows up on the next call
+        bool Pop(T& value) {
+            Node* tail{ m_tail };
+            Node* next{ tail->m_next.load(std::memory_order_acquire) };
+            if (tail == &m_stub) {
+                if (!next)
+                    return false;
+                m_tail = next;
+                tail = next;
+                next = next->m_next.load(std::memory_order_acquire);
+            }
+            if (!next) {
+                if (tail != m_head.load(std::memory_order_acquire))
+                    return false;
+                this->PushNode(&m_stub);
+                next = tail->m_next.load(std::memory_order_acquire);
+                if (!next)
+                    return false;
+            }
+            m_tail = next;
+            value = std::move(tail->m_value);
+            delete tail;
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        [[nodiscard]] bool IsEmpty() const { return m_size.load(std::memory_order_relaxed) == 0; }
+        [[nodiscard]] std::size_t GetSize() const { return m_size.load(std::memory_order_relaxed); }
+
+    private:
+        struct Node {
+            T m_value{};
+            std::atomic<Node*> m_next{ nullptr };
+        };
+
+        void PushNode(Node* node) {
+            node->m_next.store(nullptr, std::memory_order_relaxed);
+            Node* previous{ m_head.exchange(node, std::memory_order_acq_rel) };
+            previous->m_next.store(node, std::memory_order_release);
+        }
+
+    private:
+        Node m_stub{};
+        std::atomic<Node*> m_head;
+        Node* m_tail;
+        std::atomic<std::size_t> m_size{ 0 };
+    };
+}
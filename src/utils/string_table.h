@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace GTServer {
+    // append-only interning table, equal strings share one copy and views stay valid until Clear()
+    class StringTable {
+    public:
+        StringTable() = default;
+        ~StringTable() = default;
+        StringTable(const StringTable&) = delete;
+        StringTable& operator=(const StringTable&) = delete;
+
+        std::string_view Intern(const std::string_view& str) {
+            if (str.empty())
+                return std::string_view{};
+            if (auto it = m_strings.find(str); it != m_strings.end())
+                return *it;
+
+            if (m_blocks.empty() || m_block_pos + str.size() > m_block_size) {
+                m_block_size = std::max(BLOCK_SIZE, str.size());
+                m_blocks.push_back(std::make_unique<char[]>(m_block_size));
+                m_block_pos = 0;
+            }
+            char* data{ m_blocks.back().get() + m_block_pos };
+            std::memcpy(data, str.data(), str.size());
+            m_block_pos += str.size();
+            m_used += str.size();
+            return *m_strings.emplace(data, str.size()).first;
+        }
+        void Clear() {
+            m_strings.clear();
+            m_blocks.clear();
+            m_block_pos = 0;
+            m_block_size = 0;
+            m_used = 0;
+        }
+
+        [[nodiscard]] std::size_t GetSize() const { return m_strings.size(); }
+        [[nodiscard]] std::size_t GetUsedBytes() const { return m_used; }
+        [[nodiscard]] std::size_t GetMemoryUsage() const {
+            std::size_t ret{ m_blocks.capacity() * sizeof(std::unique_ptr<char[]>) };
+            ret += (m_blocks.size() > 1 ? (m_blocks.size() - 1) * BLOCK_SIZE : 0) + m_block_size;
+            ret += m_strings.bucket_count() * sizeof(void*) + m_strings.size() * (sizeof(std::string_view) + sizeof(void*) + sizeof(std::size_t));
+            return ret;
+        }
+
+    private:
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> m_blocks{};
+        std::size_t m_block_pos{ 0 };
+        std::size_t m_block_size{ 0 };
+        std::size_t m_used{ 0 };
+        std::unordered_set<std::string_view> m_strings{};
+    };
+}
@@ -156,7 +156,7 @@ namespace GTServer {
         m_parent = parent;
     }
         
-    ItemInfo* Tile::GetBaseItem() {
+    ItemInfo* Tile::GetBaseItem() const {
         return ItemDatabase::GetItem(m_foreground != 0 ? m_foreground : m_background);
     }
     void Tile::RemoveBase() {
@@ -189,7 +189,7 @@ namespace GTServer {
         m_flags &= ~flag;
     }
 
-    std::size_t Tile::GetMemoryUsage(const bool& to_database) {
+    std::size_t Tile::GetMemoryUsage(const bool& to_database) const {
         ItemInfo* item = this->GetBaseItem();
         if (!item)
             return 0;
@@ -282,7 +282,7 @@ namespace GTServer {
         }
         return ret;
     }
-    void Tile::Pack(BinaryWriter& buffer, const bool& to_database) {
+    void Tile::Pack(BinaryWriter& buffer, const bool& to_database) const {
         ItemInfo* item = this->GetBaseItem();
         if (!item)
             return;
@@ -26,7 +26,7 @@ namespace GTServer {
         void SetParent(const uint16_t& parent);
         [[nodiscard]] uint16_t GetParent() const { return m_parent; }
         
-        ItemInfo* GetBaseItem();
+        ItemInfo* GetBaseItem() const;
         void RemoveBase();
         
         bool IsFlagOn(const eTileFlags& flag) const;
@@ -49,8 +49,10 @@ namespace GTServer {
         void ApplyLockOwner(const uint32_t& uid);
 
     public:
-        std::size_t GetMemoryUsage(const bool& to_database);
-        void Pack(BinaryWriter& buffer, const bool& to_database);
+        std::size_t GetMemoryUsage(const bool& to_database) const;
+        // heap owned by the tile itself, the extra data is reported by GetExtraMemoryUsage
+        std::size_t GetResidentMemoryUsage() const { return MemoryUsage::of(m_DevBreak); }
+        void Pack(BinaryWriter& buffer, const bool& to_database) const;
         void Serialize(BinaryReader& br);
 
     private:
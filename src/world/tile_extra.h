@@ -6,6 +6,7 @@
 #include <utils/random.h>
 #include <utils/color.h>
 #include <utils/timing_clock.h>
+#include <utils/memory_usage.h>
 
 namespace GTServer {
     class TileExtra {
@@ -78,26 +79,36 @@ namespace GTServer {
         uint32_t GetCycleTime() const { return m_cycle_time; }
 
         Color& GetPrimaryColor() { return m_primary_color; }
+        const Color& GetPrimaryColor() const { return m_primary_color; }
         Color& GetSecondaryColor() { return m_secondary_color; }
+        const Color& GetSecondaryColor() const { return m_secondary_color; }
 
         std::vector<uint32_t>& GetAccessList();
+        const std::vector<uint32_t>& GetAccessList() const { return m_uint_array; }
         bool HasAccess(const uint32_t& uid) const;
         bool AddAccess(const uint32_t& uid);
         bool RemoveAccess(const uint32_t& uid);
         void ClearAccess();
 
         std::vector<uint32_t>& GetWeatherList();
+        const std::vector<uint32_t>& GetWeatherList() const { return m_uint_array; }
         bool HasWeather(uint32_t item_id);
         bool AddWeather(uint32_t item_id);
         bool EraseWeather(uint32_t item_id);
         void ClearWeather();
 
+        std::size_t GetExtraMemoryUsage() const {
+            return MemoryUsage::of(m_label) + MemoryUsage::of(m_destination) + MemoryUsage::of(m_door_unique_id)
+                + MemoryUsage::of(m_password) + MemoryUsage::of(m_uint_array);
+        }
+
         void SetCloth(const uint8_t& body_part, const uint16_t& id) {
             if (body_part < 0 || body_part > NUM_BODY_PARTS)
                 return;
             this->m_clothes[body_part] = id;
         }
         uint16_t& GetCloth(const uint8_t& body_part) { return this->m_clothes[body_part]; }
+        uint16_t GetCloth(const uint8_t& body_part) const { return this->m_clothes[body_part]; }
         std::array<uint16_t, NUM_BODY_PARTS>& GetClothes() { return this->m_clothes; }
 
         int32_t GetTempo() const { return m_tempo; }
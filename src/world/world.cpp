@@ -1,19 +1,27 @@
 #include <world/world.h>
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 #include <algorithm/algorithm.h>
 #include <database/item/item_component.h>
 #include <database/item/item_database.h>
+#include <proton/game_packet.h>
+#include <config.h>
+#include <server/metrics.h>
 #include <utils/binary_writer.h>
 #include <utils/random.h>
 
 namespace GTServer {
+    // shared across worlds so a reloaded world never reuses the version of its previous instance
+    std::atomic<uint64_t> g_content_version{ 0 };
+
     World::World(const std::string& name, const uint32_t& width, const uint32_t& height) :
         m_flags{ 0 },
         m_name{ name },
         m_width(width),
         m_height(height),
-        m_net_id{ 0 } {
+        m_net_id{ 0 },
+        m_content_version{ ++g_content_version } {
 
     }
     World::~World() {
@@ -29,6 +37,11 @@ namespace GTServer {
             [&](const auto& p) { return p.second->GetUserId() == player->GetUserId(); });
         if (it != m_players.end())
             m_players.erase(it);
+        m_movement_interest.erase(player->GetNetId());
+        if (auto cell = m_player_cells.find(player->GetNetId()); cell != m_player_cells.end()) {
+            std::erase(m_cell_players[cell->second], player->GetNetId());
+            m_player_cells.erase(cell);
+        }
     }
     uint32_t World::DevPunchAdd(const std::shared_ptr<Player>& player) {
         m_DevBreak.insert_or_assign(++m_net_id, player);
@@ -93,6 +106,94 @@ namespace GTServer {
         for (const auto& [net_id, player] : m_players)
             func(player);
     }
+    void World::BroadcastMovement(const std::shared_ptr<Player>& sender, GameUpdatePacket* packet) {
+        static Counter& sent{ Metrics::Get().GetCounter("gtserver_movement_updates_total", "Movement updates per receiver by result", "result=\"sent\"") };
+        static Counter& skipped{ Metrics::Get().GetCounter("gtserver_movement_updates_total", "Movement updates per receiver by result", "result=\"skipped\"") };
+        static Counter& congested{ Metrics::Get().GetCounter("gtserver_movement_updates_total", "Movement updates per receiver by result", "result=\"congested\"") };
+
+        this->UpdatePlayerCell(sender);
+        // the echo is as disposable as everyone else's copy, the client already knows where it is
+        if (sender->IsCongested())
+            congested.Increase();
+        else
+            sender->SendPacket(NET_MESSAGE_GAME_PACKET, packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE_SEQUENCED);
+
+        const CL_Vec2i cells{ this->GetInterestCellCount() };
+        auto& interest{ m_movement_interest[sender->GetNetId()] };
+        interest.resize(m_cell_players.size());
+
+        const auto now{ steady_clock::now() };
+        const CL_Vec2f position{ packet->m_pos_x, packet->m_pos_y };
+        const uint32_t flags{ static_cast<uint32_t>(packet->m_flags) };
+        const bool moving{ packet->m_velocity_x != 0.f || packet->m_velocity_y != 0.f };
+        const uint32_t origin{ m_player_cells[sender->GetNetId()] };
+        // one decision per occupied cell, only the players of the cells it's forwarded to are looked at
+        for (uint32_t cell = 0; cell < m_cell_players.size(); ++cell) {
+            const auto& players{ m_cell_players[cell] };
+            if (players.empty() || (players.size() == 1 && cell == origin))
+                continue;
+            const uint32_t distance{ static_cast<uint32_t>(std::max(
+                std::abs(static_cast<int>(cell % cells.m_x) - static_cast<int>(origin % cells.m_x)),
+                std::abs(static_cast<int>(cell / cells.m_x) - static_cast<int>(origin / cells.m_x)))) };
+            MovementInterest& last{ interest[cell] };
+            // a change of state (flags, starting or stopping) always goes out, so nobody is left with a player
+            // frozen mid-run at a position it skipped past
+            bool forward{ distance <= config::interest::near_cells || last.m_flags != flags || last.m_moving != moving };
+            if (!forward) {
+                const bool mid{ distance <= config::interest::mid_cells };
+                const float delta{ std::max(std::abs(position.m_x - last.m_position.m_x), std::abs(position.m_y - last.m_position.m_y)) };
+                forward = now - last.m_sent_at >= (mid ? config::interest::mid_interval : config::interest::far_interval) &&
+                    delta >= (mid ? config::interest::mid_delta : config::interest::far_delta);
+            }
+            if (!forward) {
+                skipped.Increase(players.size());
+                continue;
+            }
+            last = MovementInterest{ now, position, flags, moving };
+            for (const auto& net_id : players) {
+                auto it{ m_players.find(net_id) };
+                if (it == m_players.end() || it->second == sender)
+                    continue;
+                // the next update supersedes this one, a peer that can't keep up is sent everyone's position once it has caught up
+                if (it->second->IsCongested()) {
+                    congested.Increase();
+                    continue;
+                }
+                it->second->SendPacket(NET_MESSAGE_GAME_PACKET, packet, sizeof(GameUpdatePacket), DELIVERY_UNRELIABLE_SEQUENCED);
+                sent.Increase();
+            }
+        }
+    }
+    void World::SendPositions(const std::shared_ptr<Player>& receiver) {
+        for (const auto& [net_id, player] : m_players) {
+            if (player == receiver)
+                continue;
+            receiver->v_sender.OnSetPos(player->GetNetId(), CL_Vec2f{ static_cast<float>(player->GetPosition().m_x), static_cast<float>(player->GetPosition().m_y) });
+        }
+    }
+    void World::UpdatePlayerCell(const std::shared_ptr<Player>& player) {
+        const CL_Vec2i cells{ this->GetInterestCellCount() };
+        m_cell_players.resize(static_cast<std::size_t>(cells.m_x) * cells.m_y);
+        const uint32_t cell{ this->GetInterestCell(player->GetPosition()) };
+        auto [it, inserted]{ m_player_cells.try_emplace(player->GetNetId(), cell) };
+        if (!inserted) {
+            if (it->second == cell)
+                return;
+            std::erase(m_cell_players[it->second], player->GetNetId());
+            it->second = cell;
+        }
+        m_cell_players[cell].push_back(player->GetNetId());
+    }
+    CL_Vec2i World::GetInterestCellCount() const {
+        const uint32_t size{ config::interest::cell_size };
+        return CL_Vec2i{ static_cast<int>((m_width + size - 1) / size), static_cast<int>((m_height + size - 1) / size) };
+    }
+    uint32_t World::GetInterestCell(const CL_Vec2i& position) const {
+        const CL_Vec2i cells{ this->GetInterestCellCount() };
+        const int size{ static_cast<int>(config::interest::cell_size) * 32 };
+        const int x{ std::clamp(position.m_x / size, 0, cells.m_x - 1) }, y{ std::clamp(position.m_y / size, 0, cells.m_y - 1) };
+        return static_cast<uint32_t>(y * cells.m_x + x);
+    }
 
     bool World::IsFlagOn(const eWorldFlags& flag) const {
         if (m_flags & flag)
@@ -101,9 +202,11 @@ namespace GTServer {
     }
     void World::SetFlag(const eWorldFlags& flag) {
         m_flags |= flag;
+        m_journal_meta = true;
     }
     void World::RemoveFlag(const eWorldFlags& flag) {
         m_flags &= ~flag;
+        m_journal_meta = true;
     }
     void World::SpawnEvent(const std::string& eventname) {
         std::random_device rd;
@@ -463,54 +566,36 @@ namespace GTServer {
         size += (m_objects.size() * (sizeof(uint32_t) + sizeof(WorldObject)));
         return size;
     }
-    std::vector<uint8_t> World::Pack() {
-        const auto& alloc = this->GetMemoryUsage();
-        std::vector<uint8_t> ret{};
-        ret.resize(alloc);
-
-        BinaryWriter buffer{ ret.data() };
-        buffer.write<uint16_t>(m_version);
-        buffer.write<uint32_t>(m_flags);
-        buffer.write(m_name, sizeof(uint16_t));
-        buffer.write<uint32_t>(m_width);
-        buffer.write<uint32_t>(m_height);
- 
-        auto tiles{ this->PackTiles(false) };
-        buffer.write(tiles.data(), tiles.size());
-        auto objects{ this->PackObjects(false) };
-        buffer.write(objects.data(), objects.size());
-
-        buffer.write<uint32_t>(this->GetBaseWeatherId());
-        buffer.write<uint32_t>(this->GetWeatherId());
+    World::MemoryBreakdown World::GetMemoryBreakdown() {
+        MemoryBreakdown ret{};
+        ret.m_tiles = sizeof(World) + MemoryUsage::of(m_name) + MemoryUsage::of(m_tiles);
+        for (const auto& tile : m_tiles) {
+            ret.m_tiles += tile.GetResidentMemoryUsage();
+            ret.m_extras += tile.GetExtraMemoryUsage();
+        }
+        {
+            // pages still referenced by an older snapshot are owned by that snapshot
+            std::scoped_lock lock{ m_dirty_mutex };
+            ret.m_tiles += MemoryUsage::of(m_snapshot_pages);
+            for (const auto& page : m_snapshot_pages) {
+                if (page)
+                    ret.m_tiles += sizeof(WorldSnapshot::Page) + MemoryUsage::of(page->m_tiles);
+            }
+        }
+        ret.m_objects = MemoryUsage::of(m_objects);
+        ret.m_players = MemoryUsage::of(m_players) + MemoryUsage::of(m_DevBreak) + MemoryUsage::of(m_banned_players);
+        // map data is packed on demand and handed straight to enet, nothing is kept per world yet
+        ret.m_cached_packets = 0;
         return ret;
     }
+    std::vector<uint8_t> World::Pack() {
+        return this->CreateSnapshot()->Pack();
+    }
     std::vector<uint8_t> World::PackTiles(const bool& to_database) {
-        std::vector<uint8_t> ret{};
-        ret.resize(this->GetTilesMemoryUsage(to_database));
-
-        BinaryWriter buffer{ ret.data() };
-        buffer.write<uint32_t>(static_cast<uint32_t>(m_tiles.size()));
-        for (auto& tile : m_tiles)
-            tile.Pack(buffer, to_database);
-
-        return ret;
+        return this->CreateSnapshot()->PackTiles(to_database);
     }
     std::vector<uint8_t> World::PackObjects(const bool& to_database) {
-        std::vector<uint8_t> ret{};
-        ret.resize(this->GetObjectsMemoryUsage());
-
-        BinaryWriter buffer{ ret.data() };
-        buffer.write<uint32_t>(static_cast<uint32_t>(m_objects.size()));
-        buffer.write<uint32_t>(m_object_id - (to_database ? 0 : 1));
-        for (auto& [id, object] : m_objects) {
-            buffer.write<uint16_t>(object.m_item_id);
-            buffer.write<CL_Vec2f>(object.m_pos);
-            buffer.write<uint8_t>(object.m_item_amount);
-            buffer.write<uint8_t>(object.m_flags);
-            buffer.write<uint32_t>(id);
-        }
-
-        return ret;
+        return this->CreateSnapshot()->PackObjects(to_database);
     }
     
     void World::SyncPlayerData(std::shared_ptr<Player> player) {
@@ -522,52 +607,173 @@ namespace GTServer {
             ply->v_sender.OnSetClothing(player->GetClothes(), player->GetSkinColor(), false, player->GetNetId());
         });
     }
-    void World::SendTileUpdate(Tile* tile, const int32_t& delay) {
-        std::size_t alloc = tile->GetMemoryUsage(false);
-        GameUpdatePacket* update_packet = (GameUpdatePacket*)std::malloc(sizeof(GameUpdatePacket) + alloc);
-        if (!update_packet)
+    CL_Vec2i World::GetChunkCount() const {
+        return CL_Vec2i{ 
+            static_cast<int>((m_width + RENDER_CHUNK_SIZE - 1) / RENDER_CHUNK_SIZE), 
+            static_cast<int>((m_height + RENDER_CHUNK_SIZE - 1) / RENDER_CHUNK_SIZE) 
+        };
+    }
+    void World::MarkDirty(const CL_Vec2i& position) {
+        if (position.m_x < 0 || position.m_y < 0 || position.m_x >= static_cast<int>(m_width) || position.m_y >= static_cast<int>(m_height))
             return;
-        std::memset(update_packet, 0, sizeof(GameUpdatePacket) + alloc);
+        const CL_Vec2i chunks = this->GetChunkCount(); {
+            std::scoped_lock lock{ m_dirty_mutex };
+            // snapshots taken so far keep the old page, the next one copies the chunk again
+            const std::size_t chunk = (position.m_y / RENDER_CHUNK_SIZE) * chunks.m_x + (position.m_x / RENDER_CHUNK_SIZE);
+            if (chunk < m_snapshot_pages.size())
+                m_snapshot_pages[chunk].reset();
+            m_journal_tiles.insert(position.m_y * m_width + position.m_x);
+        }
+        m_content_version = ++g_content_version;
+    }
+    void World::MarkDirty() {
+        {
+            std::scoped_lock lock{ m_dirty_mutex };
+            m_snapshot_pages.clear();
+            m_journal_meta = true;
+        }
+        m_content_version = ++g_content_version;
+    }
+    std::shared_ptr<const WorldSnapshot> World::CreateSnapshot() {
+        auto ret{ std::make_shared<WorldSnapshot>() };
+        ret->m_id = m_id;
+        ret->m_version = m_version;
+        ret->m_flags = m_flags;
+        ret->m_name = m_name;
+        ret->m_width = m_width;
+        ret->m_height = m_height;
+        ret->m_chunks = this->GetChunkCount();
+        ret->m_content_version = m_content_version.load();
+        ret->m_tile_count = m_tiles.size();
+        ret->m_object_id = m_object_id;
+        ret->m_owner_id = m_owner_id;
+        ret->m_main_lock = m_main_lock;
+        ret->m_weather_id = m_weather_id;
+        ret->m_base_weather_id = m_base_weather_id;
+
+        const CL_Vec2i& chunks{ ret->m_chunks };
+        std::scoped_lock lock{ m_dirty_mutex };
+        m_snapshot_pages.resize(chunks.m_x * chunks.m_y);
+        for (int chunk_y = 0; chunk_y < chunks.m_y; ++chunk_y) {
+            for (int chunk_x = 0; chunk_x < chunks.m_x; ++chunk_x) {
+                auto& page{ m_snapshot_pages[chunk_y * chunks.m_x + chunk_x] };
+                if (page)
+                    continue;
+                const uint32_t left{ chunk_x * RENDER_CHUNK_SIZE }, top{ chunk_y * RENDER_CHUNK_SIZE };
+                const uint32_t right{ std::min(left + RENDER_CHUNK_SIZE, m_width) }, bottom{ std::min(top + RENDER_CHUNK_SIZE, m_height) };
+
+                auto new_page{ std::make_shared<WorldSnapshot::Page>() };
+                new_page->m_width = right - left;
+                new_page->m_tiles.reserve(new_page->m_width * (bottom - top));
+                for (uint32_t y = top; y < bottom; ++y) {
+                    for (uint32_t x = left; x < right; ++x) {
+                        const std::size_t index{ static_cast<std::size_t>(y) * m_width + x };
+                        new_page->m_tiles.push_back(index < m_tiles.size() ? m_tiles[index] : Tile{});
+                    }
+                }
+                page = std::move(new_page);
+            }
+        }
+        ret->m_pages = m_snapshot_pages;
+        if (!m_snapshot_objects)
+            m_snapshot_objects = std::make_shared<const std::unordered_map<int32_t, WorldObject>>(m_objects);
+        ret->m_objects = m_snapshot_objects;
+        return ret;
+    }
 
-        update_packet->m_type = NET_GAME_PACKET_SEND_TILE_UPDATE_DATA;
-        update_packet->m_int_x = tile->GetPosition().m_x;
-        update_packet->m_int_y = tile->GetPosition().m_y;
-        update_packet->m_net_id = -1;
-        update_packet->m_delay = delay;
-        update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-        update_packet->m_data_size = alloc;
+    void World::MarkObjectDirty(const int32_t& object_id) {
+        std::scoped_lock lock{ m_dirty_mutex };
+        m_snapshot_objects.reset();
+        m_journal_objects.insert(object_id);
+    }
+    World::JournalChanges World::TakeJournalChanges() {
+        JournalChanges ret{};
+        std::scoped_lock lock{ m_dirty_mutex };
+        ret.m_tiles.assign(m_journal_tiles.begin(), m_journal_tiles.end());
+        ret.m_objects.assign(m_journal_objects.begin(), m_journal_objects.end());
+        ret.m_meta = m_journal_meta;
+        m_journal_tiles.clear();
+        m_journal_objects.clear();
+        m_journal_meta = false;
+        return ret;
+    }
+
+    void World::SendTileUpdate(Tile* tile, const int32_t& delay) {
+        this->MarkDirty(tile->GetPosition());
+        if (delay == 0) {
+            m_tile_updates.insert(tile->GetPosition().m_y * m_width + tile->GetPosition().m_x);
+            return;
+        }
+        GamePacket packet{ NET_GAME_PACKET_SEND_TILE_UPDATE_DATA, tile->GetMemoryUsage(false) };
+        if (!packet.IsValid())
+            return;
+        packet->m_int_x = tile->GetPosition().m_x;
+        packet->m_int_y = tile->GetPosition().m_y;
+        packet->m_net_id = -1;
+        packet->m_delay = delay;
 
-        BinaryWriter buffer{ alloc };
+        BinaryWriter buffer{ packet.GetData() };
         tile->Pack(buffer, false);
-        std::memcpy(&update_packet->m_data, buffer.get(), buffer.get_pos());
 
-        this->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, update_packet, sizeof(GameUpdatePacket) + alloc); });
-        std::free(update_packet);
+        this->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(packet); });
     }
     void World::SendTileUpdate(std::vector<Tile*> tiles) {
-        std::size_t alloc{ sizeof(int32_t) };
         for (auto& tile : tiles)
-            alloc += sizeof(uint64_t) + tile->GetMemoryUsage(false);
-        GameUpdatePacket* update_packet = (GameUpdatePacket*)std::malloc(sizeof(GameUpdatePacket) + alloc);
-        if (!update_packet)
-            return;
-        std::memset(update_packet, 0, sizeof(GameUpdatePacket) + alloc);
-
-        update_packet->m_type = NET_GAME_PACKET_SEND_TILE_UPDATE_DATA_MULTIPLE;
-        update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-        update_packet->m_int_x = -1, update_packet->m_int_y = -1;
-        
-        BinaryWriter buffer{ alloc };
-        for (auto& tile : tiles) {
-            buffer.write<int>(tile->GetPosition().m_x);
-            buffer.write<int>(tile->GetPosition().m_y);
-            tile->Pack(buffer, false);
+            this->SendTileUpdate(tile, 0);
+    }
+    bool World::FlushTileUpdates() {
+        static Counter& delta_packets{ Metrics::Get().GetCounter("gtserver_tile_update_packets_total", "Batched tile update packets built, before fan-out to players") };
+        if (m_tile_updates.empty())
+            return true;
+        // grouped by chunk so neighbouring tiles end up in the same packet
+        const CL_Vec2i chunks = this->GetChunkCount();
+        std::vector<std::pair<uint32_t, uint32_t>> updates{};
+        updates.reserve(m_tile_updates.size());
+        std::size_t delta_size{ 0 };
+        for (const auto& index : m_tile_updates) {
+            if (index >= m_tiles.size())
+                continue;
+            const uint32_t x{ index % m_width }, y{ index / m_width };
+            updates.emplace_back((y / RENDER_CHUNK_SIZE) * chunks.m_x + (x / RENDER_CHUNK_SIZE), index);
+            delta_size += sizeof(int32_t) * 2 + m_tiles[index].GetMemoryUsage(false);
         }
-        buffer.write<int32_t>(-1);
-        std::memcpy(&update_packet->m_data, buffer.get(), buffer.get_pos());
+        m_tile_updates.clear();
+        if (updates.empty())
+            return true;
+        // every tile takes at least 8 bytes in the map data, only pack the world when the delta can be bigger
+        if (delta_size > m_tiles.size() * 8 && delta_size >= this->GetMemoryUsage())
+            return false;
+        std::sort(updates.begin(), updates.end());
+
+        for (std::size_t begin = 0; begin < updates.size();) {
+            std::size_t end{ begin }, alloc{ sizeof(int32_t) };
+            for (; end < updates.size(); ++end) {
+                const std::size_t tile_size{ sizeof(int32_t) * 2 + m_tiles[updates[end].second].GetMemoryUsage(false) };
+                if (end > begin && alloc + tile_size > config::server::tile_update_packet_size)
+                    break;
+                alloc += tile_size;
+            }
+            GamePacket packet{ NET_GAME_PACKET_SEND_TILE_UPDATE_DATA_MULTIPLE, alloc };
+            if (!packet.IsValid()) {
+                begin = end;
+                continue;
+            }
+            packet->m_int_x = -1, packet->m_int_y = -1;
+
+            BinaryWriter buffer{ packet.GetData() };
+            for (std::size_t update = begin; update < end; ++update) {
+                const Tile& tile{ m_tiles[updates[update].second] };
+                buffer.write<int>(tile.GetPosition().m_x);
+                buffer.write<int>(tile.GetPosition().m_y);
+                tile.Pack(buffer, false);
+            }
+            buffer.write<int32_t>(-1);
 
-        this->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(NET_MESSAGE_GAME_PACKET, update_packet, sizeof(GameUpdatePacket) + alloc); });
-        std::free(update_packet);
+            delta_packets.Increase();
+            this->Broadcast([&](const std::shared_ptr<Player>& player) { player->SendPacket(packet); });
+            begin = end;
+        }
+        return true;
     }
 
     void World::SendWho(std::shared_ptr<Player> player, bool show_self) {
@@ -600,9 +806,11 @@ namespace GTServer {
                 player->v_sender.OnSetPos(player->GetNetId(), { (float)(target->GetPosition().m_x), (float)(target->GetPosition().m_y) }, 1);
                 });
             player->SetPosition(target->GetPosition().m_x, target->GetPosition().m_y);
+            this->UpdatePlayerCell(player);
     }
     void World::SendKick(std::shared_ptr<Player> player, bool killed, int delay) {
         player->SetPosition(player->get_respawn_pos().m_x * 32, player->get_respawn_pos().m_y * 32);
+        this->UpdatePlayerCell(player);
         if (!killed) {
             this->Broadcast([&](const std::shared_ptr<Player>& ply) {
                 ply->v_sender.OnKilled(player->GetNetId(), 0);
@@ -718,6 +926,8 @@ namespace GTServer {
                         continue;
                     if (!this->m_objects.erase(obj_id))
                         continue;
+                    this->MarkObjectDirty(obj_id);
+                    this->MarkDirty(tile.GetPosition());
                     GameUpdatePacket packet{ 
                         .m_type = NET_GAME_PACKET_ITEM_CHANGE_OBJECT,
                         .m_object_change_type = OBJECT_CHANGE_TYPE_REMOVE,
@@ -893,6 +1103,9 @@ namespace GTServer {
             y = (this->GetSize().m_y * 32) - 12;
 
         object.m_pos = { x, y };
+        this->MarkDirty(CL_Vec2i{ static_cast<int>(x) / 32, static_cast<int>(y) / 32 });
+        this->MarkObjectDirty(m_object_id);
+        m_journal_meta = true;
         m_objects.insert_or_assign(m_object_id++, std::move(object));
 
         GameUpdatePacket packet{ NET_GAME_PACKET_ITEM_CHANGE_OBJECT };
@@ -932,6 +1145,8 @@ namespace GTServer {
             player->SendPacket(NET_MESSAGE_GAME_PACKET, &packet, sizeof(GameUpdatePacket));
         });
         m_objects[object.first] = object.second;
+        this->MarkObjectDirty(object.first);
+        this->MarkDirty(CL_Vec2i{ static_cast<int>(object.second.m_pos.m_x) / 32, static_cast<int>(object.second.m_pos.m_y) / 32 });
     }
     void World::CollectObject(std::shared_ptr<Player> player, const int32_t& obj_id, const CL_Vec2f& position) {
         auto it = this->m_objects.find(obj_id); 
@@ -1011,6 +1226,8 @@ namespace GTServer {
     
         if (!collected)
             return;
+        this->MarkDirty(tile->GetPosition());
+        this->MarkObjectDirty(obj_id);
         m_objects.erase(it);
 
         GameUpdatePacket packet{ NET_GAME_PACKET_ITEM_CHANGE_OBJECT };
@@ -1023,8 +1240,12 @@ namespace GTServer {
         }); 
     }
     void World::RemoveObject(const int32_t& id) {
-        if (!m_objects.erase(id))
+        auto it = m_objects.find(id);
+        if (it == m_objects.end())
             return;
+        this->MarkDirty(CL_Vec2i{ static_cast<int>(it->second.m_pos.m_x) / 32, static_cast<int>(it->second.m_pos.m_y) / 32 });
+        this->MarkObjectDirty(id);
+        m_objects.erase(it);
         GameUpdatePacket packet{ NET_GAME_PACKET_ITEM_CHANGE_OBJECT };
         packet.m_object_change_type = OBJECT_CHANGE_TYPE_REMOVE;
         packet.m_item_net_id = -1;
@@ -1,14 +1,42 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <functional>
 #include <player/player.h>
 #include <world/tile.h>
 #include <world/world_object.h>
+#include <world/world_snapshot.h>
+#include <utils/mpsc_queue.h>
 #include <utils/timing_clock.h>
 
 namespace GTServer {
     class World {
+    public:
+        static constexpr uint32_t RENDER_CHUNK_SIZE = 8;
+
+        struct MemoryBreakdown {
+            std::size_t m_tiles{ 0 };
+            std::size_t m_extras{ 0 };
+            std::size_t m_objects{ 0 };
+            std::size_t m_players{ 0 };
+            std::size_t m_cached_packets{ 0 };
+
+            [[nodiscard]] std::size_t GetTotal() const { return m_tiles + m_extras + m_objects + m_players + m_cached_packets; }
+        };
+        // tiles and objects changed since the last journal commit, see WorldJournal
+        struct JournalChanges {
+            std::vector<uint32_t> m_tiles{};
+            std::vector<int32_t> m_objects{};
+            bool m_meta{ false };
+
+            [[nodiscard]] bool IsEmpty() const { return m_tiles.empty() && m_objects.empty() && !m_meta; }
+        };
+        // work for this world from outside of its owner, run by WorldPool::ProcessInboxes on the thread that owns the world
+        using Command = std::function<void(const std::shared_ptr<World>&)>;
+
     public:
         explicit World(const std::string& name, const uint32_t& width = 100, const uint32_t& height = 60);
         ~World();
@@ -24,11 +52,17 @@ namespace GTServer {
         bool ClearBans();
         std::vector<std::shared_ptr<Player>> GetPlayers(const bool& invis);
         void Broadcast(const std::function<void(const std::shared_ptr<Player>&)>& func);
+        // forwards a movement packet at full rate to nearby players, players further away get it less often
+        void BroadcastMovement(const std::shared_ptr<Player>& sender, GameUpdatePacket* packet);
+        // files the player under the interest cell of its current position, every movement packet does it as well
+        void UpdatePlayerCell(const std::shared_ptr<Player>& player);
+        // where everyone else is right now, for a peer whose movement updates were dropped while it was congested
+        void SendPositions(const std::shared_ptr<Player>& receiver);
 
         bool IsFlagOn(const eWorldFlags& flag) const;
         void SetFlag(const eWorldFlags& flag);
         void SpawnEvent(const std::string& eventname);
-        void SetFlags(const uint32_t& flags) { m_flags = flags; }
+        void SetFlags(const uint32_t& flags) { m_flags = flags; m_journal_meta = true; }
         void RemoveFlag(const eWorldFlags& flag);
         [[nodiscard]] uint32_t GetFlags() const { return m_flags; }
         
@@ -63,35 +97,66 @@ namespace GTServer {
         [[nodiscard]] uint32_t GetObjectId() const { return m_object_id; }
         void SetObjectId(const uint32_t& object_id) { m_object_id = object_id; }
         [[nodiscard]] int32_t GetOwnerId() const { return m_owner_id; }
-        void SetOwnerId(const int32_t& owner_id) { m_owner_id = owner_id; }
+        void SetOwnerId(const int32_t& owner_id) { m_owner_id = owner_id; m_journal_meta = true; }
         [[nodiscard]] int32_t GetMainLock() const { return m_main_lock; }
-        void SetMainLock(const int32_t& main_lock) { m_main_lock = main_lock; }
+        void SetMainLock(const int32_t& main_lock) { m_main_lock = main_lock; m_journal_meta = true; }
         [[nodiscard]] uint32_t GetWeatherId() const { return m_weather_id; }
-        void SetWeatherId(const uint32_t& weather_id) { m_weather_id = weather_id; }
+        void SetWeatherId(const uint32_t& weather_id) { m_weather_id = weather_id; this->MarkDirty(); }
         [[nodiscard]] uint32_t GetBaseWeatherId() const { return m_base_weather_id; }
-        void SetBaseWeatherId(const uint32_t& weather_id) { m_base_weather_id = weather_id; }
+        void SetBaseWeatherId(const uint32_t& weather_id) { m_base_weather_id = weather_id; m_journal_meta = true; }
 
         std::size_t GetMemoryUsage();
         std::size_t GetTilesMemoryUsage(const bool& to_database);
         std::size_t GetObjectsMemoryUsage();
+        MemoryBreakdown GetMemoryBreakdown();
         std::vector<uint8_t> Pack();
         std::vector<uint8_t> PackTiles(const bool& to_database);
         std::vector<uint8_t> PackObjects(const bool& to_database);
 
+        [[nodiscard]] uint64_t GetContentVersion() const { return m_content_version.load(); }
+        [[nodiscard]] CL_Vec2i GetChunkCount() const;
+        void MarkDirty(const CL_Vec2i& position);
+        void MarkDirty();
+        // game thread only, the returned snapshot can be read from anywhere
+        std::shared_ptr<const WorldSnapshot> CreateSnapshot();
+        void MarkObjectDirty(const int32_t& object_id);
+        JournalChanges TakeJournalChanges();
+
         void SyncPlayerData(std::shared_ptr<Player> player);
+        // updates without a delay are batched and sent once per tick by FlushTileUpdates
         void SendTileUpdate(Tile* tile, const int32_t& delay = 0);
         void SendTileUpdate(std::vector<Tile*> tiles);
+        // returns false if the batch is bigger than the map data, the caller should resend the whole world instead
+        bool FlushTileUpdates();
+        [[nodiscard]] bool HasTileUpdates() const { return !m_tile_updates.empty(); }
         
         void SendWho(std::shared_ptr<Player> player, bool show_self);
         void SendPull(std::shared_ptr<Player> player, std::shared_ptr<Player> target);
         void SendKick(std::shared_ptr<Player> player, bool killed, int delay = -1);
 
+        // safe from any thread
+        void Post(Command command) { m_inbox.Push(std::move(command)); }
+        // owner only
+        bool PopCommand(Command& command) { return m_inbox.Pop(command); }
+        [[nodiscard]] std::size_t GetInboxSize() const { return m_inbox.GetSize(); }
+
         bool EditTile(std::string action, CL_Vec2i center, float radius, ItemInfo* item, bool ignore_areas = false);
     public:
         Tile* GetParentTile(Tile* neighbour);
         bool HasTileAccess(Tile* neighbour, const std::shared_ptr<Player>& player);
         bool IsTileOwner(Tile* neighbour, const std::shared_ptr<Player>& player);
         bool IsTileOwned(Tile* neighbour);
+
+    private:
+        // last movement of a player forwarded to one interest cell
+        struct MovementInterest {
+            steady_clock::time_point m_sent_at{};
+            CL_Vec2f m_position{ 0.f, 0.f };
+            uint32_t m_flags{ 0 };
+            bool m_moving{ false };
+        };
+        [[nodiscard]] CL_Vec2i GetInterestCellCount() const;
+        [[nodiscard]] uint32_t GetInterestCell(const CL_Vec2i& position) const;
     
     public:
         std::unordered_map<int32_t, WorldObject> GetObjectsOnPos(const CL_Vec2f& pos);
@@ -128,5 +193,19 @@ namespace GTServer {
         std::unordered_map<uint32_t, std::shared_ptr<Player>> m_DevBreak;
         std::unordered_map<int32_t, WorldObject> m_objects;
         std::unordered_map<int32_t, time_point> m_banned_players;
+
+        std::atomic<uint64_t> m_content_version;
+        std::mutex m_dirty_mutex;
+        std::vector<std::shared_ptr<const WorldSnapshot::Page>> m_snapshot_pages{};
+        std::shared_ptr<const std::unordered_map<int32_t, WorldObject>> m_snapshot_objects{};
+        std::unordered_set<uint32_t> m_journal_tiles{};
+        std::unordered_set<int32_t> m_journal_objects{};
+        bool m_journal_meta{ false };
+        std::unordered_set<uint32_t> m_tile_updates{};
+        std::unordered_map<uint32_t, std::vector<MovementInterest>> m_movement_interest{};
+        // net ids of the players in each interest cell, and the cell each of them is filed under
+        std::vector<std::vector<uint32_t>> m_cell_players{};
+        std::unordered_map<uint32_t, uint32_t> m_player_cells{};
+        MpscQueue<Command> m_inbox{};
     };
 }
\ No newline at end of file
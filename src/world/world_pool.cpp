@@ -2,6 +2,10 @@
 #include <player/player.h>
 #include <server/server_pool.h>
 #include <database/database.h>
+#include <database/world_journal.h>
+#include <config.h>
+#include <server/metrics.h>
+#include <proton/game_packet.h>
 #include <proton/utils/world_menu.h>
 #include <stdlib.h>
 
@@ -24,12 +28,14 @@ namespace GTServer {
         return ret;
     }
     void WorldPool::SendDefaultOffers(std::shared_ptr<Player> invoker) {
+        // START is only counted here, loading it is left to whoever joins it
+        auto start{ m_worlds.find("START") };
         WorldMenu menu{};
         menu.set_default("START")
             ->add_filter()
             ->set_max_rows(2)
             ->add_heading("Active Worlds")
-            ->add_floater("START", this->GetWorld("START")->GetPlayers(false).size(), 0.7, Color{ 0xFF, 0x0, 0xB1 });
+            ->add_floater("START", start != m_worlds.end() && start->second ? start->second->GetPlayers(false).size() : 0, 0.7, Color{ 0xFF, 0x0, 0xB1 });
 
         std::vector<RandomWorld> worlds{ this->GetRandomWorlds(true, false) };
         if (!worlds.empty()) {
@@ -48,17 +54,24 @@ namespace GTServer {
     }
 
     std::shared_ptr<World> WorldPool::NewWorld(const std::string& name) {
+        static LatencyHistogram& load_latency{ Metrics::Get().GetHistogram("gtserver_world_load_duration_seconds", "Time spent loading or generating a world", "source=\"database\"") };
+        static LatencyHistogram& generate_latency{ Metrics::Get().GetHistogram("gtserver_world_load_duration_seconds", "Time spent loading or generating a world", "source=\"generate\"") };
+
         std::shared_ptr<World> world{ std::make_shared<World>(name, 100, 60) };
         WorldTable* db{ (WorldTable*)Database::GetTable(Database::DATABASE_WORLD_TABLE) };
 
         if (db->is_exist(name)) {
+            ScopedLatency latency{ load_latency };
             if (!db->load(world)) {
                 world.reset();
                 return nullptr;
             }
+            if (const auto& records = WorldJournal::Get().Replay(world); records > 0)
+                fmt::print("WorldJournal -> replayed {} records for {}\n", records, name);
             m_worlds.insert_or_assign(name, std::move(world));
             return m_worlds[name];
         }
+        ScopedLatency latency{ generate_latency };
         world->Generate(WORLD_TYPE_NORMAL);
         world->SetID(db->insert(world));
         if (world->GetID() == 0) {
@@ -73,6 +86,16 @@ namespace GTServer {
         m_worlds[name].reset();
         m_worlds.erase(name);
     }
+    void WorldPool::DiscardWorld(const std::string& name) {
+        auto it{ m_worlds.find(name) };
+        if (it == m_worlds.end())
+            return;
+        if (it->second) {
+            it->second->TakeJournalChanges();
+            WorldJournal::Get().Discard(it->second->GetID());
+        }
+        m_worlds.erase(it);
+    }
     std::shared_ptr<World> WorldPool::GetWorld(const std::string& name) {
         if (name.empty() || name == std::string{ "EXIT" })
             return nullptr;
@@ -83,6 +106,121 @@ namespace GTServer {
         }
         return this->NewWorld(name);
     }
+    bool WorldPool::SaveWorld(std::shared_ptr<World> world) {
+        static LatencyHistogram& save_latency{ Metrics::Get().GetHistogram("gtserver_world_save_duration_seconds", "Time spent saving a world") };
+        ScopedLatency latency{ save_latency };
+        WorldTable* db{ (WorldTable*)Database::GetTable(Database::DATABASE_WORLD_TABLE) };
+        // everything up to this save has to be durable in the journal first, so a crash during
+        // the tile file write can still be recovered from the old file + journal
+        WorldJournal::Get().Commit(world);
+        const bool journaled{ WorldJournal::Get().Flush(world->GetID()) };
+        if (!journaled)
+            fmt::print("WorldJournal::Flush, Failed to flush {}\n", world->GetName());
+        if (!db->save(world->CreateSnapshot())) {
+            fmt::print("WorldTable::save, Failed to save {}\n", world->GetName());
+            return false;
+        }
+        // the journal may still hold records that aren't on disk, it's only dropped once it was complete
+        if (journaled)
+            WorldJournal::Get().Checkpoint(world->GetID());
+        return true;
+    }
+    void WorldPool::CommitJournal() {
+        for (auto& [name, world] : m_worlds) {
+            if (!world)
+                continue;
+            WorldJournal::Get().Commit(world);
+            if (WorldJournal::Get().GetSize(world->GetID()) >= config::journal::checkpoint_size)
+                this->SaveWorld(world);
+        }
+    }
+
+    void WorldPool::ProcessInboxes() {
+        // commands may load other worlds, so the map can't be walked while they run
+        std::vector<std::shared_ptr<World>> worlds{};
+        for (auto& [name, world] : m_worlds) {
+            if (world && world->GetInboxSize() > 0)
+                worlds.push_back(world);
+        }
+        for (auto& world : worlds) {
+            World::Command command{};
+            for (std::size_t i = 0; i < config::server::inbox_batch && world->PopCommand(command); ++i)
+                command(world);
+        }
+    }
+    void WorldPool::MovePlayer(ServerPool* pool, std::shared_ptr<Player> player, std::shared_ptr<World> from, std::shared_ptr<World> to, World::Command on_join) {
+        if (!player || !to)
+            return;
+        // `to` may be discarded before `from` gets its turn, so it's looked up by name again when the player leaves.
+        // a player that logged off or was replaced by a newer session in the meantime is left alone
+        auto join{ [this, pool, player, name = to->GetName(), on_join = std::move(on_join)]() mutable {
+            if (pool->GetSession(player->GetUserId()) != player)
+                return;
+            auto it{ m_worlds.find(name) };
+            if (it == m_worlds.end() || !it->second) {
+                this->SendDefaultOffers(player);
+                return;
+            }
+            it->second->Post([this, pool, player, on_join = std::move(on_join)](const std::shared_ptr<World>& world) {
+                if (pool->GetSession(player->GetUserId()) != player)
+                    return;
+                this->OnPlayerJoin(pool, world, player, world->GetTilePos(ITEMTYPE_MAIN_DOOR));
+                this->OnPlayerSyncing(world, player);
+                if (on_join)
+                    on_join(world);
+            });
+        } };
+        if (!from) {
+            join();
+            return;
+        }
+        from->Post([this, player, join = std::move(join)](const std::shared_ptr<World>& world) mutable {
+            if (world->HasPlayer(player)) {
+                world->RemovePlayer(player);
+                this->OnPlayerLeave(world, player, false);
+            }
+            join();
+        });
+    }
+
+    void WorldPool::FlushTileUpdates() {
+        static Counter& resends{ Metrics::Get().GetCounter("gtserver_world_resends_total", "Tile update batches replaced by a full map data resend") };
+        for (auto& [name, world] : m_worlds) {
+            if (!world || !world->HasTileUpdates())
+                continue;
+            if (world->FlushTileUpdates())
+                continue;
+            resends.Increase();
+            this->ResendWorld(world);
+        }
+    }
+    void WorldPool::ResendWorld(std::shared_ptr<World> world) {
+        const auto snapshot{ world->CreateSnapshot() };
+        GamePacket packet{ NET_GAME_PACKET_SEND_MAP_DATA, snapshot->GetMemoryUsage() };
+        if (!packet.IsValid())
+            return;
+        packet->m_net_id = -1;
+        BinaryWriter buffer{ packet.GetData() };
+        snapshot->Pack(buffer);
+
+        // the client drops every avatar when it gets map data, spawn them again for the receiver only
+        const auto& players{ world->GetPlayers(true) };
+        for (auto& player : players) {
+            player->SendPacket(packet);
+            player->v_sender.OnSpawn(player->GetSpawnData(true));
+            player->v_sender.OnSetClothing(player->GetClothes(), player->GetSkinColor(), false, player->GetNetId());
+            player->v_sender.OnNameChanged(player->GetNetId(), player->GetDisplayName(world));
+            player->SendCharacterState(player);
+            for (auto& ply : players) {
+                if (ply == player)
+                    continue;
+                player->v_sender.OnSpawn(ply->GetSpawnData());
+                player->v_sender.OnSetClothing(ply->GetClothes(), ply->GetSkinColor(), false, ply->GetNetId());
+                player->v_sender.OnNameChanged(ply->GetNetId(), ply->GetDisplayName(world));
+                player->SendCharacterState(ply);
+            }
+        }
+    }
 
     void WorldPool::OnPlayerJoin(ServerPool* pool, std::shared_ptr<World> world, std::shared_ptr<Player> player, const CL_Vec2i& pos) {
         if (world->IsFlagOn(WORLDFLAG_NUKED) && player->GetRole() < PLAYER_ROLE_MODERATOR) {
@@ -111,20 +249,18 @@ namespace GTServer {
         player->SetWorld(world->GetName());
         player->SetNetId(world->AddPlayer(player));
         player->SetPosition(pos.m_x * 32, pos.m_y * 32);
+        world->UpdatePlayerCell(player);
         player->set_respawn_pos({ pos.m_x, pos.m_y });
         player->m_inventory.Send();
 
-        auto data{ world->Pack() };
-        GameUpdatePacket* update_packet{ static_cast<GameUpdatePacket*>(std::malloc(sizeof(GameUpdatePacket) + data.size())) };
-        update_packet->m_type = NET_GAME_PACKET_SEND_MAP_DATA;
-        update_packet->m_net_id = -1;
-        update_packet->m_flags |= NET_GAME_PACKET_FLAGS_EXTENDED;
-        update_packet->m_data_size = static_cast<uint32_t>(data.size());
-        std::memcpy(&update_packet->m_data, data.data(), data.size());
-        player->SendPacket(NET_MESSAGE_GAME_PACKET, update_packet, sizeof(GameUpdatePacket) + data.size());
-        
-        data.clear();
-        std::free(update_packet);
+        const auto snapshot{ world->CreateSnapshot() };
+        GamePacket packet{ NET_GAME_PACKET_SEND_MAP_DATA, snapshot->GetMemoryUsage() };
+        if (packet.IsValid()) {
+            packet->m_net_id = -1;
+            BinaryWriter buffer{ packet.GetData() };
+            snapshot->Pack(buffer);
+            player->SendPacket(packet);
+        }
 
         std::vector<std::string> active_bits;
         if (world->IsFlagOn(WORLDFLAG_PUNCH_JAMMER))
@@ -227,11 +363,9 @@ namespace GTServer {
         }
 
         world->RemovePlayer(player);
-        if (world->GetPlayers(false).size() < 1) {
-            WorldTable* db{ (WorldTable*)Database::GetTable(Database::DATABASE_WORLD_TABLE) };
-            if (!db->save(world))
-                fmt::print("WorldTable::save, Failed to save {}\n", world->GetName());
-        }
+        // a world that was discarded belongs to another worker, saving it would overwrite their copy
+        if (auto it = m_worlds.find(world->GetName()); it != m_worlds.end() && it->second == world && world->GetPlayers(false).size() < 1)
+            this->SaveWorld(world);
         if (send_offers)
             this->SendDefaultOffers(player);
     }
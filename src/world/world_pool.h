@@ -26,7 +26,20 @@ namespace GTServer {
 
         std::shared_ptr<World> NewWorld(const std::string& name);
         void RemoveWorld(const std::string& name);
+        // drops the world without saving it or touching its journal, for a copy another worker owns
+        void DiscardWorld(const std::string& name);
         std::shared_ptr<World> GetWorld(const std::string& name);
+        bool SaveWorld(std::shared_ptr<World> world);
+        // hands pending tile changes to the journal, worlds with a large journal are checkpointed
+        void CommitJournal();
+        // sends the tile updates batched during this tick, called by the service loop
+        void FlushTileUpdates();
+        // sends the full map data again to everyone in the world, for edits too large to send as a delta
+        void ResendWorld(std::shared_ptr<World> world);
+        // runs the commands posted to each world, called by the service loop. Commands for a world that gets unloaded are dropped
+        void ProcessInboxes();
+        // leaves `from` and joins `to` as commands of the two worlds, so neither is touched outside of its own turn
+        void MovePlayer(ServerPool* pool, std::shared_ptr<Player> player, std::shared_ptr<World> from, std::shared_ptr<World> to, World::Command on_join = {});
 
         void OnPlayerJoin(ServerPool* pool, std::shared_ptr<World> world, std::shared_ptr<Player> player, const CL_Vec2i& pos);
         void OnPlayerLeave(std::shared_ptr<World> world, std::shared_ptr<Player> player, const bool& send_offers);
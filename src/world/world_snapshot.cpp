@@ -0,0 +1,113 @@
+#include <world/world_snapshot.h>
+#include <utils/binary_writer.h>
+#include <world/world.h>
+
+namespace GTServer {
+    const Tile* WorldSnapshot::GetTile(const int& x, const int& y) const {
+        if (x < 0 || y < 0 || x >= static_cast<int>(m_width) || y >= static_cast<int>(m_height))
+            return nullptr;
+        return this->GetTile(static_cast<std::size_t>(y) * m_width + x);
+    }
+    const Tile* WorldSnapshot::GetTile(const std::size_t& index) const {
+        if (index >= m_tile_count)
+            return nullptr;
+        const uint32_t x{ static_cast<uint32_t>(index % m_width) }, y{ static_cast<uint32_t>(index / m_width) };
+        const auto& page{ m_pages[(y / World::RENDER_CHUNK_SIZE) * m_chunks.m_x + (x / World::RENDER_CHUNK_SIZE)] };
+        const std::size_t offset{ (y % World::RENDER_CHUNK_SIZE) * page->m_width + (x % World::RENDER_CHUNK_SIZE) };
+        if (offset >= page->m_tiles.size())
+            return nullptr;
+        return &page->m_tiles[offset];
+    }
+
+    std::vector<bool> WorldSnapshot::GetChangedChunks(const WorldSnapshot& previous) const {
+        std::vector<bool> ret{};
+        if (previous.m_id != m_id || previous.m_width != m_width || previous.m_height != m_height || previous.m_pages.size() != m_pages.size())
+            return ret;
+        ret.resize(m_pages.size(), false);
+        for (std::size_t chunk = 0; chunk < m_pages.size(); ++chunk)
+            ret[chunk] = m_pages[chunk] != previous.m_pages[chunk];
+        return ret;
+    }
+
+    std::size_t WorldSnapshot::GetMemoryUsage() const {
+        std::size_t size{ sizeof(uint16_t) }; // version
+        size += sizeof(uint32_t); // flags
+        size += sizeof(uint16_t); // name length
+        size += m_name.length(); // name
+        size += sizeof(uint32_t); // width
+        size += sizeof(uint32_t); // height
+        size += this->GetTilesMemoryUsage(false); // tiles
+        size += this->GetObjectsMemoryUsage(); // objects
+        size += sizeof(uint32_t); // weather
+        size += sizeof(uint32_t); // base weather
+        return size;
+    }
+    std::size_t WorldSnapshot::GetTilesMemoryUsage(const bool& to_database) const {
+        std::size_t size{};
+        size += sizeof(uint32_t); // tiles count
+        for (std::size_t index = 0; index < m_tile_count; ++index)
+            size += this->GetTile(index)->GetMemoryUsage(to_database);
+        return size;
+    }
+    std::size_t WorldSnapshot::GetObjectsMemoryUsage() const {
+        std::size_t size{
+            sizeof(uint32_t) +  // object count
+            sizeof(uint32_t)    // object last id
+        };
+        size += (m_objects->size() * (sizeof(uint32_t) + sizeof(WorldObject)));
+        return size;
+    }
+
+    std::vector<uint8_t> WorldSnapshot::Pack() const {
+        std::vector<uint8_t> ret{};
+        ret.resize(this->GetMemoryUsage());
+
+        BinaryWriter buffer{ ret.data() };
+        this->Pack(buffer);
+        return ret;
+    }
+    std::vector<uint8_t> WorldSnapshot::PackTiles(const bool& to_database) const {
+        std::vector<uint8_t> ret{};
+        ret.resize(this->GetTilesMemoryUsage(to_database));
+
+        BinaryWriter buffer{ ret.data() };
+        this->PackTiles(buffer, to_database);
+        return ret;
+    }
+    std::vector<uint8_t> WorldSnapshot::PackObjects(const bool& to_database) const {
+        std::vector<uint8_t> ret{};
+        ret.resize(this->GetObjectsMemoryUsage());
+
+        BinaryWriter buffer{ ret.data() };
+        this->PackObjects(buffer, to_database);
+        return ret;
+    }
+
+    void WorldSnapshot::Pack(BinaryWriter& buffer) const {
+        buffer.write<uint16_t>(m_version);
+        buffer.write<uint32_t>(m_flags);
+        buffer.write(m_name, sizeof(uint16_t));
+        buffer.write<uint32_t>(m_width);
+        buffer.write<uint32_t>(m_height);
+        this->PackTiles(buffer, false);
+        this->PackObjects(buffer, false);
+        buffer.write<uint32_t>(m_base_weather_id);
+        buffer.write<uint32_t>(m_weather_id);
+    }
+    void WorldSnapshot::PackTiles(BinaryWriter& buffer, const bool& to_database) const {
+        buffer.write<uint32_t>(static_cast<uint32_t>(m_tile_count));
+        for (std::size_t index = 0; index < m_tile_count; ++index)
+            this->GetTile(index)->Pack(buffer, to_database);
+    }
+    void WorldSnapshot::PackObjects(BinaryWriter& buffer, const bool& to_database) const {
+        buffer.write<uint32_t>(static_cast<uint32_t>(m_objects->size()));
+        buffer.write<uint32_t>(m_object_id - (to_database ? 0 : 1));
+        for (const auto& [id, object] : *m_objects) {
+            buffer.write<uint16_t>(object.m_item_id);
+            buffer.write<CL_Vec2f>(object.m_pos);
+            buffer.write<uint8_t>(object.m_item_amount);
+            buffer.write<uint8_t>(object.m_flags);
+            buffer.write<uint32_t>(id);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <world/tile.h>
+#include <world/world_object.h>
+
+namespace GTServer {
+    class World;
+    // immutable point-in-time view of a world, safe to read from any thread.
+    // tiles live in refcounted pages of RENDER_CHUNK_SIZE x RENDER_CHUNK_SIZE, a page is only copied again
+    // when one of its tiles has been marked dirty, so consecutive snapshots share all untouched pages.
+    class WorldSnapshot {
+    public:
+        struct Page {
+            uint32_t m_width{ 0 };
+            std::vector<Tile> m_tiles{};
+        };
+
+    public:
+        WorldSnapshot() = default;
+        ~WorldSnapshot() = default;
+
+        [[nodiscard]] int32_t GetID() const { return m_id; }
+        [[nodiscard]] uint16_t GetVersion() const { return m_version; }
+        [[nodiscard]] const std::string& GetName() const { return m_name; }
+        [[nodiscard]] uint32_t GetFlags() const { return m_flags; }
+        [[nodiscard]] CL_Vec2i GetSize() const { return CL_Vec2i{ m_width, m_height }; }
+        [[nodiscard]] CL_Vec2i GetChunkCount() const { return m_chunks; }
+        [[nodiscard]] uint64_t GetContentVersion() const { return m_content_version; }
+
+        [[nodiscard]] std::size_t GetTileCount() const { return m_tile_count; }
+        const Tile* GetTile(const int& x, const int& y) const;
+        const Tile* GetTile(const std::size_t& index) const;
+
+        [[nodiscard]] const std::unordered_map<int32_t, WorldObject>& GetObjects() const { return *m_objects; }
+        [[nodiscard]] uint32_t GetObjectId() const { return m_object_id; }
+
+        [[nodiscard]] bool IsOwned() const { return m_owner_id != -1; }
+        [[nodiscard]] int32_t GetOwnerId() const { return m_owner_id; }
+        [[nodiscard]] int32_t GetMainLock() const { return m_main_lock; }
+        [[nodiscard]] uint32_t GetWeatherId() const { return m_weather_id; }
+        [[nodiscard]] uint32_t GetBaseWeatherId() const { return m_base_weather_id; }
+
+        // chunks whose page differs from the one in previous, empty if the two can't be compared
+        std::vector<bool> GetChangedChunks(const WorldSnapshot& previous) const;
+
+        std::size_t GetMemoryUsage() const;
+        std::size_t GetTilesMemoryUsage(const bool& to_database) const;
+        std::size_t GetObjectsMemoryUsage() const;
+        std::vector<uint8_t> Pack() const;
+        std::vector<uint8_t> PackTiles(const bool& to_database) const;
+        std::vector<uint8_t> PackObjects(const bool& to_database) const;
+        // in place versions, the buffer needs room for the matching GetMemoryUsage()
+        void Pack(BinaryWriter& buffer) const;
+        void PackTiles(BinaryWriter& buffer, const bool& to_database) const;
+        void PackObjects(BinaryWriter& buffer, const bool& to_database) const;
+
+    private:
+        friend class World;
+
+        int32_t m_id{ -1 };
+        uint16_t m_version{ 0 };
+        uint32_t m_flags{ 0 };
+        std::string m_name{};
+        uint32_t m_width{ 0 };
+        uint32_t m_height{ 0 };
+        CL_Vec2i m_chunks{ 0, 0 };
+        uint64_t m_content_version{ 0 };
+
+        std::size_t m_tile_count{ 0 };
+        std::vector<std::shared_ptr<const Page>> m_pages{};
+        std::shared_ptr<const std::unordered_map<int32_t, WorldObject>> m_objects{};
+        uint32_t m_object_id{ 1 };
+
+        int32_t m_owner_id{ -1 };
+        int32_t m_main_lock{ -1 };
+        uint32_t m_weather_id{ 0 };
+        uint32_t m_base_weather_id{ 0 };
+    };
+}